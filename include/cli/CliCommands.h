@@ -0,0 +1,71 @@
+#ifndef CLICOMMANDS_H
+#define CLICOMMANDS_H
+
+/**
+ * @file CliCommands.h
+ * @brief Commands of the command-line tool (ppp-cli)
+ *
+ * Every command works on a list of files, and handles each file on its own straight from its raw data
+ * (see "FileLoader::findSaveSlotGroups()" and "FileLoader::decodeSaves()"), without going through
+ * the FileManager's opened file nor the SaveManager. This means several files can be handled at the same time,
+ * so every command spreads its files over a thread pool with QtConcurrent.
+ *
+ * The commands that only read files (validate, dump, search and index) read them through the FileIngestor instead,
+ * and decode each one as soon as it has been read. The query command doesn't read any file, only a save index (see SaveIndex.h).
+ *
+ * The results are printed in the same order as the input files.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileIngestor.h"
+#include "include/file/FileManager.h"
+#include "include/save/SaveQuery.h"
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace CliCommands {
+    /**
+     * Exit codes of the tool.
+     */
+    enum eExitCode {
+        EXIT_CODE_OK = 0,           // Every file was handled
+        EXIT_CODE_FAILED_FILES,     // At least one file was invalid, or couldn't be read or written
+        EXIT_CODE_USAGE             // The command line wasn't valid
+    };
+
+    /**
+     * Settings shared by every command. Each command only reads the ones it needs.
+     */
+    struct Options {
+        QStringList inputFiles;                         // See "collectInputFiles()"
+        QList<bool> isFromDirectory;                    // validate, dump, search, index: Whether each input file was found in a directory without checking its format (see "collectInputFiles()")
+        int ioBackend = FileIngestor::BACKEND_AUTO;     // validate, dump, search, index: How the files are read (see "FileIngestor::Options")
+        QString outputDirectory;                        // convert: Where the converted files are written. Empty to write them next to each input file
+        int outputFormat = FileManager::FORMAT_NOTE;    // convert: See "FileConverter::Job"
+        short outputRegion = -1;                        // convert: See "FileConverter::Job"
+        bool packNotes = false;                         // convert: Whether every input file is packed into the same Controller Paks, instead of one per input file
+        bool json = false;                              // dump, search, query: Whether to print JSON instead of text
+        SaveQuery query;                                // search, query: Saves to look for
+        QString indexPath;                              // index, query: Save index file (see SaveIndex.h)
+        bool dryRun = false;                            // checksum-fix: Whether to only report the invalid checksums, without writing anything
+        QThreadPool* threadPool = QThreadPool::globalInstance();
+    };
+
+    QStringList collectInputFiles(const QStringList& paths, QThreadPool* threadPool = QThreadPool::globalInstance(),
+                                  QList<bool>* isFromDirectory = nullptr);
+    int parseFormat(const QString& name);
+    short parseRegion(const QString& name);
+
+    int validate(const Options& options);
+    int convert(const Options& options);
+    int dump(const Options& options);
+    int checksumFix(const Options& options);
+    int search(const Options& options);
+    int buildIndex(const Options& options);
+    int queryIndex(const Options& options);
+}
+
+#endif // CLICOMMANDS_H
@@ -13,6 +13,7 @@
 #include <QJsonObject>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <functional>
 
 /**
  * @class Database
@@ -30,6 +31,9 @@ class Database: public QObject {
     int port = 0;               /**< Database connection port */
     QString databaseName = "";  /**< Name of the database where the saves will be stored at */
 
+    protected:
+        QString lastError = "";     /**< Details of the last operation that failed (see "getLastError()") */
+
     /// @note Wee need to explicitly declare the constructor and virtual destructor as "public"
     /// since "QObject" (needed for the "connect" function to work with this struct)
     /// has a private destructor, which throws errors
@@ -40,6 +44,12 @@ class Database: public QObject {
             int region = SaveData::USA; /**< Save region */
         };
 
+        /**
+         * Asked when creating an entry whose document ID already exists in the database.
+         * Returns true if the existing entry should be overwritten.
+         */
+        typedef std::function<bool(const QString& id)> OverwriteConfirmation;
+
         // Constructors and destructor
         Database() {}
         virtual ~Database() {}
@@ -51,6 +61,7 @@ class Database: public QObject {
         int getPort() const { return port; }
         void setDatabaseName(const QString& databaseName_) { databaseName = databaseName_; }
         QString getDatabaseName() const { return databaseName; }
+        QString getLastError() const { return lastError; }
         virtual QString getDocumentRevision(const QString& documentId) = 0;
         virtual void getEntry(const QString& id, std::vector<SaveSlot>& array) = 0;
         virtual std::vector<Database::SaveBasicInfo> getAllEntries() = 0;
@@ -60,8 +71,9 @@ class Database: public QObject {
         virtual void disconnectFromDatabase() = 0;
 
         // CRUD-related functions
-        virtual void createEntry(const QString& id, const std::vector<SaveSlot>& saveSlot, const QString& rev) = 0;
-        virtual void deleteEntry(const QString& id, const QString& rev) = 0;
+        virtual int createEntry(const QString& id, const std::vector<SaveSlot>& saveSlot, const QString& rev,
+                                const OverwriteConfirmation& confirmOverwrite = nullptr) = 0;
+        virtual bool deleteEntry(const QString& id, const QString& rev) = 0;
     private:
         virtual void parseGetAllEntriesResponse(const QByteArray& data, std::vector<Database::SaveBasicInfo>& entries) = 0;
 
@@ -92,8 +104,9 @@ class DatabaseCouch: public Database {
         std::vector<Database::SaveBasicInfo> getAllEntries();
 
         // CRUD-related functions
-        void createEntry(const QString& id, const std::vector<SaveSlot>& saveSlot, const QString& rev);
-        void deleteEntry(const QString& id, const QString& rev);
+        int createEntry(const QString& id, const std::vector<SaveSlot>& saveSlot, const QString& rev,
+                        const OverwriteConfirmation& confirmOverwrite = nullptr);
+        bool deleteEntry(const QString& id, const QString& rev);
     private:
         void parseGetAllEntriesResponse(const QByteArray& data, std::vector<Database::SaveBasicInfo>& entries);
 
@@ -104,7 +117,7 @@ class DatabaseCouch: public Database {
     private:
         bool entryAlreadyExistsGivenRequest(const QNetworkRequest& request);
         void createAuthorizationHeader(QNetworkRequest& request);
-        void getDatabaseRequestReply(QNetworkReply* reply);
+        bool getDatabaseRequestReply(QNetworkReply* reply);
 
     private:
         // SaveData<->JSON parsing functions
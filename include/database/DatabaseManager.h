@@ -108,8 +108,10 @@ class DatabaseManager {
         void assignDatabase();
         void getEntry(const QString& id, std::vector<SaveSlot>& array);
         std::vector<Database::SaveBasicInfo> getAllEntries();
-        void createEntry(const QString& id, const std::vector<SaveSlot>& entry, const QString& rev);
-        void deleteEntry(const QString& id, const QString& rev);
+        int createEntry(const QString& id, const std::vector<SaveSlot>& entry, const QString& rev,
+                        const Database::OverwriteConfirmation& confirmOverwrite = nullptr);
+        bool deleteEntry(const QString& id, const QString& rev);
+        QString getLastError() const;
         bool entryAlreadyExists(const QString& id);
         QString getDocumentRevision(const QString& documentId);
 
@@ -0,0 +1,79 @@
+#ifndef BYTESWAP_H
+#define BYTESWAP_H
+
+/**
+ * @file ByteSwap.h
+ * @brief Bulk byte-order conversion kernels
+ *
+ * Save data is stored in big endian. Instead of swapping every field on its own, whole blocks of raw data
+ * are converted in a single pass using a byte shuffle mask. On x86 CPUs the shuffle is done with SSSE3 / AVX2
+ * ("pshufb"), chosen at runtime, with a portable scalar fallback for everything else.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include <QtEndian>
+#include <QtGlobal>
+#include <cstddef>  // std::size_t
+#include <cstring>  // memmove
+
+namespace ByteSwap {
+    /**
+     * Number of bytes each shuffle mask entry group covers. Mask entries are relative to the start of their block,
+     * so no element being swapped may cross a block boundary.
+     */
+    constexpr unsigned int BLOCK_SIZE = 16;
+
+    /**
+     * Shuffle mask entry that produces a zero byte instead of copying one (the highest bit set, like "pshufb").
+     */
+    constexpr quint8 ZERO_BYTE = 0x80;
+
+    /**
+     * @brief Number of entries a shuffle mask needs in order to convert "dataSize" bytes.
+     */
+    constexpr unsigned int getMaskSize(const unsigned int dataSize) {
+        return (dataSize + BLOCK_SIZE - 1) & ~(BLOCK_SIZE - 1);
+    }
+
+    /**
+     * @brief Rearranges "size" bytes from "src" into "dst" so that dst[i] = src[blockStart(i) + mask[i]],
+     * or 0 if mask[i] is "ZERO_BYTE".
+     *
+     * "src" and "dst" may be the same buffer.
+     *
+     * @note "mask" must have at least "getMaskSize(size)" entries.
+     */
+    void shuffle(const char* src, char* dst, std::size_t size, const quint8* mask);
+
+    /**
+     * @brief Swaps the endianness of every complete 32-bit word in "data", in place.
+     * Trailing bytes that don't make up a whole word are left untouched.
+     */
+    void swap32(char* data, std::size_t size);
+
+    /**
+     * @brief Name of the kernel chosen for this CPU ("avx2", "ssse3" or "scalar").
+     */
+    const char* getKernelName();
+
+    /**
+     * @brief Converts big endian data described by "mask" to the host's byte order, or the other way around.
+     *
+     * Swapping the bytes of every element is its own inverse, so the same mask is used in both directions.
+     * On big endian hosts this is just a copy.
+     */
+    inline void convertBigEndian(const char* src, char* dst, const std::size_t size, const quint8* mask) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        shuffle(src, dst, size, mask);
+#else
+        Q_UNUSED(mask);
+
+        if (src != dst) {
+            memmove(dst, src, size);
+        }
+#endif
+    }
+}
+
+#endif // BYTESWAP_H
@@ -0,0 +1,149 @@
+#ifndef CONTROLLERPAKIMAGE_H
+#define CONTROLLERPAKIMAGE_H
+
+/**
+ * @file ControllerPakImage.h
+ * @brief Model of the file system of a Controller Pak
+ *
+ * The first 5 pages of a Controller Pak (its system area) describe the whole file system: the ID block (page 0),
+ * the index table (page 1, with a backup in page 2) and the note table (pages 3 and 4).
+ * All of it is decoded from a single in-memory copy of the system area, so no seeking is needed.
+ *
+ * Notes aren't necessarily stored in consecutive pages: each entry in the index table points to the next page of the note,
+ * so the data of each note is accessed through a "PageChain" that follows those links.
+ *
+ * @note source: https://github.com/bryc/mpkedit/wiki/Controller-Pak-file-system
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QtGlobal>
+#include <array>
+#include <vector>
+
+class ControllerPakImage {
+    public:
+        /// @note All of these offsets are relative to the start of the Controller Pak data.
+        static constexpr unsigned int PAGE_SIZE = 0x100;                /**< Size of each page */
+        static constexpr unsigned int NUM_PAGES = 128;                  /**< Total number of pages in a (32 KB) Controller Pak */
+        static constexpr unsigned int FIRST_DATA_PAGE = 5;              /**< Pages before this one belong to the system area */
+        static constexpr unsigned int SYSTEM_AREA_SIZE = PAGE_SIZE * FIRST_DATA_PAGE;
+        static constexpr unsigned int ID_BLOCK_SIZE = 0x20;
+        static constexpr unsigned int ID_BLOCK_OFFSETS[] = {0x20, 0x60, 0x80, 0xC0};    /**< The ID block, followed by its backups */
+        static constexpr unsigned int INDEX_TABLE_OFFSET = 0x100;
+        static constexpr unsigned int NOTE_TABLE_OFFSET = 0x300;
+        static constexpr unsigned int NOTE_TABLE_ENTRY_SIZE = 0x20;
+        static constexpr unsigned int NOTE_TABLE_NUM_ENTRIES = 16;
+
+        // Special values of the index table entries
+        static constexpr quint16 INDEX_END_OF_NOTE = 0x0001;            /**< Last page of a note */
+        static constexpr quint16 INDEX_FREE_PAGE = 0x0003;              /**< Page not used by any note */
+
+        /**
+         * Decoded ID block.
+         */
+        struct IdBlock {
+            bool isValid = false;           /**< A copy of the ID block with valid checksums was found */
+            unsigned int offset = 0;        /**< Offset of the copy that was used */
+            quint16 checksum = 0;
+            unsigned char numBanks = 0;     /**< Number of 32 KB banks */
+        };
+
+        /**
+         * Decoded entry of the note table, along with the pages the note is stored in.
+         */
+        struct NoteEntry {
+            QByteArray gameId;                  /**< Game code + publisher code (i.e. "ND3EA4") */
+            QByteArray extension;
+            QByteArray name;
+            unsigned int startPage = 0;
+            unsigned char status = 0;
+            std::vector<unsigned int> pages;    /**< Every page of the note, in order, following the index table */
+            bool isChainValid = false;          /**< The chain of pages ends properly, without going out of bounds nor looping */
+
+            bool isUsed() const {
+                return startPage >= FIRST_DATA_PAGE && startPage < NUM_PAGES;
+            }
+        };
+
+        /**
+         * @brief Zero-copy view over the data of a note, page by page.
+         *
+         * @note The view doesn't own anything: both the Controller Pak data and the image it came from must outlive it.
+         */
+        class PageChain {
+            public:
+                /**
+                 * Bytes of the note stored in consecutive pages.
+                 */
+                struct Run {
+                    unsigned int noteOffset = 0;    /**< Offset relative to the start of the note */
+                    unsigned int pakOffset = 0;     /**< Offset relative to the start of the Controller Pak data */
+                    unsigned int size = 0;
+                };
+
+            private:
+                QByteArrayView pakData;                             /**< The whole Controller Pak data */
+                const std::vector<unsigned int>* pages = nullptr;   /**< Pages of the note (owned by the image) */
+
+            public:
+                PageChain() {}
+                PageChain(QByteArrayView pakData_, const std::vector<unsigned int>& pages_) : pakData(pakData_), pages(&pages_) {}
+
+                inline unsigned int getNumPages() const {
+                    return (pages != nullptr) ? pages->size() : 0;
+                }
+
+                /**
+                 * @brief Offset of the given page of the note, relative to the start of the Controller Pak data.
+                 */
+                inline unsigned int getPageOffset(const unsigned int index) const {
+                    return (*pages)[index] * PAGE_SIZE;
+                }
+
+                QByteArrayView getPage(const unsigned int index) const;
+                bool isContiguous(const unsigned int firstPage, const unsigned int numPages) const;
+                QByteArrayView sliced(const unsigned int offset, const unsigned int size) const;
+                unsigned int copyTo(const unsigned int offset, const unsigned int size, char* dst) const;
+                std::vector<Run> getRuns(const unsigned int size) const;
+        };
+
+        // Main decoding functions
+        int parse(QByteArrayView systemArea);
+        void clear();
+        static bool isIdBlockValid(QByteArrayView idBlock);
+        static bool isCastlevaniaGameId(QByteArrayView gameId);
+
+        // Getters
+        inline const IdBlock& getIdBlock() const {
+            return idBlock;
+        }
+
+        inline quint16 getIndexTableEntry(const unsigned int page) const {
+            return indexTable[page];
+        }
+
+        inline const NoteEntry& getNote(const unsigned int index) const {
+            return notes[index];
+        }
+
+        unsigned int getNumFreePages() const;
+
+        /**
+         * @brief View over the data of the given note, where "pakData" is the whole Controller Pak data.
+         */
+        inline PageChain getPageChain(QByteArrayView pakData, const unsigned int index) const {
+            return PageChain(pakData, notes[index].pages);
+        }
+
+    private:
+        std::vector<unsigned int> followPageChain(const unsigned int startPage, bool& isChainValid) const;
+
+        IdBlock idBlock;
+        std::array<quint16, NUM_PAGES> indexTable {};              /**< Next page of each page (see "INDEX_END_OF_NOTE" and "INDEX_FREE_PAGE") */
+        std::array<NoteEntry, NOTE_TABLE_NUM_ENTRIES> notes;
+};
+
+#endif // CONTROLLERPAKIMAGE_H
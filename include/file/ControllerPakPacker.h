@@ -0,0 +1,67 @@
+#ifndef CONTROLLERPAKPACKER_H
+#define CONTROLLERPAKPACKER_H
+
+/**
+ * @file ControllerPakPacker.h
+ * @brief Builds Controller Pak images out of individual notes
+ *
+ * Notes are added one after another into a freshly formatted Controller Pak. Pages are handed out in order,
+ * starting at the first data page, so every note is stored in consecutive pages and the free space always stays
+ * in a single block at the end of the pak. Once a note doesn't fit anymore, the pak is finished and the packer is reset.
+ *
+ * @note source: https://github.com/bryc/mpkedit/wiki/Controller-Pak-file-system
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/ControllerPakImage.h"
+#include <QByteArray>
+#include <QByteArrayView>
+
+class ControllerPakPacker {
+    public:
+        static constexpr unsigned int PAK_SIZE = ControllerPakImage::PAGE_SIZE * ControllerPakImage::NUM_PAGES;
+        static constexpr unsigned int MAX_NOTE_PAGES = ControllerPakImage::NUM_PAGES - ControllerPakImage::FIRST_DATA_PAGE;
+        static constexpr unsigned int INDEX_TABLE_BACKUP_OFFSET = 0x200;
+
+        /// @note .note files store their note table entry right after the magic and the timestamps, and the note's data after the header.
+        static constexpr unsigned int NOTE_FILE_ENTRY_OFFSET = 0x10;
+        static constexpr unsigned int NOTE_FILE_DATA_OFFSET = 0x30;
+
+        ControllerPakPacker() {
+            reset();
+        }
+
+        void reset();
+        int addNote(QByteArrayView noteEntry, QByteArrayView noteData);
+        const QByteArray& finish();
+
+        static unsigned int getNumPages(const unsigned int noteDataSize) {
+            return (noteDataSize + ControllerPakImage::PAGE_SIZE - 1) / ControllerPakImage::PAGE_SIZE;
+        }
+
+        /**
+         * @brief Checks if a note with the given number of pages can still be added into the current pak.
+         */
+        inline bool canFit(const unsigned int numPages) const {
+            return numNotes < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES && numPages <= getNumFreePages();
+        }
+
+        inline unsigned int getNumFreePages() const {
+            return ControllerPakImage::NUM_PAGES - nextFreePage;
+        }
+
+        inline unsigned int getNumNotes() const {
+            return numNotes;
+        }
+
+        static void writeIdBlock(char* idBlock);
+        static quint8 calculateIndexTableChecksum(const char* indexTable);
+
+    private:
+        QByteArray pakData;                                                 /**< The whole Controller Pak being built */
+        unsigned int nextFreePage = ControllerPakImage::FIRST_DATA_PAGE;    /**< Every page starting at this one is free */
+        unsigned int numNotes = 0;                                          /**< Used entries in the note table */
+};
+
+#endif // CONTROLLERPAKPACKER_H
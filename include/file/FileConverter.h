@@ -0,0 +1,54 @@
+#ifndef FILECONVERTER_H
+#define FILECONVERTER_H
+
+/**
+ * @file FileConverter.h
+ * @brief Batch conversion between the supported file formats
+ *
+ * Every save (a note, or the slots of a cartridge save) found in the input files is decoded with the input format's loader
+ * (see "FileLoader::decodeSaves()"), and encoded right away with the output format's loader, without going through
+ * the SaveManager nor the FileManager's opened file. This means conversions don't touch the save being edited,
+ * and several of them can run at the same time (see "convertAll()").
+ *
+ * Conversions can be one-to-many (i.e. a Controller Pak into one .note file per note) and many-to-one
+ * (i.e. several .note files packed into as few Controller Paks as possible, see ControllerPakPacker.h).
+ * Saves can also be converted to a different version of the game on the way (see RegionConversion.h).
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileManager.h"
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace FileConverter {
+    /**
+     * A single conversion: every save in "inputPaths" gets written in "outputFormat".
+     */
+    struct Job {
+        QStringList inputPaths;                             // Files of any supported format. Their format is detected from their contents
+        QString outputBasePath;                             // Output files are named "<outputBasePath>_1.note", "<outputBasePath>_2.note", etc
+        int outputFormat = FileManager::FORMAT_NOTE;        // Any format except "FORMAT_SRM"
+        short outputRegion = -1;                            // If set, every save gets converted to this region (see RegionConversion.h)
+    };
+
+    /**
+     * Summary of a conversion.
+     */
+    struct Result {
+        int status = 0;                     // -1 if the output format isn't supported, or if an output file couldn't be written. 0 otherwise
+        unsigned int numSaves = 0;          // Saves that were converted
+        unsigned int numSkippedSaves = 0;   // Saves the output format can't hold (i.e. non-Japanese saves into cartridge saves)
+        unsigned int numSkippedFiles = 0;   // Input files that couldn't be read, or that don't have any saves
+        QStringList skippedFiles;
+        QStringList outputFiles;            // Files that were written, in order
+    };
+
+    Result convert(const Job& job);
+    QList<Result> convertAll(const QList<Job>& jobs, QThreadPool* threadPool = QThreadPool::globalInstance());
+    QString getExtension(const int format);
+}
+
+#endif // FILECONVERTER_H
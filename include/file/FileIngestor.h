@@ -0,0 +1,71 @@
+#ifndef FILEINGESTOR_H
+#define FILEINGESTOR_H
+
+/**
+ * @file FileIngestor.h
+ * @brief Batch reading of many small files, handing each one's contents straight to the in-memory decoders
+ *
+ * Save libraries are made of a huge number of small files (0x800 bytes for cartridge saves, 0x930 for notes,
+ * 0x8000 for Controller Paks), so reading them one at a time is bound by the latency of each open(), stat() and read() call,
+ * rather than by the storage device itself.
+ *
+ * On Linux, the files are read through io_uring: the open and size queries of up to "queueDepth" files are submitted at once,
+ * followed by the read and close of each file as soon as its size is known, all without a system call per operation.
+ * Elsewhere (or if the kernel doesn't support it), every file is read with QFile on a thread pool instead.
+ *
+ * Either way, the contents of each file are handed to the given handler (i.e. a FileLoader decoder, see "FileLoader::decodeSaves()")
+ * on the thread pool, so decoding runs in parallel with the reads.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FormatDescriptor.h"
+#include <QByteArrayView>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+
+namespace FileIngestor {
+    enum eBackend {
+        BACKEND_AUTO = -1,      // io_uring if it's available, the thread pool otherwise
+        BACKEND_THREAD_POOL,    // QFile on the thread pool. Works everywhere
+        BACKEND_IO_URING        // Linux only (see "isIoUringAvailable()")
+    };
+
+    /**
+     * No supported file is bigger than a Mupen64Plus .srm file, so bigger files aren't even read.
+     */
+    constexpr qint64 MAX_FILE_SIZE = FormatDescriptors::SRM_FILE_SIZE;
+
+    static_assert(MAX_FILE_SIZE >= FormatDescriptors::DEXDRIVE.maxFileSize && MAX_FILE_SIZE >= FormatDescriptors::NOTE.maxFileSize,
+                  "Every supported file must fit in MAX_FILE_SIZE");
+
+    struct Options {
+        int backend = BACKEND_AUTO;                                 // See "eBackend"
+        unsigned int queueDepth = 64;                               // io_uring: Files being read at the same time
+        QThreadPool* threadPool = QThreadPool::globalInstance();    // Where the handler runs (and where files are read, without io_uring)
+    };
+
+    /**
+     * Summary of a call to "ingest()".
+     */
+    struct Stats {
+        int backend = BACKEND_THREAD_POOL;  // Backend that was actually used
+        unsigned int numFiles = 0;          // Files that were read
+        unsigned int numFailedFiles = 0;    // Files that couldn't be opened or read, or that are bigger than "MAX_FILE_SIZE"
+        qint64 numBytes = 0;                // Bytes read
+    };
+
+    /**
+     * Called once for every file, with its index in the list given to "ingest()" and its contents.
+     * "fileData" is null (see "QByteArrayView::isNull()") if the file couldn't be read, and it's only valid during the call.
+     *
+     * @note It's called from the threads of the thread pool, so several calls can run at the same time.
+     */
+    typedef std::function<void(const qsizetype index, QByteArrayView fileData)> FileHandler;
+
+    Stats ingest(const QStringList& filepaths, const FileHandler& handler, const Options& options = Options());
+    bool isIoUringAvailable();
+}
+
+#endif // FILEINGESTOR_H
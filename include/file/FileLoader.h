@@ -9,6 +9,10 @@
  */
 
 #include "include/save/SaveManager.h"
+#include "include/file/FormatDescriptor.h"
+#include "include/file/ControllerPakImage.h"
+#include "include/save/SlotCodec.h"
+#include <QByteArrayView>
 #include <vector>
 
 /**
@@ -19,47 +23,138 @@
  * which is in charge of all file-related operations (opening files, closing them, parsing them, etc).
  */
 class FileLoader {
-    /// @note All of these offsets are relative to the very beginning of the file.
-    const unsigned int rawDataStartOffset = 0;  /**< Offset where the binary SaveData starts within the file */
-    const unsigned int regionIdOffset = 0;      /**< Offset where region identification is stored at */
-    const unsigned int maxFileSize = 0;         /**< Maximum allowed size for the file format we're currently handling */
+    const FormatDescriptor* formatDescriptor;           /**< Layout of the file format we're currently handling */
+    const SlotCodecTable* slotCodec = &SlotCodecTable::get(SaveData::USA);   /**< Codec of the region of the file, chosen once when the file is opened or written */
 
     public:
+        /**
+         * Location of a group of (up to) "NUM_SAVES" consecutive save slots within a file, along with the region they belong to.
+         */
+        struct SaveSlotGroup {
+            unsigned int startOffset = 0;
+            short region = SaveData::USA;
+            unsigned int numSaveSlots = NUM_SAVES;
+        };
+
+        /**
+         * Save slots decoded straight from a file (see "decodeSaves()"), without going through the SaveManager.
+         * Slots after "numSaveSlots" are left cleared.
+         */
+        struct DecodedSave {
+            short region = SaveData::USA;
+            unsigned int numSaveSlots = 0;
+            SaveSlot saveSlots[NUM_SAVES] = {};
+        };
+
+        /**
+         * What to decode from a file (see "decodeFile()"), and what the loader handles once the file is opened (see "setLoadContext()").
+         * Everything that opening a file takes from the FileManager (the selected note, the selected .srm part, etc)
+         * is given here instead, so the loaders don't depend on any singleton.
+         */
+        struct LoadContext {
+            int format = -1;                    // See "FileManager::eFormat". -1 to detect it from the file's contents
+            int noteIndex = -1;                 // Formats with a note table: note to decode. -1 for the first Castlevania 64 note
+            int srmPart = -1;                   // .srm files: part to decode (see "FileLoaderSrm::ePart"). -1 for the default part
+            unsigned int noteStartOffset = 0;   // Formats with a note table: offset of the first page of the note within the file
+            short region = SaveData::USA;       // Region of the saves being handled (see "getHeaderBytes()")
+            std::vector<unsigned int> notePages;    // Formats with a note table: pages of the note, in order. Empty if no note is selected
+        };
+
+        /**
+         * Everything decoded from a single file (see "decodeFile()"), ready to be handed over to the SaveManager
+         * (see "FileManager::openDecodedFile()"). Slots after "numSaveSlots" are left cleared.
+         */
+        struct DecodedFile {
+            int format = -1;
+            short region = SaveData::USA;
+            int noteIndex = -1;                         // Note the saves were decoded from. -1 for formats without a note table
+            int srmPart = -1;                           // Part of the .srm file the saves were decoded from. -1 for other formats
+            ControllerPakImage controllerPakImage;      // File system of the Controller Pak the saves were decoded from, if any
+            unsigned int numSaveSlots = 0;
+            SaveSlot saveSlots[NUM_SAVES] = {};
+            SaveManager::SaveSlotStatus saveSlotStatus[NUM_SAVES];
+        };
+
         // Constructors and destructor
-        FileLoader() {}
+        explicit FileLoader(const FormatDescriptor& formatDescriptor_) : formatDescriptor(&formatDescriptor_) {}
         virtual ~FileLoader() {}
 
-        // Main file read and write functions
-        virtual void parseRegion(QFile& file) = 0;
-        void readAllSaveSlots(QFile& file);
-        virtual void writeAllSaveSlots(QFile& file);
-        void readSaveSlot(QFile& file, SaveSlot& slot, unsigned int startOffset);
-        void writeSaveSlot(QFile& file, SaveSlot& slot, unsigned int startOffset);
-        const SaveData& readSaveData(QDataStream& inputStream, unsigned int startOffset);
-        void writeSaveData(QDataStream& outputStream, const SaveData& saveData, unsigned int startOffset);
+        /**
+         * @brief Sets the note, the .srm part and the region to handle (see "LoadContext").
+         */
+        virtual void setLoadContext(const LoadContext& loadContext_) {
+            loadContext = loadContext_;
+        }
+
+        inline const LoadContext& getLoadContext() const {
+            return loadContext;
+        }
+
+        // Main file write functions
+        bool writeAllSaveSlots(QFile& file);
+        bool writeDirtySaveSlots(QFile& file);
+        void writeSaveImage(QByteArray& image) const;
+        virtual void encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const;
+        virtual bool writeSaveImageToFile(QFile& file, const QByteArray& image) const;
+        virtual bool writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const;
+        bool writeSaveImageToPages(QFile& file, const QByteArray& image, const ControllerPakImage::PageChain& pageChain) const;
+        bool writeSaveImageToPages(QFile& file, const QByteArray& image, const ControllerPakImage::PageChain& pageChain,
+                                   const unsigned int offset, const unsigned int size) const;
+        virtual unsigned int getSaveImageOffset() const { return getRawDataOffsetStart(); }
+
+        // In-memory decoding and encoding functions.
+        // These only work on caller-owned buffers and structs, so they never allocate memory.
+        // The ones that take a region don't depend on the SaveManager, so they can be used from any thread.
+        void selectSlotCodec(const short region);
+        inline const SlotCodecTable& getSlotCodec() const { return *slotCodec; }
+        void readSaveSlot(QByteArrayView slotData, SaveSlot& slot) const;
+        void writeSaveSlot(char* slotData, const SaveSlot& slot) const;
+        void readSaveData(QByteArrayView slotData, unsigned int startOffset, SaveData& saveData) const;
+        void writeSaveData(char* slotData, unsigned int startOffset, const SaveData& saveData) const;
+        void encodeSaveSlot(char* slotData, const SaveSlot& slot) const;
+        void writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots) const;
+        static void decodeSaveSlot(QByteArrayView slotData, SaveSlot& slot, const short region);
+        static void encodeSaveSlot(char* slotData, const SaveSlot& slot, const short region);
+        static void writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots, const short region);
+        static void writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots, const SlotCodecTable& codec);
+        virtual std::vector<DecodedSave> decodeSaves(QByteArrayView fileData) const;
+
+        // Reentrant file decoding functions.
+        // These only depend on the file's bytes and the given context, so several files can be decoded at once (one per thread).
+        int decodeFile(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const;
+        virtual bool hasValidFileSize(const qsizetype fileSize) const;
+        virtual int decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const;
+
+        // Checksum verification functions.
+        // These work straight from the raw file data, so no field needs to be decoded.
+        virtual std::vector<SaveSlotGroup> findSaveSlotGroups(QByteArrayView fileData) const = 0;
+        unsigned int verifySaveSlots(QByteArrayView fileData, const SaveSlotGroup& group, SaveManager::SaveSlotStatus* statuses) const;
+        void verifyAllSaveSlots(QByteArrayView fileData, const unsigned int startOffset);
 
         // Search-related functions
-        // Search occurences of an array of bytes in a QByteArray, and count its occurences, respectively.
-        static bool searchHexInFile(const QByteArray& data, const std::vector<unsigned char>& target);
-        virtual unsigned int countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const = 0;
+        // Find all occurences of an array of bytes in the raw data.
+        static std::vector<unsigned int> findHexOccurrences(QByteArrayView data, QByteArrayView target);
 
-        // Getter functions related to file-handling tasks
-        virtual unsigned int getRawDataOffsetStart() const { return rawDataStartOffset; }
-        virtual unsigned int getRegionIdOffset() const { return regionIdOffset; }
-        virtual unsigned int getMaxFileSize() const { return 0; }
-        virtual unsigned int getUnusedExtraSize() const { return 0; }
-        virtual unsigned int getSaveSlotPaddedSize() const = 0;
-        virtual unsigned int getSaveSlotPaddingBytesSize() const { return 0; }
-        virtual unsigned int getSavePaddedSize() const { return 0x200; }
+        // Getter functions related to file-handling tasks.
+        // All of them are taken from the format descriptor (see FormatDescriptor.h).
+        inline const FormatDescriptor& getFormatDescriptor() const { return *formatDescriptor; }
+        unsigned int getRawDataOffsetStart() const;
+        inline unsigned int getRegionIdOffset() const { return formatDescriptor->regionIdOffset; }
+        inline unsigned int getMaxFileSize() const { return formatDescriptor->maxFileSize; }
+        inline unsigned int getUnusedExtraSize() const { return formatDescriptor->unusedExtraSize; }
+        inline unsigned int getSaveSlotPaddedSize() const { return formatDescriptor->saveSlotPaddedSize; }
+        unsigned int getSaveSlotPaddingBytesSize() const;
+        unsigned int getSaveDataSize() const;
+        unsigned int getSaveSlotSize() const;
 
         /**
          * @brief getHeaderBytes
-         * Get the raw bytes associated to the file's header, when applicable.
+         * Get the raw bytes associated to the file's header (for the current region), when applicable.
          */
-        virtual std::vector<unsigned char> getHeaderBytes() const = 0;
-        virtual unsigned int getNoteTableOffset() const { return 0; }
-        virtual unsigned int getNoteTableEntrySize() const { return 0; }
-        virtual unsigned int getNoteTableNumEntries() const { return 0; }
+        QByteArrayView getHeaderBytes() const;
+        inline unsigned int getNoteTableOffset() const { return formatDescriptor->noteTableOffset; }
+        inline unsigned int getNoteTableEntrySize() const { return formatDescriptor->noteTableEntrySize; }
+        inline unsigned int getNoteTableNumEntries() const { return formatDescriptor->noteTableNumEntries; }
 
         /**
          * @brief getRawDataOffsetPerEntry
@@ -70,42 +165,42 @@ class FileLoader {
          * For example, for Controller Paks, if the raw data byte is associated to a given save is 0x05,
          * then the actual offset where the raw data for that save starts is at 0x05 * 0x100 = 0x500
          */
-        virtual unsigned int getRawDataOffsetPerEntry(unsigned int rawDataStartOffsetByte) const { return 0; }
+        inline unsigned int getRawDataOffsetPerEntry(unsigned int rawDataStartOffsetByte) const {
+            return formatDescriptor->getPageOffset(rawDataStartOffsetByte);
+        }
 
-        void swapEndianness(QByteArray*);
+        static void swapEndianness(QByteArray*);
 
-        short getRegionEnumFromChar(const unsigned char regionFromFile);
+        short getRegionEnumFromChar(const unsigned char regionFromFile) const;
 
         /**
-         * Reads a value of type T at the given offset within the input stream's raw data.
+         * Reads a value of type T at the given offset within an in-memory copy of the file's raw data.
          */
         template<typename T>
-        T readData(QDataStream& inputStream, long offset) {
-            inputStream.device()->seek(offset);
-
-            T value;
-            inputStream.readRawData(reinterpret_cast<char*>(&value), sizeof(T));
-
-            return qFromBigEndian(value);
+        T readData(QByteArrayView data, unsigned int offset) const {
+            return qFromBigEndian<T>(data.constData() + offset);
         }
 
         /**
-         * Writes a value of type T at the given offset within the input stream's raw data.
+         * Writes a value of type T at the given offset within an in-memory buffer.
          */
         template<typename T>
-        void writeData(QDataStream& outputStream, long offset, T value) {
-            outputStream.device()->seek(offset);
-
-            T bigEndianValue = qToBigEndian(value);
-            outputStream.writeRawData(reinterpret_cast<char*>(&bigEndianValue), sizeof(T));
+        void writeData(char* data, unsigned int offset, T value) const {
+            qToBigEndian<T>(value, data + offset);
         }
 
+    protected:
+        int decodeSaveSlotsData(QByteArrayView saveSlotsData, const short region, DecodedFile& decodedFile) const;
+
         /**
-         * Error verification when opening a file.
-         *
-         * @return -1 on fail. 0 on success.
+         * @brief Changes the layout the file is handled with (i.e. for formats that contain several others, like .srm files).
          */
-        virtual int checkFileOpenErrors() = 0;
+        inline void setFormatDescriptor(const FormatDescriptor& formatDescriptor_) {
+            formatDescriptor = &formatDescriptor_;
+        }
+
+    private:
+        LoadContext loadContext;    /**< Note, .srm part and region being handled (see "setLoadContext()") */
 };
 
 /**
@@ -115,30 +210,15 @@ class FileLoader {
  * This class handles reading and writing .note files (individual notes from a Controller Pak)
  */
 class FileLoaderNote: public FileLoader {
-    /// @note The raw data starts right after the header,
-    /// hence why we just get the size of the header bytes
-    const unsigned int rawDataStartOffset = getHeaderBytes().size();
-    const unsigned int regionIdOffset = 0x13;
-
     public:
         // Constructors and destructor
-        FileLoaderNote() {}
+        explicit FileLoaderNote(const FormatDescriptor& formatDescriptor_) : FileLoader(formatDescriptor_) {}
         ~FileLoaderNote() {}
 
         // Main file read and write functions
-        void parseRegion(QFile& file);
-        void writeAllSaveSlots(QFile& file);
-
-        // Getter functions related to file-handling tasks
-        unsigned int countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const;
-        unsigned int getRawDataOffsetStart() const { return rawDataStartOffset; }
-        unsigned int getRegionIdOffset() const { return regionIdOffset; }
-        unsigned int getMaxFileSize() const;
-        unsigned int getUnusedExtraSize() const { return 0x100; }  // Unused extra 100 bytes at the end of notes
-        unsigned int getSaveSlotPaddedSize() const;
-        std::vector<unsigned char> getHeaderBytes() const;
-        unsigned int getSaveSlotPaddingBytesSize() const;
-        int checkFileOpenErrors();
+        std::vector<SaveSlotGroup> findSaveSlotGroups(QByteArrayView fileData) const;
+        void encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const;
+        unsigned int getSaveImageOffset() const { return 0; }
 };
 
 /**
@@ -149,31 +229,20 @@ class FileLoaderNote: public FileLoader {
  * (save files embedded in the cartridge, only found in the Japanese version of the game)
  */
 class FileLoaderCartridge: public FileLoader {
-    /// @note The raw data starts right after the header,
-    /// hence why we just get the size of the header bytes
-    const unsigned int rawDataStartOffset = getHeaderBytes().size();
-    const unsigned int regionIdOffset = 0;  /// @note Not needed for cartridge saves
-
     public:
         // Constructors and destructor
-        FileLoaderCartridge() {}
+        explicit FileLoaderCartridge(const FormatDescriptor& formatDescriptor_) : FileLoader(formatDescriptor_) {}
         ~FileLoaderCartridge() {}
 
         // Main file read and write functions
-        void parseRegion(QFile& file);
-        void writeAllSaveSlots(QFile& file);
+        std::vector<SaveSlotGroup> findSaveSlotGroups(QByteArrayView fileData) const;
+        void encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const;
+        unsigned int getSaveImageOffset() const { return 0; }
+        bool hasValidFileSize(const qsizetype fileSize) const;
+        int decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const;
 
         // Getter functions related to file-handling tasks
-        unsigned int countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const;
-        unsigned int getRawDataOffsetStart() const { return rawDataStartOffset; }
-        unsigned int getRegionIdOffset() const { return 0; }   // Not needed for cartridge saves, so we return 0
-        unsigned int getMaxFileSize() const;
-        unsigned int getUnusedExtraSize() const { return 0; }
-        unsigned int getSaveSlotPaddedSize() const;
-        std::vector<unsigned char> getHeaderBytes() const;
-        unsigned int getCartridgeNumSaves() const;
-        unsigned int getSaveSlotPaddingBytesSize() const;
-        int checkFileOpenErrors();
+        unsigned int getCartridgeNumSaves(QByteArrayView fileData) const;
 };
 
 /**
@@ -186,31 +255,25 @@ class FileLoaderCartridge: public FileLoader {
  * the start offset of the raw data associated to each save, its region, etc.
  */
 struct FileLoaderControllerPak: public FileLoader {
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_OFFSET = 0x300;    /**< Offset where the note table starts */
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_ENTRY_SIZE = 0x20; /**< Size of each entry in the note table */
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES = 16;  /**< Total number of elements in the note table */
-
     public:
         // Constructors and destructor
-        FileLoaderControllerPak() {}
+        explicit FileLoaderControllerPak(const FormatDescriptor& formatDescriptor_) : FileLoader(formatDescriptor_) {}
         ~FileLoaderControllerPak() {}
 
         // Main file read and write functions
-        void parseRegion(QFile& file);
+        bool writeSaveImageToFile(QFile& file, const QByteArray& image) const;
+        bool writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const;
+        std::vector<SaveSlotGroup> findSaveSlotGroups(QByteArrayView fileData) const;
+        std::vector<DecodedSave> decodeSaves(QByteArrayView fileData) const;
+        int decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const;
 
-        // Getter functions related to file-handling tasks
-        unsigned int countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const;
-        unsigned int getRawDataOffsetStart() const;
-        unsigned int getRegionIdOffset() const { return 0; }
-        unsigned int getMaxFileSize() const;
-        unsigned int getUnusedExtraSize() const { return 0x100; }  // Unused extra 100 bytes at the end of notes
-        unsigned int getSaveSlotPaddedSize() const;
-        std::vector<unsigned char> getHeaderBytes() const { return {}; }
-        unsigned int getNoteTableOffset() const { return CONTROLLER_PAK_NOTE_TABLE_OFFSET; }
-        unsigned int getNoteTableEntrySize() const { return CONTROLLER_PAK_NOTE_TABLE_ENTRY_SIZE; }
-        unsigned int getNoteTableNumEntries() const { return CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES; }
-        unsigned int getRawDataOffsetPerEntry(unsigned int rawDataStartOffsetByte) const { return rawDataStartOffsetByte * 0x100; }
-        int checkFileOpenErrors();
+        /**
+         * @brief The Controller Pak data within the file (which doesn't always start at the beginning of it, i.e. DexDrive saves).
+         */
+        inline QByteArrayView getControllerPakData(QByteArrayView fileData) const {
+            const unsigned int pakDataOffset = getFormatDescriptor().pakDataOffset;
+            return (pakDataOffset < fileData.size()) ? fileData.sliced(pakDataOffset) : QByteArrayView();
+        }
 };
 
 /**
@@ -224,21 +287,72 @@ struct FileLoaderControllerPak: public FileLoader {
  * there are various 0x1040 constants in the code for this class.
  */
 struct FileLoaderDexDrive: public FileLoaderControllerPak {
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_OFFSET = 0x300 + 0x1040;
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_ENTRY_SIZE = 0x20;
-    const unsigned int CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES = 16;
-
     public:
         // Constructors and destructor
-        FileLoaderDexDrive() {}
+        explicit FileLoaderDexDrive(const FormatDescriptor& formatDescriptor_) : FileLoaderControllerPak(formatDescriptor_) {}
         ~FileLoaderDexDrive() {}
+};
 
-        // Getter functions related to file-handling tasks
-        unsigned int getMaxFileSize() const;
-        unsigned int getNoteTableOffset() const { return CONTROLLER_PAK_NOTE_TABLE_OFFSET; }
-        unsigned int getNoteTableEntrySize() const { return CONTROLLER_PAK_NOTE_TABLE_ENTRY_SIZE; }
-        unsigned int getNoteTableNumEntries() const { return CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES; }
-        unsigned int getRawDataOffsetPerEntry(unsigned int rawDataStartOffsetByte) const { return (rawDataStartOffsetByte * 0x100) + 0x1040; }
+/**
+ * @class FileLoaderSrm
+ * @brief FileLoaderSrm class
+ *
+ * This class handles reading and writing .srm files (Mupen64Plus saves, which contain the EEPROM, 4 Controller Paks,
+ * the SRAM and the FlashRAM one after another).
+ *
+ * Only one part of the file is handled at a time: either the EEPROM (through the cartridge logic) or one of the Controller Paks
+ * (through the Controller Pak logic). Every part is accessed in place, as a view over the same file data, and written back in place.
+ */
+class FileLoaderSrm: public FileLoader {
+    FileLoaderCartridge eepromLoader{FormatDescriptors::SRM_EEPROM};
+    FileLoaderControllerPak controllerPakLoaders[FormatDescriptors::SRM_NUM_CONTROLLER_PAKS] = {
+        FileLoaderControllerPak(FormatDescriptors::SRM_CONTROLLER_PAKS[0]),
+        FileLoaderControllerPak(FormatDescriptors::SRM_CONTROLLER_PAKS[1]),
+        FileLoaderControllerPak(FormatDescriptors::SRM_CONTROLLER_PAKS[2]),
+        FileLoaderControllerPak(FormatDescriptors::SRM_CONTROLLER_PAKS[3])
+    };
+
+    public:
+        /**
+         * @brief The part of the file being handled
+         */
+        enum ePart {
+            PART_NONE = -1,
+            PART_EEPROM,
+            PART_CONTROLLER_PAK_1,    // The other Controller Paks follow this one
+        };
+
+        // Constructors and destructor
+        explicit FileLoaderSrm(const FormatDescriptor& formatDescriptor_) : FileLoader(formatDescriptor_) {}
+        ~FileLoaderSrm() {}
+
+        void setLoadContext(const LoadContext& loadContext_);
+
+        // Main file read and write functions
+        void encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const;
+        bool writeSaveImageToFile(QFile& file, const QByteArray& image) const;
+        bool writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const;
+        unsigned int getSaveImageOffset() const;
+        std::vector<SaveSlotGroup> findSaveSlotGroups(QByteArrayView fileData) const;
+        std::vector<DecodedSave> decodeSaves(QByteArrayView fileData) const;
+        bool hasValidFileSize(const qsizetype fileSize) const;
+        int decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const;
+
+        // Part selection functions
+        void selectPart(const int part_);
+        int findDefaultPart(QByteArrayView fileData) const;
+
+        inline int getPart() const {
+            return part;
+        }
+
+    private:
+        bool hasEepromSaves(QByteArrayView fileData) const;
+        FileLoader* getPartLoader();
+        const FileLoader* getPartLoader() const;
+        const FileLoader* getPartLoader(const int part_) const;
+
+        int part = PART_NONE;   /**< Part of the file currently being handled (see "ePart") */
 };
 
 #endif
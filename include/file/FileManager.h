@@ -9,9 +9,12 @@
  */
 
 #include "include/file/FileLoader.h"
+#include "include/file/ControllerPakImage.h"
 #include <QFile>
 #include <QtEndian>
 #include <QFileInfo>
+#include <QStringList>
+#include <functional>
 
 /**
  * @class FileManager
@@ -30,7 +33,8 @@ class FileManager {
             FORMAT_NOTE,                  // .note
             FORMAT_CONTROLLERPAK,         // .pak, .mpk
             FORMAT_CARTRIDGE,             // .eep
-            FORMAT_DEXDRIVE               // .n64, .t64
+            FORMAT_DEXDRIVE,              // .n64, .t64
+            FORMAT_SRM                    // .srm
         };
 
         /**
@@ -51,6 +55,37 @@ class FileManager {
             }
         };
 
+        /**
+         * Summary of a checksum audit or repair (see "repairChecksums()").
+         */
+        struct ChecksumRepairReport {
+            unsigned int numFiles = 0;          // Files that were checked
+            unsigned int numSkippedFiles = 0;   // Files that couldn't be opened
+            unsigned int numSlots = 0;          // Save slots that were checked
+            unsigned int numInvalidSlots = 0;   // Save slots whose checksums didn't match their data
+            unsigned int numRepairedSlots = 0;  // Save slots whose checksums were rewritten
+            QStringList invalidFiles;           // Files that had at least one invalid save slot
+        };
+
+        /**
+         * Summary of packing a library of notes into Controller Paks (see "packNotes()").
+         */
+        struct NotePackReport {
+            unsigned int numNotes = 0;          // Notes that were packed
+            unsigned int numSkippedFiles = 0;   // Files that couldn't be read, or that aren't valid notes
+            QStringList skippedFiles;
+            QStringList outputFiles;            // Controller Paks that were written, in order
+        };
+
+        /**
+         * Picks which Castlevania 64 note gets opened from a file with a note table (see "selectDecodedNote()").
+         * It's given the note table data array, where the entries of the Castlevania 64 notes have an "index" other than -1,
+         * and returns the index of the chosen note, or -1 to stop opening the file.
+         */
+        typedef std::function<int(const std::vector<ControllerPakNotetableData>& noteTableData)> NoteSelector;
+
+        static constexpr unsigned int FORMAT_SIGNATURE_READ_SIZE = 64;  /**< Bytes read from the start of a file in order to detect its format */
+
         const unsigned int CONTROLLER_PAK_NOTE_TABLE_ENTRY_SIZE = 0x20;  /**< Size of each entry in the note table */
         const unsigned int CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES = 16;   /**< Total number of elements in the note table */
 
@@ -89,14 +124,6 @@ class FileManager {
             filepath = filepath_;
         }
 
-        inline QFile& getFile() {
-            return *file;
-        }
-
-        inline QByteArray& getBuffer() {
-            return *buffer;
-        }
-
         inline FileLoader* getLoader() {
             return loader;
         }
@@ -109,10 +136,32 @@ class FileManager {
             controllerPakCurrentlySelectedSaveIndex = controllerPakCurrentlySelectedSaveIndex_;
         }
 
+        inline int getSrmCurrentlySelectedPart() const {
+            return srmCurrentlySelectedPart;
+        }
+
+        inline void setSrmCurrentlySelectedPart(int srmCurrentlySelectedPart_) {
+            srmCurrentlySelectedPart = srmCurrentlySelectedPart_;
+        }
+
         inline std::vector<ControllerPakNotetableData>* getControllerPakNotetableDataArray() {
             return &noteTableArray;
         }
 
+        /**
+         * @brief File system of the last Controller Pak that was opened (see "openDecodedFile()").
+         */
+        inline const ControllerPakImage& getControllerPakImage() const {
+            return controllerPakImage;
+        }
+
+        /**
+         * @brief Sets how the note to open is chosen (i.e. by asking the user). If none is set, the first Castlevania 64 note is opened.
+         */
+        inline void setNoteSelector(const NoteSelector& noteSelector_) {
+            noteSelector = noteSelector_;
+        }
+
         inline bool wasFileOpened() const {
             return fileOpened;
         }
@@ -122,12 +171,31 @@ class FileManager {
         }
 
         // Functions for the main file operations
-        int openFile(const QString& filepath_);
         int writeFile(const QString& filepath_, bool isReplacingOldFile);
+        int patchNote(const QString& filepath_, const unsigned int noteIndex, const bool onlyChangedSlots = false);
+        void closeFile();
 
-        // Functions or handling the note table data array
-        unsigned int initNoteTableData(QFile& file);
+        // Reentrant file decoding functions (see "FileLoader::decodeFile()")
+        static int decodeFile(const QString& filepath_, const FileLoader::LoadContext& context, FileLoader::DecodedFile& decodedFile);
+        int selectDecodedNote(const FileLoader::DecodedFile& decodedFile) const;
+        int openDecodedFile(const QString& filepath_, const FileLoader::DecodedFile& decodedFile);
+
+        // Format detection functions
+        static int detectFormat(QByteArrayView headerData, const qint64 fileSize);
+        static int detectFileFormat(const QString& filepath_);
+        static int getFormatFromExtension(const QString& filepath_);
+        static int findFileFormat(const QString& filepath_, const bool detectFromContent);
+        static int findFileFormat(const QString& filepath_, QByteArrayView fileData);
+        static FileLoader* createLoader(const int format_, const FileLoader::LoadContext& context = FileLoader::LoadContext());
+
+        // Controller Pak building functions
+        int packNotes(const QStringList& notePaths, const QString& outputBasePath, const int format_, NotePackReport& report);
+        static bool writeControllerPak(const QString& filepath_, const int format_, QByteArrayView pakData);
 
+        // Checksum verification functions
+        int repairChecksums(const QString& path, const bool auditOnly, ChecksumRepairReport& report);
+
+        // Functions or handling the note table data array
         void clearNoteTableData() {
             for (int i = 0; i < noteTableArray.size(); i++) {
                 noteTableArray[i].clearEntry();
@@ -140,36 +208,33 @@ class FileManager {
         // Constructors and destructor
         FileManager() {
             filepath = "";
-            buffer = new QByteArray();
         }
 
         ~FileManager() {
-            if (file != nullptr) {
-                file->close();
-
-                delete file;
-                file = nullptr;
-            }
+            closeFile();
 
             if (loader != nullptr) {
                 delete loader;
                 loader = nullptr;
             }
-
-            if (buffer != nullptr) {
-                delete buffer;
-                buffer = nullptr;
-            }
         }
 
         FileManager(const FileManager& obj) = delete; // Remove the copy constructor
-        int determineFormat();
+        int determineFormat(const bool detectFromContent);
+        static FileLoader* createLoader(const QString& filepath_, int& format_, const bool detectFromContent = true,
+                                        const FileLoader::LoadContext& context = FileLoader::LoadContext());
+        FileLoader::LoadContext getLoadContext() const;
+        void repairFileChecksums(const QString& filepath_, const int fileFormat, const bool auditOnly, ChecksumRepairReport& report);
+        unsigned int indexNoteTableData();
+        static unsigned int indexNoteTableData(const ControllerPakImage& pakImage, const FileLoader& fileLoader,
+                                               std::vector<ControllerPakNotetableData>& noteTableData);
+        int selectNote(const std::vector<ControllerPakNotetableData>& noteTableData) const;
 
         int format = FORMAT_NOTE;                           /**< File format */
         int controllerPakCurrentlySelectedSaveIndex = 0;    /**< The index of the currently selected save in a loaded Controller Pak */
+        int srmCurrentlySelectedPart = -1;                  /**< The part of the loaded .srm file being handled (see "FileLoaderSrm::ePart") */
 
         QFile* file = nullptr;                              /**< Currently-opened file */
-        QByteArray* buffer = nullptr;                       /**< File buffer containing the raw bytes for the currently-opened file */
         QString filepath;                                   /**< File path of the currently-opened file */
         FileLoader* loader = nullptr;                       /**< File format */
         /**< A file was opened at least once. Used for knowing if we have to enable or disable the Save buttons */
@@ -180,6 +245,8 @@ class FileManager {
          * store all the entries in the note table that contain Castlevania 64 saves.
          */
         std::vector<ControllerPakNotetableData> noteTableArray{CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES};
+        ControllerPakImage controllerPakImage;              /**< File system of the last Controller Pak that was opened */
+        NoteSelector noteSelector;                          /**< See "setNoteSelector()" */
 };
 
 #endif
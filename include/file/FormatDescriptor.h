@@ -0,0 +1,177 @@
+#ifndef FORMATDESCRIPTOR_H
+#define FORMATDESCRIPTOR_H
+
+/**
+ * @file FormatDescriptor.h
+ * @brief Compile-time description of the layout of each supported file format
+ *
+ * Every offset and size needed to locate the save slots inside a file (header bytes, slot stride, padding,
+ * note table geometry, etc) is stored in a constexpr "FormatDescriptor". The right descriptor is picked once
+ * when the file-handling class is created (see "FileManager::determineFormat()"), so layout math never needs
+ * to allocate memory nor go through virtual calls.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Save.h"
+#include <QByteArrayView>
+#include <array>
+
+/**
+ * @brief Layout of a file format
+ */
+struct FormatDescriptor {
+    static constexpr unsigned int MAX_HEADER_SIZE = 0x30;       /**< Size of the largest header among all formats */
+    static constexpr unsigned int NUM_REGIONS = SaveData::PAL + 1;
+
+    typedef std::array<unsigned char, MAX_HEADER_SIZE> HeaderBytes;
+
+    /// @note All of these offsets are relative to the very beginning of the file.
+    std::array<HeaderBytes, NUM_REGIONS> headerBytes {};    /**< Header of each region's files (only the first "headerSize" bytes are used) */
+    unsigned int headerSize = 0;                            /**< Size of the header. 0 if the format doesn't have one */
+    bool isHeaderPerSaveSlot = false;                       /**< If true, each save slot starts with its own copy of the header, instead of the file */
+    unsigned int rawDataStartOffset = 0;                    /**< Offset where the binary SaveData starts within the file (formats without a note table) */
+    unsigned int regionIdOffset = 0;                        /**< Offset where region identification is stored at. 0 if the format doesn't store it */
+    unsigned int saveSlotPaddedSize = 0x200;                /**< Distance between the start of two consecutive save slots */
+    unsigned int unusedExtraSize = 0;                       /**< Unused bytes at the end of the save data */
+    unsigned int maxFileSize = 0;                           /**< Size of the whole file. 0 for formats with a variable size */
+    unsigned int noteTableOffset = 0;                       /**< Offset where the note table starts (Controller Pak-based formats) */
+    unsigned int noteTableEntrySize = 0;                    /**< Size of each entry in the note table */
+    unsigned int noteTableNumEntries = 0;                   /**< Total number of elements in the note table. 0 if there's no note table */
+    unsigned int pageSize = 0;                              /**< Size of each Controller Pak page. Note table entries point to pages */
+    unsigned int pakDataOffset = 0;                         /**< Offset where the Controller Pak data starts within the file */
+
+    constexpr bool hasNoteTable() const {
+        return noteTableNumEntries != 0;
+    }
+
+    /**
+     * @brief Header bytes for files of the given region. Empty if the format doesn't have a header.
+     */
+    QByteArrayView getHeaderBytes(const short region) const {
+        return QByteArrayView(headerBytes[region].data(), headerSize);
+    }
+
+    /**
+     * @brief Given the page number a note table entry points to, returns the offset where its raw data starts.
+     *
+     * For example, for Controller Paks, if a save starts at page 0x05, its raw data starts at 0x05 * 0x100 = 0x500.
+     */
+    constexpr unsigned int getPageOffset(const unsigned int page) const {
+        return pakDataOffset + (page * pageSize);
+    }
+};
+
+namespace FormatDescriptors {
+    /**
+     * @brief Builds the header of a .note file, which contains the game ID of each region.
+     *
+     * @note source: https://github.com/bryc/mpkedit/wiki/Note-file-formats
+     * @note This implements the format last updated on Sep 29, 2023.
+     */
+    constexpr FormatDescriptor::HeaderBytes makeNoteHeader(const unsigned char regionChar) {
+        return {
+            0x01, 0x4D, 0x50, 0x4B, 0x4E, 0x6F, 0x74, 0x65, 0x00, 0x00, 0x00, 0x67,
+            0x89, 0x7E, 0x56, 0x00, 0x4E, 0x44, 0x33, regionChar, 0x41, 0x34, 0xCA, 0xFE,
+            0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x1A, 0x2C, 0x2D,
+            0x25, 0x1E, 0x2F, 0x1A, 0x27, 0x22, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00
+        };
+    }
+
+    /**
+     * "KCEK Format 1209". Cartridge saves are exclusive to the Japanese version, but the header is the same for every region.
+     */
+    constexpr FormatDescriptor::HeaderBytes CARTRIDGE_HEADER = {
+        0x4B, 0x43, 0x45, 0x4B, 0x20, 0x46, 0x6F, 0x72, 0x6D, 0x61, 0x74, 0x20, 0x31, 0x32, 0x30, 0x39
+    };
+
+    constexpr FormatDescriptor makeNote() {
+        FormatDescriptor descriptor;
+
+        descriptor.headerBytes = {makeNoteHeader('E'), makeNoteHeader('J'), makeNoteHeader('P')};
+        descriptor.headerSize = 0x30;
+        descriptor.rawDataStartOffset = descriptor.headerSize;  // The raw data starts right after the header
+        descriptor.regionIdOffset = 0x13;
+        descriptor.unusedExtraSize = 0x100;                     // Unused extra 0x100 bytes at the end of notes
+        descriptor.maxFileSize = descriptor.headerSize + (descriptor.saveSlotPaddedSize * NUM_SAVES) + descriptor.unusedExtraSize;
+
+        return descriptor;
+    }
+
+    constexpr FormatDescriptor makeCartridge() {
+        FormatDescriptor descriptor;
+
+        descriptor.headerBytes = {CARTRIDGE_HEADER, CARTRIDGE_HEADER, CARTRIDGE_HEADER};
+        descriptor.headerSize = 0x10;
+        descriptor.isHeaderPerSaveSlot = true;
+        descriptor.rawDataStartOffset = descriptor.headerSize;  // The raw data starts right after the first slot's header
+
+        return descriptor;
+    }
+
+    constexpr FormatDescriptor makeControllerPak(const unsigned int pakDataOffset) {
+        FormatDescriptor descriptor;
+
+        descriptor.unusedExtraSize = 0x100;
+        descriptor.maxFileSize = pakDataOffset + 0x8000;
+        descriptor.noteTableOffset = pakDataOffset + 0x300;
+        descriptor.noteTableEntrySize = 0x20;
+        descriptor.noteTableNumEntries = 16;
+        descriptor.pageSize = 0x100;
+        descriptor.pakDataOffset = pakDataOffset;
+
+        return descriptor;
+    }
+
+    inline constexpr FormatDescriptor NOTE = makeNote();                    /**< .note files. Always 0x930 bytes */
+    inline constexpr FormatDescriptor CARTRIDGE = makeCartridge();          /**< .eep files. The size depends on the number of saves */
+    inline constexpr FormatDescriptor CONTROLLER_PAK = makeControllerPak(0);    /**< .mpk / .pak files. Always 0x8000 bytes */
+
+    /// @note In DexDrive saves, the Controller Pak data actually starts at 0x1040.
+    inline constexpr FormatDescriptor DEXDRIVE = makeControllerPak(0x1040);     /**< .n64 / .t64 files */
+
+    /**
+     * Mupen64Plus .srm files contain every kind of save memory one after another:
+     * the EEPROM, the 4 Controller Paks, the SRAM and the FlashRAM.
+     */
+    constexpr unsigned int SRM_EEPROM_SIZE = 0x800;
+    constexpr unsigned int SRM_NUM_CONTROLLER_PAKS = 4;
+    constexpr unsigned int SRM_CONTROLLER_PAK_OFFSET = SRM_EEPROM_SIZE;
+    constexpr unsigned int SRM_CONTROLLER_PAK_SIZE = 0x8000;
+    constexpr unsigned int SRM_SRAM_OFFSET = SRM_CONTROLLER_PAK_OFFSET + (SRM_CONTROLLER_PAK_SIZE * SRM_NUM_CONTROLLER_PAKS);
+    constexpr unsigned int SRM_FLASHRAM_OFFSET = SRM_SRAM_OFFSET + 0x8000;
+    constexpr unsigned int SRM_FILE_SIZE = SRM_FLASHRAM_OFFSET + 0x20000;
+
+    constexpr FormatDescriptor makeSrm() {
+        FormatDescriptor descriptor;
+        descriptor.maxFileSize = SRM_FILE_SIZE;
+
+        return descriptor;
+    }
+
+    /**
+     * @brief The EEPROM at the start of .srm files, which holds the same data as a cartridge save (with exactly "NUM_SAVES" slots).
+     */
+    constexpr FormatDescriptor makeSrmEeprom() {
+        FormatDescriptor descriptor = makeCartridge();
+        descriptor.maxFileSize = SRM_EEPROM_SIZE;
+
+        return descriptor;
+    }
+
+    inline constexpr FormatDescriptor SRM = makeSrm();                      /**< .srm files. Always 0x48800 bytes */
+    inline constexpr FormatDescriptor SRM_EEPROM = makeSrmEeprom();
+    inline constexpr std::array<FormatDescriptor, SRM_NUM_CONTROLLER_PAKS> SRM_CONTROLLER_PAKS = {
+        makeControllerPak(SRM_CONTROLLER_PAK_OFFSET),
+        makeControllerPak(SRM_CONTROLLER_PAK_OFFSET + SRM_CONTROLLER_PAK_SIZE),
+        makeControllerPak(SRM_CONTROLLER_PAK_OFFSET + (SRM_CONTROLLER_PAK_SIZE * 2)),
+        makeControllerPak(SRM_CONTROLLER_PAK_OFFSET + (SRM_CONTROLLER_PAK_SIZE * 3))
+    };
+
+    static_assert(NOTE.maxFileSize == 0x930, "Notes are 0x930 bytes long");
+    static_assert(SRM_FILE_SIZE == 0x48800, "Mupen64Plus .srm files are 0x48800 bytes long");
+    static_assert(SRM_EEPROM.saveSlotPaddedSize * NUM_SAVES == SRM_EEPROM_SIZE, "The EEPROM fits exactly \"NUM_SAVES\" save slots");
+    static_assert(NOTE.headerBytes[SaveData::USA][NOTE.regionIdOffset] == 'E', "The region ID must be part of the note header");
+}
+
+#endif // FORMATDESCRIPTOR_H
@@ -0,0 +1,141 @@
+#ifndef SAVEINDEX_H
+#define SAVEINDEX_H
+
+/**
+ * @file SaveIndex.h
+ * @brief Persistent columnar index of the saves of a whole library
+ *
+ * The index has a row for every save data entry (the main save or the beginning of stage save of a slot) of a set of files,
+ * as decoded by the FileLoader decoders. Every SaveData field is stored as its own column (one column per element, for arrays),
+ * so a query (see SaveQuery.h) only goes through the columns it uses, straight from the mapped index file,
+ * without touching the original saves. Entries that were never saved to (without "SAVE_FLAG_ACTIVE") aren't indexed.
+ *
+ * The index also keeps the path, size, modification time and hash of every file it was built from.
+ * Refreshing it (see "refresh()") only reads the files whose size or modification time changed,
+ * and only decodes the ones whose contents changed too. The rows of every other file are copied from the previous index.
+ *
+ * File layout (every section and column starts at a multiple of 8 bytes):
+ *   - Header
+ *   - File table: a FileEntry for every file
+ *   - Path data: UTF-8 paths of every file
+ *   - Row columns: file index (quint32), and save index, slot index, entry and region (quint8 each) of every row
+ *   - Field columns: every element of every field in "SaveDataSchema::FIELDS", with the size and signedness of the field
+ *
+ * Numbers are stored in the host's byte order, so the columns can be used as they are. An index built on a host
+ * with another byte order (or with another version of the SaveData struct) isn't opened, and refreshing it builds it again.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileIngestor.h"
+#include "include/save/SaveQuery.h"
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * @class SaveIndex
+ * @brief Memory-mapped index file
+ */
+class SaveIndex {
+    public:
+        /**
+         * What "refresh()" did with each file.
+         */
+        enum eFileStatus {
+            FILE_REUSED,        // The file didn't change, so its rows were copied from the previous index
+            FILE_DECODED,       // The file is new or changed, so it was decoded again
+            FILE_UNSUPPORTED,   // The file's format or size isn't supported. It's still listed, so it isn't read again until it changes
+            FILE_UNREADABLE     // The file couldn't be read. It's left out of the index
+        };
+
+        /**
+         * Save data entry that a row comes from.
+         */
+        enum eEntry {
+            ENTRY_MAIN_SAVE,
+            ENTRY_BEGINNING_OF_STAGE
+        };
+
+        /**
+         * A file of the index, as stored in the file table.
+         */
+        struct FileEntry {
+            quint64 pathOffset;         /**< Offset of the path within the path data */
+            quint32 pathSize;           /**< Size of the path, in bytes */
+            qint32 format;              /**< See "FileManager::eFormat". -1 if the file isn't supported */
+            quint32 firstRow;
+            quint32 numRows;
+            qint64 size;
+            qint64 modificationTime;    /**< Milliseconds since the Unix epoch */
+            quint64 hash;               /**< FNV-1a hash of the file's contents */
+        };
+
+        struct RefreshStats {
+            std::vector<int> fileStatuses;  // See "eFileStatus". One per file given to "refresh()"
+            unsigned int numReusedFiles = 0;
+            unsigned int numDecodedFiles = 0;
+            unsigned int numUnsupportedFiles = 0;
+            unsigned int numUnreadableFiles = 0;
+        };
+
+        SaveIndex() {}
+        SaveIndex(const SaveIndex& obj) = delete;
+        ~SaveIndex();
+
+        int open(const QString& indexPath);
+        void close();
+        int refresh(const QString& indexPath, const QStringList& filepaths, const FileIngestor::Options& options, RefreshStats& stats);
+
+        inline bool isOpen() const { return header != nullptr; }
+        quint32 getNumFiles() const;
+        quint32 getNumRows() const;
+        const FileEntry& getFile(const quint32 fileIndex) const;
+        QString getFilePath(const quint32 fileIndex) const;
+
+        // Row getters. "row" must be lower than "getNumRows()"
+        quint32 getRowFile(const quint32 row) const;
+        unsigned int getRowSave(const quint32 row) const;
+        unsigned int getRowSlot(const quint32 row) const;
+        int getRowEntry(const quint32 row) const;
+        short getRowRegion(const quint32 row) const;
+
+        const void* getFieldColumn(const unsigned int fieldIndex, const unsigned int elementIndex) const;
+        SaveQuery::RowSet find(const SaveQuery& query) const;
+
+    private:
+        struct Header;
+
+        /**
+         * Columns stored before the field columns.
+         */
+        enum eRowColumn {
+            ROW_COLUMN_FILE,
+            ROW_COLUMN_SAVE,
+            ROW_COLUMN_SLOT,
+            ROW_COLUMN_ENTRY,
+            ROW_COLUMN_REGION,
+            NUM_ROW_COLUMNS
+        };
+
+        /**
+         * Size of the values of a column, and where each value is taken from when a file is decoded (see "refresh()").
+         */
+        struct ColumnLayout {
+            unsigned int valueSize;
+            unsigned int rowOffset;     /**< Offset of the value within a decoded row. Unused for ROW_COLUMN_FILE */
+        };
+
+        static const std::vector<ColumnLayout>& getColumnLayouts();
+        static std::vector<quint64> getColumnOffsets(const quint64 columnsOffset, const quint32 numRows);
+        const char* getColumn(const unsigned int column) const;
+
+        QFile indexFile;
+        const uchar* indexData = nullptr;   /**< The whole index file, mapped */
+        const Header* header = nullptr;
+        const FileEntry* files = nullptr;
+        std::vector<quint64> columnOffsets; /**< Offset of every column (see "getColumnOffsets()"), followed by the end of the last one */
+};
+
+#endif // SAVEINDEX_H
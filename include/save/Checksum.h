@@ -0,0 +1,39 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+/**
+ * @file Checksum.h
+ * @brief Save checksum kernels
+ *
+ * The game protects each save with two checksums: the sum of all of its bytes, and the XOR of all of its 32-bit words.
+ * Both of them are calculated here in a single pass over the data. On x86 CPUs, SSE2 / AVX2 kernels
+ * ("psadbw" for the byte sum, wide XORs for the word XOR) are chosen at runtime, with a portable scalar fallback.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include <QtGlobal>
+#include <cstddef>  // std::size_t
+
+namespace Checksum {
+    /**
+     * Result of running the checksum kernel over a block of data.
+     */
+    struct Result {
+        quint32 byteSum = 0;    /**< Sum of every byte, wrapping around on overflow */
+        quint32 wordXor = 0;    /**< XOR of every complete 32-bit word, loaded in the host's byte order */
+    };
+
+    /**
+     * @brief Calculates the byte sum and the word XOR of "size" bytes of "data".
+     * Trailing bytes that don't make up a whole word only count towards the byte sum.
+     */
+    Result calculate(const char* data, std::size_t size);
+
+    /**
+     * @brief Name of the kernel chosen for this CPU ("avx2", "sse2" or "scalar").
+     */
+    const char* getKernelName();
+}
+
+#endif // CHECKSUM_H
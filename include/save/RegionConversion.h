@@ -0,0 +1,118 @@
+#ifndef REGIONCONVERSION_H
+#define REGIONCONVERSION_H
+
+/**
+ * @file RegionConversion.h
+ * @brief Conversion of saves between the USA, JPN and PAL versions of the game
+ *
+ * The layout of each region's saves is already handled by SaveDataSchema.h (i.e. the PAL-only "language" field),
+ * so a save gets re-laid out just by encoding it with the new region. The only thing left to convert are the items:
+ * the JPN and PAL versions have an extra special item (ID 6), which shifts the consumable items by +1,
+ * and the Pot Pourri only exists in the USA version (see "SaveData::eItemId").
+ *
+ * The items array of every save is remapped with a single byte shuffle (see ByteSwap.h), using a mask built at compile time
+ * for each pair of regions. Items that don't exist in the new region are dropped.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Save.h"
+#include "include/file/ByteSwap.h"
+#include <array>
+#include <cstddef>  // std::size_t
+
+namespace RegionConversion {
+    constexpr unsigned int NUM_REGIONS = SaveData::PAL + 1;
+
+    typedef std::array<quint8, ByteSwap::getMaskSize(SIZE_ITEMS_ARRAY)> ItemsMask;
+
+    /**
+     * @brief ID that an item of the given region has in the USA version. 0 if the item doesn't exist there.
+     */
+    constexpr int getUsaItemId(const int itemId, const short region) {
+        if (region == SaveData::USA || itemId < SaveData::ITEM_ID_SPECIAL3 || itemId > SaveData::ITEM_ID_CURE_AMPOULE + 1) {
+            return itemId;
+        }
+
+        return (itemId == SaveData::ITEM_ID_SPECIAL3) ? SaveData::ITEM_ID_NOTHING : itemId - 1;
+    }
+
+    /**
+     * @brief ID that an item of the USA version has in the given region. 0 if the item doesn't exist there.
+     */
+    constexpr int getRegionItemId(const int usaItemId, const short region) {
+        if (region == SaveData::USA || usaItemId < SaveData::ITEM_ID_ROAST_CHICKEN || usaItemId > SaveData::ITEM_ID_POUT_POURRI) {
+            return usaItemId;
+        }
+
+        return (usaItemId == SaveData::ITEM_ID_POUT_POURRI) ? SaveData::ITEM_ID_NOTHING : usaItemId + 1;
+    }
+
+    /**
+     * @brief ID that an item of "fromRegion" has in "toRegion". 0 if the item doesn't exist there.
+     * The JPN and PAL versions have the same items.
+     */
+    constexpr int convertItemId(const int itemId, const short fromRegion, const short toRegion) {
+        if ((fromRegion == SaveData::USA) == (toRegion == SaveData::USA)) {
+            return itemId;
+        }
+
+        return (fromRegion == SaveData::USA) ? getRegionItemId(itemId, toRegion) : getUsaItemId(itemId, fromRegion);
+    }
+
+    /**
+     * @brief Builds the shuffle mask that moves the items array of a "fromRegion" save to where "toRegion" saves keep each item.
+     *
+     * @note Item ID "n" is stored at "items[n - 1]" (see "SaveData::getItem()").
+     */
+    constexpr ItemsMask makeItemsMask(const short fromRegion, const short toRegion) {
+        ItemsMask mask {};
+
+        for (unsigned int i = 0; i < mask.size(); i++) {
+            const int fromItemId = convertItemId(i + 1, toRegion, fromRegion);
+
+            if (fromItemId == SaveData::ITEM_ID_NOTHING) {
+                mask[i] = ByteSwap::ZERO_BYTE;
+            }
+            else {
+                mask[i] = static_cast<quint8>((fromItemId - 1) % ByteSwap::BLOCK_SIZE);
+            }
+        }
+
+        return mask;
+    }
+
+    /**
+     * @brief Checks that no item moves to a different shuffle block, since the shuffle only works within each block.
+     */
+    constexpr bool itemsStayInTheirBlock(const short fromRegion, const short toRegion) {
+        for (int i = 0; i < SIZE_ITEMS_ARRAY; i++) {
+            const int fromItemId = convertItemId(i + 1, toRegion, fromRegion);
+
+            if (fromItemId != SaveData::ITEM_ID_NOTHING && ((fromItemId - 1) / ByteSwap::BLOCK_SIZE) != (i / ByteSwap::BLOCK_SIZE)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Items masks for every pair of regions, indexed as [fromRegion][toRegion].
+     */
+    inline constexpr std::array<std::array<ItemsMask, NUM_REGIONS>, NUM_REGIONS> ITEMS_MASKS = {{
+        {makeItemsMask(SaveData::USA, SaveData::USA), makeItemsMask(SaveData::USA, SaveData::JPN), makeItemsMask(SaveData::USA, SaveData::PAL)},
+        {makeItemsMask(SaveData::JPN, SaveData::USA), makeItemsMask(SaveData::JPN, SaveData::JPN), makeItemsMask(SaveData::JPN, SaveData::PAL)},
+        {makeItemsMask(SaveData::PAL, SaveData::USA), makeItemsMask(SaveData::PAL, SaveData::JPN), makeItemsMask(SaveData::PAL, SaveData::PAL)}
+    }};
+
+    static_assert(itemsStayInTheirBlock(SaveData::USA, SaveData::JPN) && itemsStayInTheirBlock(SaveData::JPN, SaveData::USA),
+                  "Region-specific items must stay within the same shuffle block");
+    static_assert(getRegionItemId(SaveData::ITEM_ID_CURE_AMPOULE, SaveData::PAL) == SaveData::ITEM_ID_CURE_AMPOULE + 1,
+                  "Consumable items are shifted by +1 in the JPN and PAL versions");
+
+    void convertSaveData(SaveData& saveData, const short fromRegion, const short toRegion);
+    void convertSaveSlots(SaveSlot* saveSlots, const std::size_t numSlots, const short fromRegion, const short toRegion);
+}
+
+#endif // REGIONCONVERSION_H
@@ -0,0 +1,440 @@
+#ifndef SAVEDATASCHEMA_H
+#define SAVEDATASCHEMA_H
+
+/**
+ * @file SaveDataSchema.h
+ * @brief Compile-time description of the SaveData layout
+ *
+ * This header contains a table describing every field of the SaveData struct (name, offset, size, signedness,
+ * and the regions whose saves contain it). Everything that needs to go through all fields of a save
+ * (the binary encoder / decoder, the database JSON conversion, etc) is driven by this table,
+ * so adding a field to SaveData only requires adding it here.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Save.h"
+#include "include/file/ByteSwap.h"
+#include <array>        // std::array
+#include <cstddef>      // offsetof, std::size_t
+#include <cstring>      // memcpy, memset
+#include <string_view>  // std::string_view
+#include <type_traits>  // std::remove_all_extents_t, std::is_signed_v
+#include <utility>      // std::index_sequence
+
+namespace SaveDataSchema {
+    /**
+     * @brief Bitmask of the regions whose saves contain a given field
+     */
+    enum eRegionMask {
+        REGION_MASK_USA = BIT(SaveData::USA),
+        REGION_MASK_JPN = BIT(SaveData::JPN),
+        REGION_MASK_PAL = BIT(SaveData::PAL),
+        REGION_MASK_ALL = REGION_MASK_USA | REGION_MASK_JPN | REGION_MASK_PAL
+    };
+
+    /**
+     * @brief Description of a single SaveData field
+     */
+    struct Field {
+        const char* name;           /**< Name of the SaveData member. Also used as the key in JSON documents */
+        unsigned int structOffset;  /**< Offset of the member within the SaveData struct */
+        unsigned int size;          /**< Size of each element, in bytes (1, 2 or 4) */
+        unsigned int count;         /**< Number of elements (greater than 1 for arrays) */
+        bool isSigned;              /**< If true, the field holds signed values */
+        unsigned int regionMask;    /**< Regions whose saves contain this field (see "eRegionMask") */
+
+        constexpr bool isInRegion(const short region) const {
+            return BITS_HAS(regionMask, BIT(region)) != 0;
+        }
+
+        constexpr unsigned int getTotalSize() const {
+            return size * count;
+        }
+    };
+}
+
+/**
+ * Builds a "SaveDataSchema::Field" entry from a SaveData member, taking its offset, size and signedness directly from Save.h.
+ */
+#define SAVEDATA_FIELD(member, regionMask)                                                             \
+    SaveDataSchema::Field {                                                                             \
+        #member,                                                                                        \
+        offsetof(SaveData, member),                                                                     \
+        sizeof(std::remove_all_extents_t<decltype(SaveData::member)>),                                  \
+        sizeof(SaveData::member) / sizeof(std::remove_all_extents_t<decltype(SaveData::member)>),       \
+        std::is_signed_v<std::remove_all_extents_t<decltype(SaveData::member)>>,                        \
+        regionMask                                                                                      \
+    }
+
+namespace SaveDataSchema {
+    /**
+     * All the SaveData fields, in the same order they're stored in the save files.
+     */
+    inline constexpr Field FIELDS[] = {
+        SAVEDATA_FIELD(event_flags,                          REGION_MASK_ALL),
+        SAVEDATA_FIELD(flags,                                REGION_MASK_ALL),
+        SAVEDATA_FIELD(week,                                 REGION_MASK_ALL),
+        SAVEDATA_FIELD(day,                                  REGION_MASK_ALL),
+        SAVEDATA_FIELD(hour,                                 REGION_MASK_ALL),
+        SAVEDATA_FIELD(minute,                               REGION_MASK_ALL),
+        SAVEDATA_FIELD(seconds,                              REGION_MASK_ALL),
+        SAVEDATA_FIELD(milliseconds,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(gameplay_framecount,                  REGION_MASK_ALL),
+        SAVEDATA_FIELD(button_config,                        REGION_MASK_ALL),
+        SAVEDATA_FIELD(sound_mode,                           REGION_MASK_ALL),
+        SAVEDATA_FIELD(language,                             REGION_MASK_PAL),
+        SAVEDATA_FIELD(padding5A_PAL,                        REGION_MASK_PAL),
+        SAVEDATA_FIELD(character,                            REGION_MASK_ALL),
+        SAVEDATA_FIELD(life,                                 REGION_MASK_ALL),
+        SAVEDATA_FIELD(field_0x5C,                           REGION_MASK_ALL),
+        SAVEDATA_FIELD(subweapon,                            REGION_MASK_ALL),
+        SAVEDATA_FIELD(gold,                                 REGION_MASK_ALL),
+        SAVEDATA_FIELD(items,                                REGION_MASK_ALL),
+        SAVEDATA_FIELD(player_status,                        REGION_MASK_ALL),
+        SAVEDATA_FIELD(health_depletion_rate_while_poisoned, REGION_MASK_ALL),
+        SAVEDATA_FIELD(current_hour_VAMP,                    REGION_MASK_ALL),
+        SAVEDATA_FIELD(map,                                  REGION_MASK_ALL),
+        SAVEDATA_FIELD(spawn,                                REGION_MASK_ALL),
+        SAVEDATA_FIELD(save_crystal_number,                  REGION_MASK_ALL),
+        SAVEDATA_FIELD(field51_0xb2,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field52_0xb3,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(time_saved_counter,                   REGION_MASK_ALL),
+        SAVEDATA_FIELD(death_counter,                        REGION_MASK_ALL),
+        SAVEDATA_FIELD(field55_0xbc,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field59_0xc0,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field63_0xc4,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field67_0xc8,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field69_0xca,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field71_0xcc,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field75_0xd0,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field77_0xd2,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field79_0xd4,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(field83_0xd8,                         REGION_MASK_ALL),
+        SAVEDATA_FIELD(gold_spent_on_Renon,                  REGION_MASK_ALL)
+    };
+
+    inline constexpr std::size_t NUM_FIELDS = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+    /**
+     * @brief Offset of a field within the save data stored in a file of the given region.
+     *
+     * Fields that aren't present in a region don't take up any space in its files,
+     * so every field after them is shifted back.
+     */
+    constexpr unsigned int getFileOffset(const std::size_t fieldIndex, const short region) {
+        unsigned int offset = 0;
+
+        for (std::size_t i = 0; i < fieldIndex; i++) {
+            if (FIELDS[i].isInRegion(region)) {
+                offset += FIELDS[i].getTotalSize();
+            }
+        }
+
+        return offset;
+    }
+
+    /**
+     * @brief Size the SaveData struct takes up inside a file of the given region.
+     */
+    constexpr unsigned int getSaveDataSize(const short region) {
+        return getFileOffset(NUM_FIELDS, region);
+    }
+
+    /**
+     * @brief Index of the field with the given name within "FIELDS". Returns "NUM_FIELDS" if there's no such field.
+     */
+    constexpr std::size_t getFieldIndex(const std::string_view name) {
+        for (std::size_t i = 0; i < NUM_FIELDS; i++) {
+            if (name == FIELDS[i].name) {
+                return i;
+            }
+        }
+
+        return NUM_FIELDS;
+    }
+
+    /**
+     * @brief Returns the field with the given member name. The name must exist in the table.
+     */
+    constexpr const Field& getField(const std::string_view name) {
+        return FIELDS[getFieldIndex(name)];
+    }
+
+    /**
+     * @brief Checks that the table lists every SaveData member in order, without gaps or overlaps.
+     */
+    constexpr bool fieldsMatchSaveData() {
+        unsigned int offset = 0;
+
+        for (std::size_t i = 0; i < NUM_FIELDS; i++) {
+            if (FIELDS[i].structOffset != offset ||
+                (FIELDS[i].size != 1 && FIELDS[i].size != 2 && FIELDS[i].size != 4)) {
+                return false;
+            }
+
+            offset += FIELDS[i].getTotalSize();
+        }
+
+        return offset == sizeof(SaveData);
+    }
+
+    static_assert(fieldsMatchSaveData(), "SaveDataSchema::FIELDS must list every SaveData member, in the same order as in Save.h");
+    static_assert(getSaveDataSize(SaveData::PAL) == sizeof(SaveData), "This project uses the PAL definition of SaveData");
+    static_assert(getSaveDataSize(SaveData::USA) == 0xE0, "USA saves are 0xE0 bytes long");
+    static_assert(getSaveDataSize(SaveData::JPN) == 0xE0, "JPN saves are 0xE0 bytes long");
+
+    /**
+     * @brief Size the SaveSlot struct takes up inside a file of the given region (without padding).
+     */
+    constexpr unsigned int getSaveSlotSize(const short region) {
+        return (getSaveDataSize(region) * 2) + sizeof(SaveSlot::checksum1) + sizeof(SaveSlot::checksum2);
+    }
+
+    /**
+     * @brief Checks that every field element is naturally aligned inside a file of the given region,
+     * so none of them crosses a shuffle block (see ByteSwap.h).
+     */
+    constexpr bool fieldsAreAligned(const short region) {
+        for (std::size_t i = 0; i < NUM_FIELDS; i++) {
+            if (FIELDS[i].isInRegion(region) && (getFileOffset(i, region) % FIELDS[i].size) != 0) {
+                return false;
+            }
+        }
+
+        return (getSaveDataSize(region) % sizeof(quint32)) == 0 && (ByteSwap::BLOCK_SIZE % sizeof(quint32)) == 0;
+    }
+
+    static_assert(fieldsAreAligned(SaveData::USA) && fieldsAreAligned(SaveData::JPN) && fieldsAreAligned(SaveData::PAL),
+                  "Every SaveData field must be naturally aligned within the save files");
+
+    /**
+     * @brief Marks the "size" bytes at "offset" of a shuffle mask as a single element to be byte-swapped.
+     */
+    template<std::size_t maskSize>
+    constexpr void setSwapMaskElement(std::array<quint8, maskSize>& mask, const unsigned int offset, const unsigned int size) {
+        const unsigned int blockStart = offset - (offset % ByteSwap::BLOCK_SIZE);
+
+        for (unsigned int i = 0; i < size; i++) {
+            mask[offset + i] = static_cast<quint8>(offset + size - 1 - i - blockStart);
+        }
+    }
+
+    /**
+     * @brief Builds the shuffle mask that converts "numSaveData" consecutive save data entries of the given region,
+     * followed by "numWords" 32-bit words, between big endian and the host's byte order in a single pass.
+     */
+    template<short region, unsigned int numSaveData, unsigned int numWords>
+    constexpr auto makeSwapMask() {
+        constexpr unsigned int dataSize = (getSaveDataSize(region) * numSaveData) + (numWords * sizeof(quint32));
+        std::array<quint8, ByteSwap::getMaskSize(dataSize)> mask {};
+
+        for (unsigned int i = 0; i < mask.size(); i++) {
+            mask[i] = static_cast<quint8>(i % ByteSwap::BLOCK_SIZE);
+        }
+
+        unsigned int offset = 0;
+
+        for (unsigned int n = 0; n < numSaveData; n++) {
+            for (std::size_t i = 0; i < NUM_FIELDS; i++) {
+                if (!FIELDS[i].isInRegion(region)) {
+                    continue;
+                }
+
+                for (unsigned int j = 0; j < FIELDS[i].count; j++) {
+                    setSwapMaskElement(mask, offset, FIELDS[i].size);
+                    offset += FIELDS[i].size;
+                }
+            }
+        }
+
+        for (unsigned int n = 0; n < numWords; n++) {
+            setSwapMaskElement(mask, offset, sizeof(quint32));
+            offset += sizeof(quint32);
+        }
+
+        return mask;
+    }
+
+    /**
+     * Shuffle masks for the raw data of the given region.
+     * "SAVE_DATA" covers a single SaveData entry, and "SAVE_SLOT" covers a whole slot (both entries and both checksums).
+     */
+    template<short region>
+    struct SwapMasks {
+        static constexpr auto SAVE_DATA = makeSwapMask<region, 1, 0>();
+        static constexpr auto SAVE_SLOT = makeSwapMask<region, 2, 2>();
+    };
+
+    /**
+     * @brief Copies a single field from host-endian file data into "saveData". Fields that aren't present in the region are zeroed.
+     */
+    template<short region, std::size_t fieldIndex>
+    inline void unpackField(const char* data, SaveData& saveData) {
+        constexpr Field field = FIELDS[fieldIndex];
+        char* member = reinterpret_cast<char*>(&saveData) + field.structOffset;
+
+        if constexpr (field.isInRegion(region)) {
+            memcpy(member, data + getFileOffset(fieldIndex, region), field.getTotalSize());
+        }
+        else {
+            memset(member, 0, field.getTotalSize());
+        }
+    }
+
+    /**
+     * @brief Copies a single field from "saveData" into host-endian file data. Fields that aren't present in the region are skipped.
+     */
+    template<short region, std::size_t fieldIndex>
+    inline void packField(const SaveData& saveData, char* data) {
+        constexpr Field field = FIELDS[fieldIndex];
+
+        if constexpr (field.isInRegion(region)) {
+            const char* member = reinterpret_cast<const char*>(&saveData) + field.structOffset;
+            memcpy(data + getFileOffset(fieldIndex, region), member, field.getTotalSize());
+        }
+    }
+
+    template<short region, std::size_t... fieldIndices>
+    inline void unpack(const char* data, SaveData& saveData, std::index_sequence<fieldIndices...>) {
+        (unpackField<region, fieldIndices>(data, saveData), ...);
+    }
+
+    template<short region, std::size_t... fieldIndices>
+    inline void pack(const SaveData& saveData, char* data, std::index_sequence<fieldIndices...>) {
+        (packField<region, fieldIndices>(saveData, data), ...);
+    }
+
+    /**
+     * @brief Moves every field of host-endian file data of the given region to its place in the SaveData struct.
+     */
+    template<short region>
+    inline void unpack(const char* data, SaveData& saveData) {
+        unpack<region>(data, saveData, std::make_index_sequence<NUM_FIELDS>());
+    }
+
+    /**
+     * @brief Moves every field of the SaveData struct to its place in host-endian file data of the given region.
+     */
+    template<short region>
+    inline void pack(const SaveData& saveData, char* data) {
+        pack<region>(saveData, data, std::make_index_sequence<NUM_FIELDS>());
+    }
+
+    /**
+     * @brief Decodes the save data stored in a file of the given region into "saveData".
+     *
+     * The raw data is converted to the host's byte order in one pass, and then every field is copied
+     * with constant offsets, since the whole table is known at compile time.
+     *
+     * @note "data" must be at least "getSaveDataSize(region)" bytes long.
+     */
+    template<short region>
+    inline void decode(const char* data, SaveData& saveData) {
+        char hostData[ByteSwap::getMaskSize(sizeof(SaveData))];
+
+        ByteSwap::convertBigEndian(data, hostData, getSaveDataSize(region), SwapMasks<region>::SAVE_DATA.data());
+        unpack<region>(hostData, saveData);
+    }
+
+    /**
+     * @brief Encodes "saveData" in the layout used by files of the given region.
+     *
+     * @note "data" must be at least "getSaveDataSize(region)" bytes long.
+     */
+    template<short region>
+    inline void encode(const SaveData& saveData, char* data) {
+        pack<region>(saveData, data);
+        ByteSwap::convertBigEndian(data, data, getSaveDataSize(region), SwapMasks<region>::SAVE_DATA.data());
+    }
+
+    /**
+     * @brief Decodes a whole save slot (both save data entries and both checksums) stored in a file of the given region,
+     * converting its byte order in a single pass.
+     *
+     * @note "data" must be at least "getSaveSlotSize(region)" bytes long.
+     */
+    template<short region>
+    inline void decodeSaveSlot(const char* data, SaveSlot& slot) {
+        constexpr unsigned int saveDataSize = getSaveDataSize(region);
+        char hostData[ByteSwap::getMaskSize(sizeof(SaveSlot))];
+
+        ByteSwap::convertBigEndian(data, hostData, getSaveSlotSize(region), SwapMasks<region>::SAVE_SLOT.data());
+        unpack<region>(hostData, slot.mainSave);
+        unpack<region>(hostData + saveDataSize, slot.beginningOfStage);
+        memcpy(&slot.checksum1, hostData + (saveDataSize * 2), sizeof(slot.checksum1));
+        memcpy(&slot.checksum2, hostData + (saveDataSize * 2) + sizeof(slot.checksum1), sizeof(slot.checksum2));
+    }
+
+    /**
+     * @brief Encodes a whole save slot (both save data entries and both checksums) in the layout used by files of the given region.
+     *
+     * @note "data" must be at least "getSaveSlotSize(region)" bytes long.
+     */
+    template<short region>
+    inline void encodeSaveSlot(const SaveSlot& slot, char* data) {
+        constexpr unsigned int saveDataSize = getSaveDataSize(region);
+
+        pack<region>(slot.mainSave, data);
+        pack<region>(slot.beginningOfStage, data + saveDataSize);
+        memcpy(data + (saveDataSize * 2), &slot.checksum1, sizeof(slot.checksum1));
+        memcpy(data + (saveDataSize * 2) + sizeof(slot.checksum1), &slot.checksum2, sizeof(slot.checksum2));
+        ByteSwap::convertBigEndian(data, data, getSaveSlotSize(region), SwapMasks<region>::SAVE_SLOT.data());
+    }
+
+    /**
+     * @brief Reads element "index" of a field from "saveData", sign-extending it if the field is signed.
+     */
+    inline qint64 getFieldValue(const SaveData& saveData, const Field& field, const unsigned int index = 0) {
+        const char* member = reinterpret_cast<const char*>(&saveData) + field.structOffset + (index * field.size);
+
+        switch (field.size) {
+            case 1: {
+                quint8 value;
+                memcpy(&value, member, sizeof(value));
+                return field.isSigned ? static_cast<qint64>(static_cast<qint8>(value)) : value;
+            }
+
+            case 2: {
+                quint16 value;
+                memcpy(&value, member, sizeof(value));
+                return field.isSigned ? static_cast<qint64>(static_cast<qint16>(value)) : value;
+            }
+
+            default: {
+                quint32 value;
+                memcpy(&value, member, sizeof(value));
+                return field.isSigned ? static_cast<qint64>(static_cast<qint32>(value)) : value;
+            }
+        }
+    }
+
+    /**
+     * @brief Writes element "index" of a field into "saveData". The value is truncated to the size of the field.
+     */
+    inline void setFieldValue(SaveData& saveData, const Field& field, const qint64 value, const unsigned int index = 0) {
+        char* member = reinterpret_cast<char*>(&saveData) + field.structOffset + (index * field.size);
+
+        switch (field.size) {
+            case 1: {
+                const quint8 rawValue = static_cast<quint8>(value);
+                memcpy(member, &rawValue, sizeof(rawValue));
+                break;
+            }
+
+            case 2: {
+                const quint16 rawValue = static_cast<quint16>(value);
+                memcpy(member, &rawValue, sizeof(rawValue));
+                break;
+            }
+
+            default: {
+                const quint32 rawValue = static_cast<quint32>(value);
+                memcpy(member, &rawValue, sizeof(rawValue));
+                break;
+            }
+        }
+    }
+}
+
+#endif
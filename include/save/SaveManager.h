@@ -21,6 +21,37 @@
  */
 class SaveManager {
     public:
+        /**
+         * Both checksums of a single save slot, as stored in the SaveSlot struct.
+         * See "calcChecksums()".
+         */
+        struct SaveSlotChecksums {
+            unsigned int checksum1 = 0;
+            unsigned int checksum2 = 0;
+        };
+
+        /**
+         * @brief Result of checking the checksums stored in a file against the data they protect
+         */
+        enum eChecksumStatus {
+            CHECKSUM_STATUS_UNVERIFIED,   // The slot wasn't loaded from a file, or it was replaced afterwards
+            CHECKSUM_STATUS_VALID,        // Both stored checksums match the data
+            CHECKSUM_STATUS_INVALID,      // At least one of the stored checksums doesn't match the data
+            CHECKSUM_STATUS_NOT_COVERED   // The data isn't protected by any of the stored checksums
+        };
+
+        /**
+         * Checksum status of a single save slot. It gets filled in when a file is loaded or saved.
+         *
+         * @note The game only calculates the checksums from the main save,
+         * so the beginning of stage save is reported as "CHECKSUM_STATUS_NOT_COVERED" once verified.
+         */
+        struct SaveSlotStatus {
+            short mainSave = CHECKSUM_STATUS_UNVERIFIED;
+            short beginningOfStage = CHECKSUM_STATUS_UNVERIFIED;
+            SaveSlotChecksums calculatedChecksums;  /**< Checksums calculated from the slot's data in the file */
+        };
+
         // Singleton-related functions
         static SaveManager* getInstance() {
             if (instance == nullptr) {
@@ -82,6 +113,8 @@ class SaveManager {
         void unassignEventFlags(const int, const unsigned int);
         unsigned int calcFirstChecksum(const QByteArray&);
         unsigned int calcSecondChecksum(const QByteArray&);
+        static void calcChecksums(const char* rawData, const unsigned int saveDataSize, const unsigned int stride,
+                                  const unsigned int numSlots, SaveSlotChecksums* checksums);
         bool areAllSavesDisabled();
 
         SaveSlot& getSaveSlot(const int index) {
@@ -89,7 +122,7 @@ class SaveManager {
         }
 
         SaveSlot& getCurrentSaveSlot() {
-            return saves[currentSave];
+            return getSaveSlot(currentSave);
         }
 
         SaveData& getSave(const int index, const bool isMain) {
@@ -105,9 +138,26 @@ class SaveManager {
         }
 
         void setSaveSlot(const SaveSlot& save, const int index) {
+            saveSlotStatus[index] = SaveSlotStatus();
             saves[index] = save;
         }
 
+        // Checksum verification functions
+        const SaveSlotStatus& getSaveSlotStatus(const int index) const {
+            return saveSlotStatus[index];
+        }
+
+        void setSaveSlotStatus(const int index, const SaveSlotStatus& status) {
+            saveSlotStatus[index] = status;
+        }
+
+        bool hasInvalidSaveSlots() const;
+
+        // Dirty save slot tracking functions
+        bool isSaveSlotDirty(const int index) const;
+        bool hasCleanSaveSlots() const;
+        void markSaveSlotsClean();
+
         void clear();
         void assignDefaultValues();
 
@@ -121,6 +171,16 @@ class SaveManager {
 
         SaveSlot saves[NUM_SAVES];
         short region = SaveData::USA;
+
+        SaveSlotStatus saveSlotStatus[NUM_SAVES];  /**< Checksum status of each slot (see "SaveSlotStatus") */
+
+        /**
+         * Each save slot as it's stored in the file that was opened (or written) last (see "markSaveSlotsClean()").
+         * Slots that differ from their clean copy are the only ones that need to be written back (see "isSaveSlotDirty()").
+         * "cleanSavesRegion" is the region of that file, or -1 if the saves didn't come from a file.
+         */
+        SaveSlot cleanSaves[NUM_SAVES];
+        short cleanSavesRegion = -1;
 };
 
 #endif
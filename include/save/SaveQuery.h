@@ -0,0 +1,98 @@
+#ifndef SAVEQUERY_H
+#define SAVEQUERY_H
+
+/**
+ * @file SaveQuery.h
+ * @brief Predicates over the fields of a save, written as text
+ *
+ * A query is a boolean expression over the SaveData fields (see SaveDataSchema.h), for example:
+ *
+ *     map == TENSHU and character == CARRIE and HARD and gold > 50000
+ *
+ * - Fields are compared with ==, !=, <, <=, > and >=. Array elements are written as "name[index]" (i.e. "items[0]").
+ * - "field & mask" tests bits (i.e. "event_flags[6] & 0x8000000"). A field (or a bit test) on its own is true if it isn't 0.
+ * - Values are numbers (decimal or hexadecimal), or the names of the SaveData enums (MapID, PlayerCharacterID, SubweaponID...).
+ * - The names of the "SaveFlag" and "PlayerStatus" bits, on their own, test the bit in "flags" and "player_status" respectively.
+ *   Their prefixes are optional, so "HARD" is the same as "SAVE_FLAG_HARD", and "VAMP" the same as "PLAYER_FLAG_VAMP".
+ * - Conditions are combined with "and" (&&), "or" (||), "not" (!) and parentheses.
+ *
+ * Names aren't case-sensitive. The expression is parsed once, and can then be evaluated on any number of saves from any thread,
+ * either one save at a time (see "matches()") or over whole columns of saves at once (see "matchColumns()", used by the SaveIndex).
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Save.h"
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <vector>
+
+/**
+ * @class SaveQuery
+ * @brief Parsed query, ready to be evaluated on saves (see "matches()")
+ */
+class SaveQuery {
+    public:
+        /**
+         * Set of rows of a column store, one bit per row (bit "row % 64" of word "row / 64").
+         */
+        typedef std::vector<quint64> RowSet;
+
+        /**
+         * Returns the values of element "elementIndex" of the field "fieldIndex" (see "SaveDataSchema::FIELDS") for every row,
+         * one after another, each stored in the host's byte order with the size and signedness of the field.
+         */
+        typedef std::function<const void*(const unsigned int fieldIndex, const unsigned int elementIndex)> ColumnGetter;
+
+        SaveQuery() {}
+
+        int parse(const QString& expression);
+        bool matches(const SaveData& saveData) const;
+        RowSet matchColumns(const ColumnGetter& getColumn, const quint32 numRows) const;
+
+        inline bool isEmpty() const { return nodes.empty(); }
+        inline const QString& getLastError() const { return lastError; }
+
+    private:
+        enum eNodeType {
+            NODE_AND,
+            NODE_OR,
+            NODE_NOT,
+            NODE_COMPARISON
+        };
+
+        enum eComparison {
+            COMPARISON_NOT_ZERO,
+            COMPARISON_EQUAL,
+            COMPARISON_NOT_EQUAL,
+            COMPARISON_LESS,
+            COMPARISON_LESS_EQUAL,
+            COMPARISON_GREATER,
+            COMPARISON_GREATER_EQUAL
+        };
+
+        /**
+         * A node of the expression tree. Nodes reference their operands by their index in "nodes".
+         */
+        struct Node {
+            int type = NODE_COMPARISON;     // See "eNodeType"
+            int left = -1;                  // NODE_AND, NODE_OR and NODE_NOT: First operand
+            int right = -1;                 // NODE_AND and NODE_OR: Second operand
+            unsigned int fieldIndex = 0;    // NODE_COMPARISON: Index of the field in "SaveDataSchema::FIELDS"
+            unsigned int elementIndex = 0;  // NODE_COMPARISON: Element of the field, for arrays
+            qint64 mask = -1;               // NODE_COMPARISON: Bits of the field that are compared (all of them by default)
+            int comparison = COMPARISON_NOT_ZERO;   // See "eComparison"
+            qint64 value = 0;
+        };
+
+        class Parser;
+
+        bool evaluate(const int nodeIndex, const SaveData& saveData) const;
+        RowSet evaluateColumns(const int nodeIndex, const ColumnGetter& getColumn, const quint32 numRows) const;
+
+        std::vector<Node> nodes;    /**< The root node is the last one */
+        QString lastError;
+};
+
+#endif // SAVEQUERY_H
@@ -0,0 +1,110 @@
+#ifndef SLOTCODEC_H
+#define SLOTCODEC_H
+
+/**
+ * @file SlotCodec.h
+ * @brief Save slot codec specialized for each region at compile time
+ *
+ * "SlotCodec<region>" bundles the SaveDataSchema.h encoders and decoders of a single region, along with the sizes of its
+ * save data and save slots, so every entry point is straight-line code with constant offsets and sizes.
+ *
+ * The region of a file is only known at runtime, so the codec is picked once when the file is opened
+ * (see "SlotCodecTable::get()"), and every slot of that file is then decoded and encoded through the same table,
+ * instead of checking the region again for every slot or field.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Save.h"
+#include "include/save/SaveDataSchema.h"
+
+/**
+ * Encoders and decoders of the save slots of a single region.
+ */
+template<short region>
+struct SlotCodec {
+    static constexpr short REGION = region;
+    static constexpr unsigned int SAVE_DATA_SIZE = SaveDataSchema::getSaveDataSize(region);
+    static constexpr unsigned int SAVE_SLOT_SIZE = SaveDataSchema::getSaveSlotSize(region);
+
+    /**
+     * @note "data" must be at least "SAVE_SLOT_SIZE" bytes long.
+     */
+    static void decodeSaveSlot(const char* data, SaveSlot& slot) {
+        SaveDataSchema::decodeSaveSlot<region>(data, slot);
+    }
+
+    /**
+     * @note "data" must be at least "SAVE_SLOT_SIZE" bytes long.
+     */
+    static void encodeSaveSlot(const SaveSlot& slot, char* data) {
+        SaveDataSchema::encodeSaveSlot<region>(slot, data);
+    }
+
+    /**
+     * @note "data" must be at least "SAVE_DATA_SIZE" bytes long.
+     */
+    static void decodeSaveData(const char* data, SaveData& saveData) {
+        SaveDataSchema::decode<region>(data, saveData);
+    }
+
+    /**
+     * @note "data" must be at least "SAVE_DATA_SIZE" bytes long.
+     */
+    static void encodeSaveData(const SaveData& saveData, char* data) {
+        SaveDataSchema::encode<region>(saveData, data);
+    }
+};
+
+/**
+ * Entry points and sizes of the "SlotCodec" of a single region, so the region only has to be checked once per file.
+ */
+struct SlotCodecTable {
+    short region;
+    unsigned int saveDataSize;
+    unsigned int saveSlotSize;
+    void (*decodeSaveSlot)(const char* data, SaveSlot& slot);
+    void (*encodeSaveSlot)(const SaveSlot& slot, char* data);
+    void (*decodeSaveData)(const char* data, SaveData& saveData);
+    void (*encodeSaveData)(const SaveData& saveData, char* data);
+
+    template<short region>
+    static constexpr SlotCodecTable make() {
+        typedef SlotCodec<region> Codec;
+
+        return SlotCodecTable {
+            Codec::REGION,
+            Codec::SAVE_DATA_SIZE,
+            Codec::SAVE_SLOT_SIZE,
+            &Codec::decodeSaveSlot,
+            &Codec::encodeSaveSlot,
+            &Codec::decodeSaveData,
+            &Codec::encodeSaveData
+        };
+    }
+
+    static const SlotCodecTable& get(const short region);
+};
+
+namespace SlotCodecTables {
+    /**
+     * Codec tables of every region, indexed by region.
+     */
+    inline constexpr SlotCodecTable TABLES[] = {
+        SlotCodecTable::make<SaveData::USA>(),
+        SlotCodecTable::make<SaveData::JPN>(),
+        SlotCodecTable::make<SaveData::PAL>()
+    };
+
+    static_assert(TABLES[SaveData::USA].region == SaveData::USA && TABLES[SaveData::JPN].region == SaveData::JPN &&
+                  TABLES[SaveData::PAL].region == SaveData::PAL, "Codec tables must be indexed by region");
+}
+
+/**
+ * @brief Returns the codec table of the given region. Unknown regions get the USA codec.
+ */
+inline const SlotCodecTable& SlotCodecTable::get(const short region) {
+    return SlotCodecTables::TABLES[(region >= SaveData::USA && region <= SaveData::PAL) ? region : static_cast<short>(SaveData::USA)];
+}
+
+#endif // SLOTCODEC_H
@@ -9,6 +9,7 @@
  */
 
 #include "ui_ControllerPakSelectionwindow.h"
+#include "include/file/FileManager.h"
 #include <QDialog>
 
 namespace Ui {
@@ -31,11 +32,11 @@ public:
     bool userClosedWithX = false;
 
     // Constructors and destructor
-    explicit ControllerPakSelectionWindow(QWidget *parent = nullptr);
+    explicit ControllerPakSelectionWindow(const std::vector<FileManager::ControllerPakNotetableData>& noteTableData, QWidget *parent = nullptr);
     ~ControllerPakSelectionWindow();
 
     // Setup functions
-    void setupButtonBox();
+    void setupButtonBox(const std::vector<FileManager::ControllerPakNotetableData>& noteTableData);
 
     // Interface event handling functions
     void onButtonClicked(int saveIndex);
@@ -43,8 +44,16 @@ public:
     // Helper functions
     QString getRegionName(const short region) const;
 
+    /**
+     * @brief Index of the save chosen by the user (see "FileManager::setNoteSelector()"). -1 if none was chosen.
+     */
+    int getSelectedSaveIndex() const {
+        return selectedSaveIndex;
+    }
+
 private:
     Ui::ControllerPakSelectionWindow* ui;
+    int selectedSaveIndex = -1;
 
 protected:
     /**
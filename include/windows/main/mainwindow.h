@@ -11,6 +11,7 @@
 #include "ui_MainWindow.h"
 #include "include/bit.h"
 #include "include/save/Save.h"
+#include "include/file/FileLoader.h"
 #include "include/windows/ComboBoxData.h"
 
 #include <QMainWindow>
@@ -72,6 +73,7 @@ private slots:
     void fileSaveMenu();
     void fileSaveAsMenu();
     void databaseMenu();
+    void repairChecksumsMenu();
     void onPageButtonClicked(QStackedWidget* stackedWidget, const QWidget* page);
     void openFile(const QString& filename);
     void onCopy(QWidget* parent);
@@ -82,6 +84,7 @@ private slots:
     // Helper functions
     void switchPage(QStackedWidget* stackedWidgetPages, const QWidget* page);
     void checkMandragoraAndNitroLineEdits();
+    void warnAboutInvalidChecksums();
     void selectComboBoxOption(QComboBox& comboBox, const QVariant data);
     void enableUIComponents(bool);
     void updateCheckboxEnabledVisibility();
@@ -107,6 +110,18 @@ private slots:
     }
 
 private:
+    /**
+     * @brief Result of decoding a file in the background (see "decodeFileInBackground()")
+     */
+    struct DecodedFileResult {
+        int status = -1;
+        FileLoader::DecodedFile decodedFile;
+    };
+
+    // Background file loading functions
+    void decodeFileInBackground(const QString& filename, const FileLoader::LoadContext& context);
+    void onFileDecoded(const QString& filename, const FileLoader::LoadContext& context, const DecodedFileResult& result);
+
     Ui::MainWindow* ui;
 
     /**< The array of line edits that appear in the "Event Flags" page */
@@ -0,0 +1,40 @@
+# ============================================================================
+# ppp-cli.pro
+#
+# Project file of the command-line tool (ppp-cli), which validates, converts, dumps and repairs saves in batches
+# without any window (see src/cli/CliMain.cpp). It's built on the same save handling core as the main program
+# (libppp-core, see ppp-core.pro), and uses Qt's concurrent library to process several files at the same time.
+# It uses the C++ 17 standard.
+#
+# It's built along with everything else from PPP.pro.
+# ============================================================================
+
+TARGET = ppp-cli
+TEMPLATE = app
+
+# Extra Qt needed libraries. The tool doesn't use any window, so it doesn't need the GUI nor widgets libraries
+QT       = core concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Every project is built from the same directory, so each one keeps its intermediate files apart
+OBJECTS_DIR = $$OUT_PWD/.obj/$$TARGET
+MOC_DIR = $$OUT_PWD/.moc/$$TARGET
+
+# Save handling core (file loaders, save slots, checksums, conversions and database access)
+include(ppp-core.pri)
+
+# Source code files
+SOURCES += \
+    src/cli/CliMain.cpp \
+    src/cli/CliCommands.cpp
+
+# Header files
+HEADERS += \
+    include/cli/CliCommands.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,15 @@
+# ============================================================================
+# ppp-core.pri
+#
+# Links the save handling core (libppp-core, see ppp-core.pro) into a program. Include it from the program's project file.
+# ============================================================================
+
+QT += network concurrent
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+LIBS += -L$$OUT_PWD/lib -lppp-core
+
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/lib/ppp-core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/lib/libppp-core.a
@@ -0,0 +1,63 @@
+# ============================================================================
+# ppp-core.pro
+#
+# Project file of the save handling core (file loaders, save slots, checksums, conversions and database access),
+# built as a static library (libppp-core). It doesn't use any window, so it only depends on the Qt core,
+# network (for the database) and concurrent (for batch conversions and decoding) libraries.
+# It uses the C++ 17 standard.
+#
+# Programs link it by including ppp-core.pri.
+# ============================================================================
+
+TARGET = ppp-core
+TEMPLATE = lib
+
+QT       = core network concurrent
+
+CONFIG += c++17 staticlib
+
+# Keep the library in a fixed place regardless of the build configuration, so ppp-core.pri can find it
+DESTDIR = $$OUT_PWD/lib
+
+# Every project is built from the same directory, so each one keeps its intermediate files apart
+OBJECTS_DIR = $$OUT_PWD/.obj/$$TARGET
+MOC_DIR = $$OUT_PWD/.moc/$$TARGET
+
+# Source code files
+SOURCES += \
+    src/file/FileManager.cpp \
+    src/file/FileLoader.cpp \
+    src/file/ByteSwap.cpp \
+    src/file/ControllerPakImage.cpp \
+    src/file/ControllerPakPacker.cpp \
+    src/file/FileConverter.cpp \
+    src/file/FileIngestor.cpp \
+    src/file/SaveIndex.cpp \
+    src/save/SaveManager.cpp \
+    src/save/Checksum.cpp \
+    src/save/RegionConversion.cpp \
+    src/save/SaveQuery.cpp \
+    src/database/DatabaseManager.cpp \
+    src/database/Database.cpp
+
+# Header files
+HEADERS += \
+    include/bit.h \
+    include/file/FileManager.h \
+    include/file/FileLoader.h \
+    include/file/ByteSwap.h \
+    include/file/FormatDescriptor.h \
+    include/file/ControllerPakImage.h \
+    include/file/ControllerPakPacker.h \
+    include/file/FileConverter.h \
+    include/file/FileIngestor.h \
+    include/file/SaveIndex.h \
+    include/save/Save.h \
+    include/save/SaveManager.h \
+    include/save/Checksum.h \
+    include/save/RegionConversion.h \
+    include/save/SaveDataSchema.h \
+    include/save/SaveQuery.h \
+    include/save/SlotCodec.h \
+    include/database/DatabaseManager.h \
+    include/database/Database.h
@@ -0,0 +1,66 @@
+# ============================================================================
+# ppp-gui.pro
+#
+# Project file of the main program (the save editor). It defines the paths to all the interface files,
+# and links the save handling core (libppp-core, see ppp-core.pro).
+# This project uses the Qt main, core, GUI for the main interface code. It also uses the network library
+# and concurrent for database-related tasks. It uses the C++ 17 standard.
+# ============================================================================
+
+TARGET = PPP
+TEMPLATE = app
+
+# Extra Qt needed libraries
+QT       += core gui network concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+# Every project is built from the same directory, so each one keeps its intermediate files apart
+OBJECTS_DIR = $$OUT_PWD/.obj/$$TARGET
+MOC_DIR = $$OUT_PWD/.moc/$$TARGET
+UI_DIR = $$OUT_PWD/.ui/$$TARGET
+RCC_DIR = $$OUT_PWD/.rcc/$$TARGET
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# Save handling core (file loaders, save slots, checksums, conversions and database access)
+include(ppp-core.pri)
+
+# Source code files
+SOURCES += \
+    src/windows/DatabaseSaveListActionButtonWindow.cpp \
+    src/main.cpp \
+    src/windows/MainWindow.cpp \
+    src/windows/DatabaseMainWindow.cpp \
+    src/windows/ControllerPakSelectionWindow.cpp
+
+# Header files
+HEADERS += \
+    include/windows/Database/DatabaseSaveListActionButtonWindow.h \
+    include/windows/ControllerPakSelection/ControllerPakSelectionWindow.h \
+    include/windows/Database/DatabaseMainWindow.h \
+    include/windows/main/MainWindow.h \
+    include/windows/ComboBoxData.h
+
+# Interface (UI) design files
+FORMS += \
+    ui/DatabaseSaveListActionButtonWindow.ui \
+    ui/DatabaseMainWindow.ui \
+    ui/MainWindow.ui \
+    ui/ControllerPakSelectionWindow.ui
+
+
+TRANSLATIONS += \
+
+
+CONFIG += lrelease
+CONFIG += embed_translations
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,30 @@
+# ============================================================================
+# ppp-test-alloc.pro
+#
+# Project file of the allocation test (ppp-test-alloc), which checks that decoding and encoding the save slots of
+# every region never allocates memory, and shows the time taken for each save slot (see tests/AllocationTest.cpp).
+# It uses the C++ 17 standard.
+#
+# It's built along with everything else from PPP.pro, and run with "make check".
+# ============================================================================
+
+TARGET = ppp-test-alloc
+TEMPLATE = app
+
+# Extra Qt needed libraries. The test doesn't use any window, so it doesn't need the GUI nor widgets libraries
+QT       = core
+
+# "testcase" adds the test to "make check"
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+# Every project is built from the same directory, so each one keeps its intermediate files apart
+OBJECTS_DIR = $$OUT_PWD/.obj/$$TARGET
+MOC_DIR = $$OUT_PWD/.moc/$$TARGET
+
+# Save handling core (file loaders, save slots, checksums, conversions and database access)
+include(ppp-core.pri)
+
+# Source code files
+SOURCES += \
+    tests/AllocationTest.cpp
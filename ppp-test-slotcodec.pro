@@ -0,0 +1,30 @@
+# ============================================================================
+# ppp-test-slotcodec.pro
+#
+# Project file of the save slot codec test (ppp-test-slotcodec), which checks the save slot codec of every region
+# against the original field-by-field reader and writer, and times both (see tests/SlotCodecTest.cpp).
+# It uses the C++ 17 standard.
+#
+# It's built along with everything else from PPP.pro, and run with "make check".
+# ============================================================================
+
+TARGET = ppp-test-slotcodec
+TEMPLATE = app
+
+# Extra Qt needed libraries. The test doesn't use any window, so it doesn't need the GUI nor widgets libraries
+QT       = core
+
+# "testcase" adds the test to "make check"
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+# Every project is built from the same directory, so each one keeps its intermediate files apart
+OBJECTS_DIR = $$OUT_PWD/.obj/$$TARGET
+MOC_DIR = $$OUT_PWD/.moc/$$TARGET
+
+# Save handling core (file loaders, save slots, checksums, conversions and database access)
+include(ppp-core.pri)
+
+# Source code files
+SOURCES += \
+    tests/SlotCodecTest.cpp
@@ -0,0 +1,776 @@
+/**
+ * @file CliCommands.cpp
+ * @brief CliCommands source code file
+ *
+ * This source code file contains the code of every command of the command-line tool (ppp-cli).
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/cli/CliCommands.h"
+#include "include/file/FileConverter.h"
+#include "include/file/SaveIndex.h"
+#include "include/save/SaveDataSchema.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include <QtConcurrentFilter>
+#include <QtConcurrentMap>
+#include <memory>   // std::unique_ptr
+#include <vector>
+
+namespace {
+    /**
+     * Outcome of validating a single file (see "validateFile()").
+     */
+    enum eValidationStatus {
+        VALIDATION_OK,
+        VALIDATION_UNREADABLE,          // The file couldn't be read
+        VALIDATION_UNSUPPORTED,         // The file's format isn't supported
+        VALIDATION_INVALID_SIZE,        // The file's size doesn't match its format
+        VALIDATION_NO_SAVES,            // The file doesn't have any Castlevania 64 save
+        VALIDATION_INVALID_CHECKSUMS    // At least one save slot's checksums don't match its data
+    };
+
+    struct ValidationResult {
+        int format = -1;
+        int status = VALIDATION_OK;
+        unsigned int numSlots = 0;
+        unsigned int numInvalidSlots = 0;
+    };
+
+    /**
+     * Decoded saves of a single file, already formatted for printing (see "dumpFile()").
+     */
+    struct DumpResult {
+        bool isReadable = false;
+        bool isSupported = false;
+        QJsonObject json;
+        QString text;
+    };
+
+    /**
+     * Save data entry that matches a query (see "searchFile()").
+     */
+    struct SearchMatch {
+        unsigned int saveIndex = 0;
+        short region = SaveData::USA;
+        unsigned int slotIndex = 0;
+        bool isBeginningOfStage = false;
+    };
+
+    struct SearchResult {
+        bool isReadable = false;
+        bool isSupported = false;
+        std::vector<SearchMatch> matches;
+    };
+
+    QTextStream& out() {
+        static QTextStream stream(stdout);
+        return stream;
+    }
+
+    QString getFormatName(const int format) {
+        return (format == -1) ? "unknown" : FileConverter::getExtension(format).mid(1);
+    }
+
+    QString getRegionName(const short region) {
+        switch (region) {
+            default:
+            case SaveData::USA:
+                return "USA";
+
+            case SaveData::JPN:
+                return "JPN";
+
+            case SaveData::PAL:
+                return "PAL";
+        }
+    }
+
+    /**
+     * @brief Creates the file-handling class for a file that was already read (see "FileIngestor::FileHandler"),
+     * and stores its format (detected from its contents) in "format".
+     *
+     * @return nullptr if the file couldn't be read, or if its format isn't supported.
+     */
+    FileLoader* createInputLoader(const QString& filepath_, QByteArrayView fileData, int& format) {
+        if (fileData.isNull()) {
+            return nullptr;
+        }
+
+        format = FileManager::findFileFormat(filepath_, fileData);
+        return FileManager::createLoader(format);
+    }
+
+    FileIngestor::Options getIngestorOptions(const CliCommands::Options& options) {
+        FileIngestor::Options ingestorOptions;
+        ingestorOptions.backend = options.ioBackend;
+        ingestorOptions.threadPool = options.threadPool;
+
+        return ingestorOptions;
+    }
+
+    /**
+     * @brief Whether a file should be left out of a command's output: files found in directories are only handled if their format is supported.
+     */
+    bool isSkippedFile(const CliCommands::Options& options, const qsizetype index, const bool isSupported) {
+        return !isSupported && index < options.isFromDirectory.size() && options.isFromDirectory[index];
+    }
+
+    bool isSupportedFile(const QString& filepath_) {
+        return FileManager::findFileFormat(filepath_, true) != -1;
+    }
+
+    /**
+     * @brief Checks the size of a file and the checksums of every save slot in it, without decoding any of them.
+     */
+    ValidationResult validateFile(const QString& filepath_, QByteArrayView fileData) {
+        ValidationResult result;
+        std::unique_ptr<FileLoader> fileLoader(createInputLoader(filepath_, fileData, result.format));
+
+        if (fileLoader == nullptr) {
+            result.status = fileData.isNull() ? VALIDATION_UNREADABLE : VALIDATION_UNSUPPORTED;
+            return result;
+        }
+
+        if (!fileLoader->hasValidFileSize(fileData.size())) {
+            result.status = VALIDATION_INVALID_SIZE;
+            return result;
+        }
+
+        for (const FileLoader::SaveSlotGroup& group: fileLoader->findSaveSlotGroups(fileData)) {
+            SaveManager::SaveSlotStatus statuses[NUM_SAVES];
+            const unsigned int numSlots = fileLoader->verifySaveSlots(fileData, group, statuses);
+
+            result.numSlots += numSlots;
+
+            for (unsigned int i = 0; i < numSlots; i++) {
+                if (statuses[i].mainSave == SaveManager::CHECKSUM_STATUS_INVALID) {
+                    result.numInvalidSlots++;
+                }
+            }
+        }
+
+        if (result.numSlots == 0) {
+            result.status = VALIDATION_NO_SAVES;
+        }
+        else if (result.numInvalidSlots > 0) {
+            result.status = VALIDATION_INVALID_CHECKSUMS;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Parse the save data struct to JSON, with the same keys as the database entries (see "DatabaseCouch::readSaveDataToJSON()").
+     * Fields that the given region's saves don't have are left out.
+     */
+    QJsonObject saveDataToJSON(const SaveData& saveData, const short region) {
+        QJsonObject json;
+
+        for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+            if (!field.isInRegion(region)) {
+                continue;
+            }
+
+            if (field.count == 1) {
+                json[field.name] = SaveDataSchema::getFieldValue(saveData, field);
+                continue;
+            }
+
+            QJsonArray array;
+            for (unsigned int i = 0; i < field.count; i++) {
+                array.append(SaveDataSchema::getFieldValue(saveData, field, i));
+            }
+
+            json[field.name] = array;
+        }
+
+        return json;
+    }
+
+    /**
+     * @brief Prints every field of the save data struct as "<prefix>.<name> = <value>" lines (array elements separated by commas).
+     */
+    void saveDataToText(QTextStream& text, const SaveData& saveData, const short region, const char* prefix) {
+        for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+            if (!field.isInRegion(region)) {
+                continue;
+            }
+
+            text << "      " << prefix << "." << field.name << " = ";
+
+            for (unsigned int i = 0; i < field.count; i++) {
+                text << ((i == 0) ? "" : ", ") << SaveDataSchema::getFieldValue(saveData, field, i);
+            }
+
+            text << "\n";
+        }
+    }
+
+    /**
+     * @brief Decodes every save in a file (see "FileLoader::decodeSaves()"), and formats them either as JSON or as text.
+     */
+    DumpResult dumpFile(const QString& filepath_, QByteArrayView fileData, const bool json) {
+        DumpResult result;
+        int format = -1;
+        std::unique_ptr<FileLoader> fileLoader(createInputLoader(filepath_, fileData, format));
+        const std::vector<FileLoader::DecodedSave> decodedSaves = (fileLoader != nullptr) ? fileLoader->decodeSaves(fileData) :
+                                                                                          std::vector<FileLoader::DecodedSave>();
+        QTextStream text(&result.text);
+        QJsonArray savesJSON;
+
+        result.isReadable = (fileLoader != nullptr);
+        result.isSupported = fileData.isNull() || (fileLoader != nullptr);
+        result.json["file"] = filepath_;
+        result.json["format"] = getFormatName(format);
+
+        if (!json) {
+            text << filepath_ << " (" << getFormatName(format) << ")" << (result.isReadable ? "" : ": can't be read") << "\n";
+        }
+
+        for (unsigned int saveIndex = 0; saveIndex < decodedSaves.size(); saveIndex++) {
+            const FileLoader::DecodedSave& decodedSave = decodedSaves[saveIndex];
+            QJsonArray slotsJSON;
+
+            if (!json) {
+                text << "  Save " << (saveIndex + 1) << " (" << getRegionName(decodedSave.region) << "), "
+                     << decodedSave.numSaveSlots << " slots\n";
+            }
+
+            for (unsigned int i = 0; i < decodedSave.numSaveSlots; i++) {
+                const SaveSlot& saveSlot = decodedSave.saveSlots[i];
+
+                if (json) {
+                    QJsonObject slotJSON;
+                    slotJSON["mainSave"] = saveDataToJSON(saveSlot.mainSave, decodedSave.region);
+                    slotJSON["beginningOfStage"] = saveDataToJSON(saveSlot.beginningOfStage, decodedSave.region);
+                    slotJSON["checksum1"] = static_cast<qint64>(saveSlot.checksum1);
+                    slotJSON["checksum2"] = static_cast<qint64>(saveSlot.checksum2);
+                    slotsJSON.append(slotJSON);
+                    continue;
+                }
+
+                text << "    Slot " << (i + 1) << " (checksums 0x" << QString::number(saveSlot.checksum1, 16)
+                     << ", 0x" << QString::number(saveSlot.checksum2, 16) << ")\n";
+                saveDataToText(text, saveSlot.mainSave, decodedSave.region, "mainSave");
+                saveDataToText(text, saveSlot.beginningOfStage, decodedSave.region, "beginningOfStage");
+            }
+
+            if (json) {
+                QJsonObject saveJSON;
+                saveJSON["region"] = getRegionName(decodedSave.region);
+                saveJSON["slots"] = slotsJSON;
+                savesJSON.append(saveJSON);
+            }
+        }
+
+        result.json["saves"] = savesJSON;
+
+        if (!result.isReadable) {
+            result.json["error"] = "can't be read";
+        }
+
+        text.flush();
+        return result;
+    }
+
+    /**
+     * @brief Finds the save data entries (main save and beginning of stage save of every slot) of a file that match the query.
+     * Entries that were never saved to (without "SAVE_FLAG_ACTIVE") are skipped.
+     *
+     * Files are rejected before decoding anything if neither their header signature nor their extension match a supported format
+     * (see "FileManager::findFileFormat()"), or if their size doesn't match their format.
+     */
+    SearchResult searchFile(const QString& filepath_, QByteArrayView fileData, const SaveQuery& query) {
+        SearchResult result;
+        int format = -1;
+        std::unique_ptr<FileLoader> fileLoader(createInputLoader(filepath_, fileData, format));
+
+        result.isReadable = (fileLoader != nullptr) && fileLoader->hasValidFileSize(fileData.size());
+        result.isSupported = fileData.isNull() || result.isReadable;
+
+        if (!result.isReadable) {
+            return result;
+        }
+
+        const std::vector<FileLoader::DecodedSave> decodedSaves = fileLoader->decodeSaves(fileData);
+
+        for (unsigned int saveIndex = 0; saveIndex < decodedSaves.size(); saveIndex++) {
+            const FileLoader::DecodedSave& decodedSave = decodedSaves[saveIndex];
+
+            for (unsigned int i = 0; i < decodedSave.numSaveSlots; i++) {
+                const SaveData* entries[] = {&decodedSave.saveSlots[i].mainSave, &decodedSave.saveSlots[i].beginningOfStage};
+
+                for (unsigned int entry = 0; entry < 2; entry++) {
+                    if (BITS_HAS(entries[entry]->flags, SaveData::SAVE_FLAG_ACTIVE) && query.matches(*entries[entry])) {
+                        SearchMatch match;
+                        match.saveIndex = saveIndex;
+                        match.region = decodedSave.region;
+                        match.slotIndex = i;
+                        match.isBeginningOfStage = (entry == 1);
+                        result.matches.push_back(match);
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Prints a save data entry that matches a query, either as text or as a single line of JSON.
+     */
+    void printMatch(const QString& filepath_, const SearchMatch& match, const bool json) {
+        const char* entryName = match.isBeginningOfStage ? "beginningOfStage" : "mainSave";
+
+        if (json) {
+            QJsonObject matchJSON;
+            matchJSON["file"] = filepath_;
+            matchJSON["save"] = static_cast<int>(match.saveIndex + 1);
+            matchJSON["region"] = getRegionName(match.region);
+            matchJSON["slot"] = static_cast<int>(match.slotIndex + 1);
+            matchJSON["data"] = entryName;
+            out() << QJsonDocument(matchJSON).toJson(QJsonDocument::Compact) << "\n";
+        }
+        else {
+            out() << "MATCH    " << filepath_ << ": save " << (match.saveIndex + 1) << " (" << getRegionName(match.region)
+                  << "), slot " << (match.slotIndex + 1) << ", " << entryName << "\n";
+        }
+    }
+
+    /**
+     * @brief Checks (and, unless "auditOnly" is true, repairs) the checksums of a single file. See "FileManager::repairChecksums()".
+     */
+    FileManager::ChecksumRepairReport repairFile(const QString& filepath_, const bool auditOnly) {
+        FileManager::ChecksumRepairReport report;
+
+        if (FileManager::getInstance()->repairChecksums(filepath_, auditOnly, report) != 0) {
+            report.numSkippedFiles++;
+        }
+
+        return report;
+    }
+}
+
+/**
+ * @brief Expands the given paths into the list of files to handle. Files are kept as they are (even if they don't exist,
+ * so they get reported as unreadable), and directories are replaced by every supported file inside them, recursively.
+ *
+ * The format of the files inside directories is detected from their contents (see "FileManager::findFileFormat()"),
+ * so unlabelled dumps are included too. Since every one of them has to be read, they're checked on the given thread pool.
+ *
+ * If "isFromDirectory" is given, the files inside directories aren't checked here. Every one of them is listed instead,
+ * and flagged in "isFromDirectory", so the command checks their format once it reads them anyway (see "validate()").
+ */
+QStringList CliCommands::collectInputFiles(const QStringList& paths, QThreadPool* threadPool, QList<bool>* isFromDirectory) {
+    QStringList inputFiles;
+
+    for (const QString& path: paths) {
+        if (!QFileInfo(path).isDir()) {
+            inputFiles.append(path);
+
+            if (isFromDirectory != nullptr) {
+                isFromDirectory->append(false);
+            }
+
+            continue;
+        }
+
+        QStringList directoryFiles;
+        QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+
+        while (it.hasNext()) {
+            directoryFiles.append(it.next());
+        }
+
+        // Keep the output the same between runs, regardless of the order the files are listed in
+        directoryFiles.sort();
+
+        if (isFromDirectory != nullptr) {
+            inputFiles.append(directoryFiles);
+            isFromDirectory->append(QList<bool>(directoryFiles.size(), true));
+        }
+        else {
+            inputFiles.append(QtConcurrent::blockingFiltered(threadPool, directoryFiles, isSupportedFile));
+        }
+    }
+
+    return inputFiles;
+}
+
+/**
+ * @brief Format whose extension is the given name (i.e. "note", "eep", "mpk" or "n64"). See "FileConverter::getExtension()".
+ *
+ * @return -1 if there's no such format.
+ */
+int CliCommands::parseFormat(const QString& name) {
+    for (int format = FileManager::FORMAT_NOTE; format <= FileManager::FORMAT_SRM; format++) {
+        if (FileConverter::getExtension(format).mid(1) == name.toLower()) {
+            return format;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Region with the given name ("usa", "jpn" or "pal").
+ *
+ * @return -1 if there's no such region.
+ */
+short CliCommands::parseRegion(const QString& name) {
+    for (short region = SaveData::USA; region <= SaveData::PAL; region++) {
+        if (getRegionName(region).toLower() == name.toLower()) {
+            return region;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Checks that every file has a supported format and size, and that the checksums of all its save slots are valid.
+ */
+int CliCommands::validate(const Options& options) {
+    std::vector<ValidationResult> results(options.inputFiles.size());
+    unsigned int numFiles = 0;
+    unsigned int numValidFiles = 0;
+
+    FileIngestor::ingest(options.inputFiles, [&options, &results](const qsizetype index, QByteArrayView fileData) {
+        results[index] = validateFile(options.inputFiles[index], fileData);
+    }, getIngestorOptions(options));
+
+    for (unsigned int i = 0; i < results.size(); i++) {
+        const ValidationResult& result = results[i];
+        const QString& filepath_ = options.inputFiles[i];
+
+        if (isSkippedFile(options, i, result.status != VALIDATION_UNSUPPORTED)) {
+            continue;
+        }
+
+        numFiles++;
+
+        switch (result.status) {
+            case VALIDATION_OK:
+                out() << "OK       " << filepath_ << " (" << getFormatName(result.format) << ", " << result.numSlots << " slots)\n";
+                numValidFiles++;
+                break;
+
+            case VALIDATION_UNREADABLE:
+            case VALIDATION_UNSUPPORTED:
+                out() << "ERROR    " << filepath_ << ": can't be read, or its format isn't supported\n";
+                break;
+
+            case VALIDATION_INVALID_SIZE:
+                out() << "INVALID  " << filepath_ << " (" << getFormatName(result.format) << "): wrong file size\n";
+                break;
+
+            case VALIDATION_NO_SAVES:
+                out() << "INVALID  " << filepath_ << " (" << getFormatName(result.format) << "): no Castlevania 64 saves\n";
+                break;
+
+            case VALIDATION_INVALID_CHECKSUMS:
+                out() << "INVALID  " << filepath_ << " (" << getFormatName(result.format) << "): " << result.numInvalidSlots
+                      << " of " << result.numSlots << " slots have wrong checksums\n";
+                break;
+        }
+    }
+
+    out() << numValidFiles << " of " << numFiles << " files are valid\n";
+    out().flush();
+
+    return (numValidFiles == numFiles) ? EXIT_CODE_OK : EXIT_CODE_FAILED_FILES;
+}
+
+/**
+ * @brief Converts every file to the output format (see FileConverter.h).
+ *
+ * Each input file is converted on its own, so they're all converted at the same time. If "packNotes" is set,
+ * the saves of every input file are packed together instead, which only runs a single conversion.
+ */
+int CliCommands::convert(const Options& options) {
+    QList<FileConverter::Job> jobs;
+
+    if (!options.outputDirectory.isEmpty() && !QDir().mkpath(options.outputDirectory)) {
+        out() << "ERROR    " << options.outputDirectory << ": the output directory can't be created\n";
+        out().flush();
+        return EXIT_CODE_FAILED_FILES;
+    }
+
+    const QString outputDirectory = options.outputDirectory.isEmpty() ? QDir::currentPath() : options.outputDirectory;
+
+    if (options.packNotes) {
+        FileConverter::Job job;
+        job.inputPaths = options.inputFiles;
+        job.outputBasePath = QDir(outputDirectory).filePath("converted");
+        job.outputFormat = options.outputFormat;
+        job.outputRegion = options.outputRegion;
+        jobs.append(job);
+    }
+    else {
+        for (const QString& filepath_: options.inputFiles) {
+            const QFileInfo fileInfo(filepath_);
+            FileConverter::Job job;
+            job.inputPaths = QStringList(filepath_);
+            job.outputBasePath = QDir(options.outputDirectory.isEmpty() ? fileInfo.absolutePath() : outputDirectory).filePath(fileInfo.completeBaseName());
+            job.outputFormat = options.outputFormat;
+            job.outputRegion = options.outputRegion;
+            jobs.append(job);
+        }
+    }
+
+    const QList<FileConverter::Result> results = FileConverter::convertAll(jobs, options.threadPool);
+    bool hasFailed = false;
+    unsigned int numSaves = 0;
+
+    for (int i = 0; i < results.size(); i++) {
+        const FileConverter::Result& result = results[i];
+        const QString inputName = options.packNotes ? QString::number(options.inputFiles.size()) + " files" : options.inputFiles[i];
+
+        for (const QString& skippedFile: result.skippedFiles) {
+            out() << "ERROR    " << skippedFile << ": can't be read, or doesn't have any saves\n";
+        }
+
+        if (result.status != 0) {
+            out() << "ERROR    " << inputName << ": an output file can't be written\n";
+        }
+        else if (!result.outputFiles.isEmpty()) {
+            out() << "OK       " << inputName << " -> " << result.outputFiles.join(", ") << "\n";
+        }
+
+        if (result.numSkippedSaves > 0) {
+            out() << "SKIPPED  " << inputName << ": " << result.numSkippedSaves << " saves can't be stored as " << getFormatName(options.outputFormat) << "\n";
+        }
+
+        hasFailed = hasFailed || (result.status != 0) || (result.numSkippedFiles > 0);
+        numSaves += result.numSaves;
+    }
+
+    out() << numSaves << " saves converted\n";
+    out().flush();
+
+    return hasFailed ? EXIT_CODE_FAILED_FILES : EXIT_CODE_OK;
+}
+
+/**
+ * @brief Prints every save slot of every file, either as a JSON array (one object per file) or as text.
+ */
+int CliCommands::dump(const Options& options) {
+    std::vector<DumpResult> results(options.inputFiles.size());
+
+    FileIngestor::ingest(options.inputFiles, [&options, &results](const qsizetype index, QByteArrayView fileData) {
+        results[index] = dumpFile(options.inputFiles[index], fileData, options.json);
+    }, getIngestorOptions(options));
+
+    const bool json = options.json;
+    bool hasFailed = false;
+    QJsonArray filesJSON;
+
+    for (unsigned int i = 0; i < results.size(); i++) {
+        const DumpResult& result = results[i];
+
+        if (isSkippedFile(options, i, result.isSupported)) {
+            continue;
+        }
+
+        hasFailed = hasFailed || !result.isReadable;
+
+        if (json) {
+            filesJSON.append(result.json);
+        }
+        else {
+            out() << result.text;
+        }
+    }
+
+    if (json) {
+        out() << QJsonDocument(filesJSON).toJson(QJsonDocument::Indented);
+    }
+
+    out().flush();
+    return hasFailed ? EXIT_CODE_FAILED_FILES : EXIT_CODE_OK;
+}
+
+/**
+ * @brief Rewrites the checksums of every save slot whose checksums don't match its data (see "FileManager::repairChecksums()").
+ * If "dryRun" is set, the invalid slots are only reported.
+ */
+int CliCommands::checksumFix(const Options& options) {
+    const bool auditOnly = options.dryRun;
+    const QList<FileManager::ChecksumRepairReport> reports = QtConcurrent::blockingMapped<QList<FileManager::ChecksumRepairReport>>(
+        options.threadPool, options.inputFiles, [auditOnly](const QString& filepath_) {
+            return repairFile(filepath_, auditOnly);
+        });
+
+    FileManager::ChecksumRepairReport total;
+
+    for (int i = 0; i < reports.size(); i++) {
+        const FileManager::ChecksumRepairReport& report = reports[i];
+
+        if (report.numSkippedFiles > 0) {
+            out() << "ERROR    " << options.inputFiles[i] << ": can't be opened\n";
+        }
+        else if (report.numInvalidSlots > 0) {
+            out() << (auditOnly ? "INVALID  " : "REPAIRED ") << options.inputFiles[i] << ": " << report.numInvalidSlots
+                  << " of " << report.numSlots << " slots\n";
+        }
+
+        total.numFiles += report.numFiles;
+        total.numSkippedFiles += report.numSkippedFiles;
+        total.numSlots += report.numSlots;
+        total.numInvalidSlots += report.numInvalidSlots;
+        total.numRepairedSlots += report.numRepairedSlots;
+    }
+
+    out() << total.numInvalidSlots << " of " << total.numSlots << " slots had wrong checksums";
+
+    if (!auditOnly) {
+        out() << ", " << total.numRepairedSlots << " repaired";
+    }
+
+    out() << "\n";
+    out().flush();
+
+    // In a dry run, the wrong checksums are left as they are, so they're reported as a failure
+    const bool hasFailed = (total.numSkippedFiles > 0) || (auditOnly ? (total.numInvalidSlots > 0) :
+                                                                       (total.numRepairedSlots < total.numInvalidSlots));
+    return hasFailed ? EXIT_CODE_FAILED_FILES : EXIT_CODE_OK;
+}
+
+/**
+ * @brief Prints every save data entry that matches the query (see SaveQuery.h), either as text or as JSON (one object per line).
+ *
+ * The matches of each file are printed as soon as it's searched, so they're printed in the order the files are read in,
+ * rather than in the order of the input files.
+ */
+int CliCommands::search(const Options& options) {
+    QMutex outputMutex;
+    unsigned int numFiles = 0;
+    unsigned int numMatches = 0;
+    bool hasFailed = false;
+
+    FileIngestor::ingest(options.inputFiles, [&](const qsizetype index, QByteArrayView fileData) {
+        const QString& filepath_ = options.inputFiles[index];
+        const SearchResult result = searchFile(filepath_, fileData, options.query);
+
+        if (isSkippedFile(options, index, result.isSupported)) {
+            return;
+        }
+
+        QMutexLocker locker(&outputMutex);
+
+        numFiles++;
+        numMatches += result.matches.size();
+        hasFailed = hasFailed || !result.isReadable;
+
+        if (!result.isReadable) {
+            if (options.json) {
+                QJsonObject errorJSON;
+                errorJSON["file"] = filepath_;
+                errorJSON["error"] = "can't be read";
+                out() << QJsonDocument(errorJSON).toJson(QJsonDocument::Compact) << "\n";
+            }
+            else {
+                out() << "ERROR    " << filepath_ << ": can't be read, or its format isn't supported\n";
+            }
+        }
+
+        for (const SearchMatch& match: result.matches) {
+            printMatch(filepath_, match, options.json);
+        }
+
+        out().flush();
+    }, getIngestorOptions(options));
+
+    if (!options.json) {
+        out() << numMatches << " matches in " << numFiles << " files\n";
+        out().flush();
+    }
+
+    return hasFailed ? EXIT_CODE_FAILED_FILES : EXIT_CODE_OK;
+}
+
+/**
+ * @brief Builds the index at "indexPath" (see SaveIndex.h) from the input files, or refreshes it if it already exists.
+ * Only the files that changed since the index was last built are decoded again.
+ */
+int CliCommands::buildIndex(const Options& options) {
+    SaveIndex index;
+    SaveIndex::RefreshStats stats;
+    bool hasFailed = false;
+
+    if (index.refresh(options.indexPath, options.inputFiles, getIngestorOptions(options), stats) != 0) {
+        out() << "ERROR    " << options.indexPath << ": the index can't be written\n";
+        out().flush();
+        return EXIT_CODE_FAILED_FILES;
+    }
+
+    for (unsigned int i = 0; i < stats.fileStatuses.size(); i++) {
+        const int status = stats.fileStatuses[i];
+
+        if (status == SaveIndex::FILE_UNREADABLE || (status == SaveIndex::FILE_UNSUPPORTED && !isSkippedFile(options, i, false))) {
+            out() << "ERROR    " << options.inputFiles[i] << ": can't be read, or its format isn't supported\n";
+            hasFailed = true;
+        }
+    }
+
+    out() << (stats.numReusedFiles + stats.numDecodedFiles) << " files indexed (" << stats.numReusedFiles << " unchanged, "
+          << stats.numDecodedFiles << " decoded), " << index.getNumRows() << " saves\n";
+    out().flush();
+
+    return hasFailed ? EXIT_CODE_FAILED_FILES : EXIT_CODE_OK;
+}
+
+/**
+ * @brief Prints every save data entry of the index at "indexPath" that matches the query, same as "search()" does,
+ * but straight from the index instead of the files. The matches are printed in the order the files were indexed in.
+ */
+int CliCommands::queryIndex(const Options& options) {
+    SaveIndex index;
+    QElapsedTimer timer;
+    const int result = index.open(options.indexPath);
+
+    if (result != 0) {
+        out() << "ERROR    " << options.indexPath << ((result == -1) ? ": can't be read\n" : ": isn't a save index, or it was built by another version\n");
+        out().flush();
+        return EXIT_CODE_FAILED_FILES;
+    }
+
+    timer.start();
+
+    const SaveQuery::RowSet rows = index.find(options.query);
+    const double milliseconds = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+    unsigned int numMatches = 0;
+
+    for (std::size_t word = 0; word < rows.size(); word++) {
+        for (quint64 bits = rows[word]; bits != 0; bits &= bits - 1) {
+            const quint32 row = static_cast<quint32>((word * 64) + qCountTrailingZeroBits(bits));
+            SearchMatch match;
+
+            match.saveIndex = index.getRowSave(row);
+            match.region = index.getRowRegion(row);
+            match.slotIndex = index.getRowSlot(row);
+            match.isBeginningOfStage = (index.getRowEntry(row) == SaveIndex::ENTRY_BEGINNING_OF_STAGE);
+            printMatch(index.getFilePath(index.getRowFile(row)), match, options.json);
+            numMatches++;
+        }
+    }
+
+    if (!options.json) {
+        out() << numMatches << " matches in " << index.getNumRows() << " saves of " << index.getNumFiles() << " files ("
+              << QString::number(milliseconds, 'f', 3) << " ms)\n";
+    }
+
+    out().flush();
+
+    return EXIT_CODE_OK;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file CliMain.cpp
+ * @brief Main source code file of the command-line tool (ppp-cli)
+ *
+ * This file contains the main entrypoint function of the command-line tool, which runs a single command
+ * (see CliCommands.h) over a list of files and directories, and reports how many files it handled per second.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/cli/CliCommands.h"
+#include "include/save/SaveManager.h"
+#include "include/file/FileManager.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThreadPool>
+
+/**
+ * The save handling core uses the Singleton pattern, same as the main program (see main.cpp).
+ *
+ * The instances are defined in libppp-core, and they live for the entire lifetime of the application.
+ */
+void createSingletons() {
+    SaveManager::createInstance();
+    FileManager::createInstance();
+}
+
+void destroySingletons() {
+    SaveManager::destroyInstance();
+    FileManager::destroyInstance();
+}
+
+/**
+ * @brief Reads the command line into "options".
+ *
+ * @return The command to run, or an empty string if the command line isn't valid (the error is printed to stderr).
+ */
+QString parseCommandLine(QCoreApplication& app, CliCommands::Options& options) {
+    QCommandLineParser parser;
+    QTextStream err(stderr);
+
+    parser.setApplicationDescription("Validates, converts, dumps and repairs Castlevania 64 saves in batches.\n\n"
+                                     "Commands:\n"
+                                     "  validate      Checks the format, size and checksums of every file\n"
+                                     "  convert       Converts every file to another format (see --to)\n"
+                                     "  dump          Prints every save slot of every file, as text or JSON (see --json)\n"
+                                     "  checksum-fix  Rewrites the checksums that don't match their save slot's data\n"
+                                     "  search        Prints every save that matches a query, i.e.\n"
+                                     "                search \"map == TENSHU and character == CARRIE and HARD and gold > 50000\" <paths...>\n"
+                                     "  index         Builds (or refreshes) a save index of every file, i.e. index <index file> <paths...>\n"
+                                     "  query         Prints every save of a save index that matches a query, i.e. query <index file> <query>");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "validate, convert, dump, checksum-fix, search, index or query.");
+    parser.addPositionalArgument("paths", "Files, or directories to search (recursively) for supported files.", "paths...");
+
+    const QCommandLineOption jobsOption({"j", "jobs"}, "Number of files handled at the same time. Defaults to the number of CPU threads.", "count");
+    const QCommandLineOption ioOption("io", "validate, dump, search, index: How files are read (auto, uring or threads). auto uses io_uring when it's available.", "backend", "auto");
+    const QCommandLineOption formatOption("to", "convert: Output format (note, eep, mpk or n64).", "format", "note");
+    const QCommandLineOption regionOption("region", "convert: Converts every save to this version of the game (usa, jpn or pal).", "region");
+    const QCommandLineOption outputOption({"o", "output"}, "convert: Output directory. Defaults to the directory of each input file.", "directory");
+    const QCommandLineOption packOption("pack", "convert: Packs the saves of every input file together, instead of converting each file on its own.");
+    const QCommandLineOption jsonOption("json", "dump, search, query: Prints JSON instead of text.");
+    const QCommandLineOption dryRunOption("dry-run", "checksum-fix: Only reports the wrong checksums, without writing anything.");
+
+    parser.addOptions({jobsOption, ioOption, formatOption, regionOption, outputOption, packOption, jsonOption, dryRunOption});
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    const QString command = arguments.isEmpty() ? QString() : arguments.first();
+    const bool isSearch = (command == "search");
+    const bool isQuery = (command == "query");
+
+    // search takes the query before the paths, index takes the index file, and query takes both of them instead of any path
+    const int numLeadingArguments = (isSearch || command == "index") ? 2 : (isQuery ? 3 : 1);
+
+    if (arguments.size() < (isQuery ? numLeadingArguments : numLeadingArguments + 1)) {
+        err << parser.helpText();
+        return QString();
+    }
+
+    if (command == "index" || isQuery) {
+        options.indexPath = arguments[1];
+    }
+
+    if ((isSearch || isQuery) && options.query.parse(arguments[isQuery ? 2 : 1]) != 0) {
+        err << "Invalid query: " << options.query.getLastError() << "\n";
+        return QString();
+    }
+
+    if (parser.isSet(jobsOption)) {
+        bool isNumber = false;
+        const int numJobs = parser.value(jobsOption).toInt(&isNumber);
+
+        if (!isNumber || numJobs <= 0) {
+            err << "Invalid number of jobs: " << parser.value(jobsOption) << "\n";
+            return QString();
+        }
+
+        options.threadPool->setMaxThreadCount(numJobs);
+    }
+
+    const QString ioBackend = parser.value(ioOption).toLower();
+
+    if (ioBackend == "uring") {
+        options.ioBackend = FileIngestor::BACKEND_IO_URING;
+
+        if (!FileIngestor::isIoUringAvailable()) {
+            err << "io_uring isn't available, files will be read with QFile instead\n";
+        }
+    }
+    else if (ioBackend == "threads") {
+        options.ioBackend = FileIngestor::BACKEND_THREAD_POOL;
+    }
+    else if (ioBackend != "auto") {
+        err << "Unknown I/O backend: " << parser.value(ioOption) << "\n";
+        return QString();
+    }
+
+    options.outputFormat = CliCommands::parseFormat(parser.value(formatOption));
+
+    if (options.outputFormat == -1 || options.outputFormat == FileManager::FORMAT_SRM) {
+        err << "Unsupported output format: " << parser.value(formatOption) << "\n";
+        return QString();
+    }
+
+    if (parser.isSet(regionOption)) {
+        options.outputRegion = CliCommands::parseRegion(parser.value(regionOption));
+
+        if (options.outputRegion == -1) {
+            err << "Unknown region: " << parser.value(regionOption) << "\n";
+            return QString();
+        }
+    }
+
+    options.outputDirectory = parser.value(outputOption);
+    options.packNotes = parser.isSet(packOption);
+    options.json = parser.isSet(jsonOption);
+    options.dryRun = parser.isSet(dryRunOption);
+
+    // validate, dump, search and index read every file anyway, so the format of the files inside directories is checked then
+    const bool readsFiles = (command == "validate" || command == "dump" || isSearch || command == "index");
+    options.inputFiles = CliCommands::collectInputFiles(arguments.mid(numLeadingArguments), options.threadPool,
+                                                        readsFiles ? &options.isFromDirectory : nullptr);
+
+    return command;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("ppp-cli");
+
+    createSingletons();
+
+    CliCommands::Options options;
+    const QString command = parseCommandLine(a, options);
+    QTextStream err(stderr);
+    QElapsedTimer timer;
+    int result = CliCommands::EXIT_CODE_USAGE;
+    bool hasReadFiles = false;
+
+    timer.start();
+
+    if (command == "validate") {
+        result = CliCommands::validate(options);
+        hasReadFiles = true;
+    }
+    else if (command == "convert") {
+        result = CliCommands::convert(options);
+    }
+    else if (command == "dump") {
+        result = CliCommands::dump(options);
+        hasReadFiles = true;
+    }
+    else if (command == "checksum-fix") {
+        result = CliCommands::checksumFix(options);
+    }
+    else if (command == "search") {
+        result = CliCommands::search(options);
+        hasReadFiles = true;
+    }
+    else if (command == "index") {
+        result = CliCommands::buildIndex(options);
+        hasReadFiles = true;
+    }
+    else if (command == "query") {
+        result = CliCommands::queryIndex(options);
+    }
+    else if (!command.isEmpty()) {
+        err << "Unknown command: " << command << "\n";
+    }
+
+    // query doesn't handle any file, and it reports the time it took by itself
+    if (result != CliCommands::EXIT_CODE_USAGE && command != "query") {
+        // Throughput of the command itself (the time spent finding the files in directories isn't counted)
+        const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        const double filesPerSecond = (seconds > 0) ? (options.inputFiles.size() / seconds) : 0;
+
+        err << options.inputFiles.size() << " files in " << QString::number(seconds, 'f', 3) << " s ("
+            << QString::number(filesPerSecond, 'f', 1) << " files/s, " << options.threadPool->maxThreadCount() << " threads";
+
+        if (hasReadFiles) {
+            const bool usesIoUring = (options.ioBackend != FileIngestor::BACKEND_THREAD_POOL) && FileIngestor::isIoUringAvailable();
+            err << ", read with " << (usesIoUring ? "io_uring" : "QFile");
+        }
+
+        err << ")\n";
+    }
+
+    destroySingletons();
+
+    return result;
+}
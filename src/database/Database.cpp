@@ -9,9 +9,9 @@
 
 #include "include/database/Database.h"
 #include "include/database/DatabaseManager.h"
+#include "include/save/SaveDataSchema.h"
 #include <QEventLoop>
 #include <QJsonDocument>
-#include <QMessageBox>
 #include <QUrl>
 #include <QUrlQuery>
 #include <QJsonArray>
@@ -28,6 +28,8 @@ void Database::waitForEventToFinish(QNetworkReply* reply) {
 
 /**
  * @brief Request connecting to the database
+ *
+ * @return false if the connection failed (see "getLastError()").
  */
 bool DatabaseCouch::connectToDatabase() {
     DatabaseManager* databaseManager = DatabaseManager::getInstance()->getInstance();
@@ -47,9 +49,8 @@ bool DatabaseCouch::connectToDatabase() {
     bool success = (reply->error() == QNetworkReply::NoError);
 
     if (!success) {
-        QMessageBox::critical(nullptr, "Error", "An error has occurred while performing this operation.\n"
-                                                "Error:" + reply->errorString() + "\n" +
-                                                "Response:" + reply->readAll());
+        lastError = "Error:" + reply->errorString() + "\n" +
+                    "Response:" + reply->readAll();
     }
 
     reply->deleteLater();
@@ -66,23 +67,21 @@ void DatabaseCouch::disconnectFromDatabase() {
 
 /**
  * @brief Create an entire save file entry in the database
+ *
+ * @param confirmOverwrite Asked if the document ID already exists. If it's not set, existing entries are never overwritten.
+ * @return -1 if the operation failed (see "getLastError()"), -2 if the entry already existed and wasn't overwritten. 0 otherwise.
  */
-void DatabaseCouch::createEntry(const QString& id, const std::vector<SaveSlot>& entries, const QString& rev) {
+int DatabaseCouch::createEntry(const QString& id, const std::vector<SaveSlot>& entries, const QString& rev, const OverwriteConfirmation& confirmOverwrite) {
     QUrl url(QString("http://%1:%2/%3/%4").arg(getHostname()).arg(getPort()).arg(getDatabaseName()).arg(id));
     QNetworkRequest request(url);
     createAuthorizationHeader(request);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     // Check if the given documentId already exists in the database
-    // If true, propmt the replacement window. If yes is selected, proceed with the replacement
+    // If true, ask the caller whether to replace it. If confirmed, proceed with the replacement
     if (entryAlreadyExistsGivenRequest(request)) {
-        QMessageBox::StandardButton reply;
-        reply = QMessageBox::question(nullptr, "Confirm overwrite",
-                                      "This document ID already exists. Do you want to overwrite it?",
-                                      QMessageBox::Yes | QMessageBox::No);
-
-        if (reply == QMessageBox::No) {
-            return;
+        if (!confirmOverwrite || !confirmOverwrite(id)) {
+            return -2;
         }
     }
 
@@ -106,9 +105,11 @@ void DatabaseCouch::createEntry(const QString& id, const std::vector<SaveSlot>&
 
     waitForEventToFinish(reply);
     // When the request is finished, call "getDatabaseRequestReply" to get the response (either success or error)
-    getDatabaseRequestReply(reply);
+    const bool success = getDatabaseRequestReply(reply);
 
     reply->deleteLater();
+
+    return success ? 0 : -1;
 }
 
 bool DatabaseCouch::entryAlreadyExistsGivenRequest(const QNetworkRequest& request) {
@@ -135,12 +136,12 @@ bool DatabaseCouch::entryAlreadyExists(const QString& id) {
 
 /**
  * Given a database operation reply (the result obtained *after* performing the database operation),
- * this function prints a success or error message depending on the result obtained.
+ * this function checks whether it succeeded, and keeps the error message otherwise (see "getLastError()").
  */
-void DatabaseCouch::getDatabaseRequestReply(QNetworkReply* reply) {
+bool DatabaseCouch::getDatabaseRequestReply(QNetworkReply* reply) {
     if (reply == nullptr) {
-        QMessageBox::critical(nullptr, "", "An error has occurred while performing this operation.");
-        return;
+        lastError = "An error has occurred while performing this operation.";
+        return false;
     }
 
     QByteArray responseData = reply->readAll();
@@ -149,106 +150,63 @@ void DatabaseCouch::getDatabaseRequestReply(QNetworkReply* reply) {
     // Detailed error message
     QString responseText = jsonResponse.isNull() ? QString(responseData) : jsonResponse.toJson(QJsonDocument::Indented);
 
-    if (reply->error() == QNetworkReply::NoError) {
-        QMessageBox::information(nullptr, "Success", "The operation was successful!");
-    }
-    else {
-        QMessageBox::critical(nullptr, "Error", "An error has occurred while performing this operation.\n"
-                                                "Response:\n" + responseText);
+    const bool success = (reply->error() == QNetworkReply::NoError);
+
+    if (!success) {
+        lastError = "An error has occurred while performing this operation.\n"
+                    "Response:\n" + responseText;
     }
 
     reply->deleteLater();
+
+    return success;
 }
 
 /**
  * @brief Parse a save data to JSON in order to ensure it's in the format accepted by CouchDB.
+ *
+ * Every field listed in SaveDataSchema.h is stored using the member name as its key. Arrays are stored as JSON arrays.
  */
 QJsonObject DatabaseCouch::readSaveDataToJSON(const SaveData& saveData) {
     QJsonObject json;
-    QJsonArray eventFlagsArray;
-    QJsonArray itemsArray;
 
-    for (unsigned int i = 0; i < NUM_EVENT_FLAGS; i++) {
-        eventFlagsArray.append(static_cast<int>(saveData.event_flags[i]));
-    }
+    for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+        if (field.count == 1) {
+            json[field.name] = static_cast<int>(SaveDataSchema::getFieldValue(saveData, field));
+            continue;
+        }
 
-    json["event_flags"] = eventFlagsArray;
-    json["flags"] = static_cast<int>(saveData.flags);
-    json["week"] = saveData.week;
-    json["day"] = saveData.day;
-    json["hour"] = saveData.hour;
-    json["minute"] = saveData.minute;
-    json["seconds"] = saveData.seconds;
-    json["milliseconds"] = saveData.milliseconds;
-    json["gameplay_framecount"] = static_cast<int>(saveData.gameplay_framecount);
-    json["button_config"] = saveData.button_config;
-    json["sound_mode"] = saveData.sound_mode;
-    json["language"] = saveData.language;
-    json["character"] = saveData.character;
-    json["life"] = saveData.life;
-    json["subweapon"] = saveData.subweapon;
-    json["gold"] = static_cast<int>(saveData.gold);
-
-    for (unsigned int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
-        itemsArray.append(static_cast<int>(saveData.items[j]));
-    }
+        QJsonArray array;
+        for (unsigned int i = 0; i < field.count; i++) {
+            array.append(static_cast<int>(SaveDataSchema::getFieldValue(saveData, field, i)));
+        }
 
-    json["items"] = itemsArray;
-    json["player_status"] = static_cast<int>(saveData.player_status);
-    json["health_depletion_rate_while_poisoned"] = saveData.health_depletion_rate_while_poisoned;
-    json["current_hour_VAMP"] = saveData.current_hour_VAMP;
-    json["map"] = saveData.map;
-    json["spawn"] = saveData.spawn;
-    json["save_crystal_number"] = saveData.save_crystal_number;
-    json["time_saved_counter"] = static_cast<int>(saveData.time_saved_counter);
-    json["death_counter"] = static_cast<int>(saveData.death_counter);
-    json["gold_spent_on_Renon"] = static_cast<int>(saveData.gold_spent_on_Renon);
+        json[field.name] = array;
+    }
 
     return json;
 }
 
 /**
  * @brief Parse a JSON entry from the database to the save data struct.
+ *
+ * @note Fields missing from the JSON entry are set to 0.
  */
 SaveData DatabaseCouch::parseJSONToSaveData(const QJsonObject& json) {
     SaveData saveData = {};
 
-    QJsonArray eventFlagsArray = json["event_flags"].toArray();
-    for (int i = 0; i < NUM_EVENT_FLAGS; i++) {
-        saveData.event_flags[i] = eventFlagsArray[i].toInt();
-    }
+    for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+        if (field.count == 1) {
+            SaveDataSchema::setFieldValue(saveData, field, json[field.name].toInt());
+            continue;
+        }
 
-    saveData.flags = json["flags"].toInt();
-    saveData.week = static_cast<short>(json["week"].toInt());
-    saveData.day = static_cast<short>(json["day"].toInt());
-    saveData.hour = static_cast<short>(json["hour"].toInt());
-    saveData.minute = static_cast<short>(json["minute"].toInt());
-    saveData.seconds = static_cast<short>(json["seconds"].toInt());
-    saveData.milliseconds = static_cast<unsigned short>(json["milliseconds"].toInt());
-    saveData.gameplay_framecount = json["gameplay_framecount"].toInt();
-    saveData.button_config = static_cast<short>(json["button_config"].toInt());
-    saveData.sound_mode = static_cast<short>(json["sound_mode"].toInt());
-    saveData.language = static_cast<short>(json["language"].toInt());
-    saveData.character = static_cast<short>(json["character"].toInt());
-    saveData.life = static_cast<short>(json["life"].toInt());
-    saveData.subweapon = static_cast<short>(json["subweapon"].toInt());
-    saveData.gold = static_cast<unsigned int>(json["gold"].toInt());
-
-    QJsonArray itemsArray = json["items"].toArray();
-    for (int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
-        saveData.items[j] = static_cast<unsigned char>(itemsArray[j].toInt());
+        QJsonArray array = json[field.name].toArray();
+        for (unsigned int i = 0; i < field.count && i < array.size(); i++) {
+            SaveDataSchema::setFieldValue(saveData, field, array[i].toInt(), i);
+        }
     }
 
-    saveData.player_status = json["player_status"].toInt();
-    saveData.health_depletion_rate_while_poisoned = static_cast<short>(json["health_depletion_rate_while_poisoned"].toInt());
-    saveData.current_hour_VAMP = static_cast<unsigned short>(json["current_hour_VAMP"].toInt());
-    saveData.map = static_cast<short>(json["map"].toInt());
-    saveData.spawn = static_cast<short>(json["spawn"].toInt());
-    saveData.save_crystal_number = static_cast<unsigned short>(json["save_crystal_number"].toInt());
-    saveData.time_saved_counter = json["time_saved_counter"].toInt();
-    saveData.death_counter = json["death_counter"].toInt();
-    saveData.gold_spent_on_Renon = json["gold_spent_on_Renon"].toInt();
-
     return saveData;
 }
 
@@ -353,8 +311,10 @@ void DatabaseCouch::parseGetAllEntriesResponse(const QByteArray& data, std::vect
 
 /**
  * @brief Delete an entry from the database
+ *
+ * @return false if the operation failed (see "getLastError()").
  */
-void DatabaseCouch::deleteEntry(const QString& id, const QString& rev) {
+bool DatabaseCouch::deleteEntry(const QString& id, const QString& rev) {
     QUrl url(QString("http://%1:%2/%3/%4").arg(getHostname()).arg(getPort()).arg(getDatabaseName()).arg(id));
     // We need to add the "rev" field to ensure the deletion is properly made
     QUrlQuery query;
@@ -367,9 +327,11 @@ void DatabaseCouch::deleteEntry(const QString& id, const QString& rev) {
 
     waitForEventToFinish(reply);
     // When the request is finished, call "getDatabaseRequestReply" to get the response (either success or error)
-    getDatabaseRequestReply(reply);
+    const bool success = getDatabaseRequestReply(reply);
 
     reply->deleteLater();
+
+    return success;
 }
 
 /**
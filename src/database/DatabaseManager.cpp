@@ -9,6 +9,8 @@
 
 #include "include/database/DatabaseManager.h"
 
+DatabaseManager* DatabaseManager::instance = nullptr;   /**< See "getInstance()" */
+
 bool DatabaseManager::connectToDatabase() {
     if (database != nullptr) {
         return database->connectToDatabase();
@@ -23,10 +25,12 @@ void DatabaseManager::disconnectFromDatabase() {
     }
 }
 
-void DatabaseManager::createEntry(const QString& id, const std::vector<SaveSlot>& entries, const QString& rev) {
+int DatabaseManager::createEntry(const QString& id, const std::vector<SaveSlot>& entries, const QString& rev, const Database::OverwriteConfirmation& confirmOverwrite) {
     if (database != nullptr) {
-        database->createEntry(id, entries, rev);
+        return database->createEntry(id, entries, rev, confirmOverwrite);
     }
+
+    return -1;
 }
 
 bool DatabaseManager::entryAlreadyExists(const QString& id) {
@@ -59,10 +63,20 @@ std::vector<Database::SaveBasicInfo> DatabaseManager::getAllEntries() {
     return std::vector<Database::SaveBasicInfo>();
 }
 
-void DatabaseManager::deleteEntry(const QString& id, const QString& rev) {
+bool DatabaseManager::deleteEntry(const QString& id, const QString& rev) {
+    if (database != nullptr) {
+        return database->deleteEntry(id, rev);
+    }
+
+    return false;
+}
+
+QString DatabaseManager::getLastError() const {
     if (database != nullptr) {
-        database->deleteEntry(id, rev);
+        return database->getLastError();
     }
+
+    return "";
 }
 
 /**
@@ -0,0 +1,173 @@
+/**
+ * @file ByteSwap.cpp
+ * @brief ByteSwap source code file
+ *
+ * This source code file contains the byte-order conversion kernels, and the code that picks the fastest one
+ * the CPU supports the first time they're used.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/ByteSwap.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BYTESWAP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+    typedef void (*ShuffleKernel)(const char*, char*, std::size_t, const quint8*);
+    typedef void (*Swap32Kernel)(char*, std::size_t);
+
+    /**
+     * Shuffle mask that reverses every 32-bit word of a 32-byte block.
+     */
+    alignas(32) const quint8 SWAP32_MASK[32] = {
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+    };
+
+    /**
+     * @brief Portable shuffle, starting at byte "start". Every block goes through a temporary copy so "src" and "dst" can overlap.
+     */
+    void shuffleScalar(const char* src, char* dst, const std::size_t size, const quint8* mask, std::size_t start) {
+        char block[ByteSwap::BLOCK_SIZE];
+
+        for (std::size_t blockStart = start; blockStart < size; blockStart += ByteSwap::BLOCK_SIZE) {
+            const std::size_t blockSize = qMin<std::size_t>(ByteSwap::BLOCK_SIZE, size - blockStart);
+            memcpy(block, src + blockStart, blockSize);
+
+            for (std::size_t i = 0; i < blockSize; i++) {
+                const quint8 maskEntry = mask[blockStart + i];
+                dst[blockStart + i] = (maskEntry & ByteSwap::ZERO_BYTE) ? 0 : block[maskEntry];
+            }
+        }
+    }
+
+    void shuffleScalar(const char* src, char* dst, const std::size_t size, const quint8* mask) {
+        shuffleScalar(src, dst, size, mask, 0);
+    }
+
+    void swap32Scalar(char* data, const std::size_t size, std::size_t start) {
+        for (std::size_t i = start; i + 3 < size; i += 4) {
+            qToBigEndian<quint32>(qFromLittleEndian<quint32>(data + i), data + i);
+        }
+    }
+
+    void swap32Scalar(char* data, const std::size_t size) {
+        swap32Scalar(data, size, 0);
+    }
+
+#ifdef BYTESWAP_X86_KERNELS
+    __attribute__((target("ssse3")))
+    void shuffleSSSE3(const char* src, char* dst, const std::size_t size, const quint8* mask) {
+        std::size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i blockMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(data, blockMask));
+        }
+
+        shuffleScalar(src, dst, size, mask, i);
+    }
+
+    __attribute__((target("ssse3")))
+    void swap32SSSE3(char* data, const std::size_t size) {
+        const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(SWAP32_MASK));
+        std::size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i* block = reinterpret_cast<__m128i*>(data + i);
+            _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+        }
+
+        swap32Scalar(data, size, i);
+    }
+
+    /**
+     * "vpshufb" shuffles each 128-bit lane on its own, which matches the block-relative masks used by the scalar kernel.
+     */
+    __attribute__((target("avx2")))
+    void shuffleAVX2(const char* src, char* dst, const std::size_t size, const quint8* mask) {
+        std::size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            const __m256i blockMask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(data, blockMask));
+        }
+
+        if (i + 16 <= size) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i blockMask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(data, blockMask));
+            i += 16;
+        }
+
+        shuffleScalar(src, dst, size, mask, i);
+    }
+
+    __attribute__((target("avx2")))
+    void swap32AVX2(char* data, const std::size_t size) {
+        const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(SWAP32_MASK));
+        std::size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            __m256i* block = reinterpret_cast<__m256i*>(data + i);
+            _mm256_storeu_si256(block, _mm256_shuffle_epi8(_mm256_loadu_si256(block), mask));
+        }
+
+        if (i + 16 <= size) {
+            __m128i* block = reinterpret_cast<__m128i*>(data + i);
+            _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), _mm256_castsi256_si128(mask)));
+            i += 16;
+        }
+
+        swap32Scalar(data, size, i);
+    }
+#endif
+
+    /**
+     * Kernels chosen for the running CPU.
+     */
+    struct Kernels {
+        ShuffleKernel shuffle = shuffleScalar;
+        Swap32Kernel swap32 = swap32Scalar;
+        const char* name = "scalar";
+
+        Kernels() {
+#ifdef BYTESWAP_X86_KERNELS
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2")) {
+                shuffle = shuffleAVX2;
+                swap32 = swap32AVX2;
+                name = "avx2";
+            }
+            else if (__builtin_cpu_supports("ssse3")) {
+                shuffle = shuffleSSSE3;
+                swap32 = swap32SSSE3;
+                name = "ssse3";
+            }
+#endif
+        }
+    };
+
+    const Kernels& getKernels() {
+        static const Kernels kernels;
+        return kernels;
+    }
+}
+
+void ByteSwap::shuffle(const char* src, char* dst, const std::size_t size, const quint8* mask) {
+    getKernels().shuffle(src, dst, size, mask);
+}
+
+void ByteSwap::swap32(char* data, const std::size_t size) {
+    getKernels().swap32(data, size);
+}
+
+const char* ByteSwap::getKernelName() {
+    return getKernels().name;
+}
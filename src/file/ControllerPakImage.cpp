@@ -0,0 +1,257 @@
+/**
+ * @file ControllerPakImage.cpp
+ * @brief ControllerPakImage source code file
+ *
+ * This source code file contains the code that decodes the file system of a Controller Pak.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/ControllerPakImage.h"
+#include <QtEndian>
+#include <cstring>  // memcpy
+
+/**
+ * @brief Decodes the whole file system from an in-memory copy of the system area (the first "SYSTEM_AREA_SIZE" bytes of the Controller Pak).
+ *
+ * @return -1 if "systemArea" is too small. 0 otherwise.
+ * @note A Controller Pak without a valid ID block is still decoded (see "getIdBlock()").
+ */
+int ControllerPakImage::parse(QByteArrayView systemArea) {
+    clear();
+
+    if (systemArea.size() < SYSTEM_AREA_SIZE) {
+        return -1;
+    }
+
+    const char* data = systemArea.constData();
+
+    // ID block. If the main copy is damaged, the first valid backup is used instead
+    for (const unsigned int offset: ID_BLOCK_OFFSETS) {
+        const QByteArrayView idBlockData = systemArea.sliced(offset, ID_BLOCK_SIZE);
+
+        if (isIdBlockValid(idBlockData)) {
+            idBlock.isValid = true;
+            idBlock.offset = offset;
+            idBlock.checksum = qFromBigEndian<quint16>(data + offset + 0x1C);
+            idBlock.numBanks = static_cast<unsigned char>(data[offset + 0x1A]);
+            break;
+        }
+    }
+
+    // Index table. Each entry (a 16-bit big endian value) holds the next page of the note the page belongs to
+    for (unsigned int page = 0; page < NUM_PAGES; page++) {
+        indexTable[page] = qFromBigEndian<quint16>(data + INDEX_TABLE_OFFSET + (page * sizeof(quint16)));
+    }
+
+    // Note table
+    for (unsigned int i = 0; i < NOTE_TABLE_NUM_ENTRIES; i++) {
+        const char* entry = data + NOTE_TABLE_OFFSET + (NOTE_TABLE_ENTRY_SIZE * i);
+        NoteEntry& note = notes[i];
+
+        note.gameId = QByteArray(entry, 6);
+        note.startPage = qFromBigEndian<quint16>(entry + 0x06);
+        note.status = static_cast<unsigned char>(entry[0x08]);
+        note.extension = QByteArray(entry + 0x0C, 4);
+        note.name = QByteArray(entry + 0x10, 16);
+
+        if (note.isUsed()) {
+            note.pages = followPageChain(note.startPage, note.isChainValid);
+        }
+    }
+
+    return 0;
+}
+
+void ControllerPakImage::clear() {
+    idBlock = IdBlock();
+    indexTable.fill(INDEX_FREE_PAGE);
+
+    for (NoteEntry& note: notes) {
+        note = NoteEntry();
+    }
+}
+
+/**
+ * @brief Checks the checksums at the end of a copy of the ID block.
+ *
+ * The block ends with the sum of its first 14 big endian 16-bit words, followed by 0xFFF2 minus that sum.
+ */
+bool ControllerPakImage::isIdBlockValid(QByteArrayView idBlockData) {
+    const unsigned int CHECKSUM_OFFSET = 0x1C;
+
+    if (idBlockData.size() < ID_BLOCK_SIZE) {
+        return false;
+    }
+
+    quint16 checksum = 0;
+
+    for (unsigned int offset = 0; offset < CHECKSUM_OFFSET; offset += sizeof(quint16)) {
+        checksum += qFromBigEndian<quint16>(idBlockData.constData() + offset);
+    }
+
+    return (qFromBigEndian<quint16>(idBlockData.constData() + CHECKSUM_OFFSET) == checksum) &&
+           (qFromBigEndian<quint16>(idBlockData.constData() + CHECKSUM_OFFSET + 2) == static_cast<quint16>(0xFFF2 - checksum));
+}
+
+/**
+ * @brief The game ID of any of the Castlevania 64 versions ("ND3EA4", "ND3PA4" or "ND3JA4").
+ */
+bool ControllerPakImage::isCastlevaniaGameId(QByteArrayView gameId) {
+    return gameId == QByteArrayView("ND3EA4") || gameId == QByteArrayView("ND3PA4") || gameId == QByteArrayView("ND3JA4");
+}
+
+unsigned int ControllerPakImage::getNumFreePages() const {
+    unsigned int numFreePages = 0;
+
+    for (unsigned int page = FIRST_DATA_PAGE; page < NUM_PAGES; page++) {
+        if (indexTable[page] == INDEX_FREE_PAGE) {
+            numFreePages++;
+        }
+    }
+
+    return numFreePages;
+}
+
+/**
+ * @brief Follows the index table starting at "startPage", and returns every page of the note in order.
+ *
+ * If a link points outside of the data area, or back to a page that was already visited,
+ * the chain is cut right before it and "isChainValid" is set to false.
+ */
+std::vector<unsigned int> ControllerPakImage::followPageChain(const unsigned int startPage, bool& isChainValid) const {
+    std::vector<unsigned int> pages;
+    std::array<bool, NUM_PAGES> isVisited {};
+    unsigned int page = startPage;
+
+    isChainValid = false;
+
+    while (page >= FIRST_DATA_PAGE && page < NUM_PAGES && !isVisited[page]) {
+        isVisited[page] = true;
+        pages.push_back(page);
+
+        const quint16 nextPage = indexTable[page];
+
+        if (nextPage == INDEX_END_OF_NOTE) {
+            isChainValid = true;
+            break;
+        }
+
+        page = nextPage;
+    }
+
+    return pages;
+}
+
+/**
+ * @brief View of the given page of the note. Empty if the page is outside of the Controller Pak data.
+ */
+QByteArrayView ControllerPakImage::PageChain::getPage(const unsigned int index) const {
+    if (index >= getNumPages() || getPageOffset(index) + PAGE_SIZE > pakData.size()) {
+        return QByteArrayView();
+    }
+
+    return pakData.sliced(getPageOffset(index), PAGE_SIZE);
+}
+
+/**
+ * @brief Checks if the given pages of the note are stored one right after the other.
+ */
+bool ControllerPakImage::PageChain::isContiguous(const unsigned int firstPage, const unsigned int numPages) const {
+    if (numPages == 0 || firstPage + numPages > getNumPages()) {
+        return false;
+    }
+
+    for (unsigned int i = firstPage + 1; i < firstPage + numPages; i++) {
+        if ((*pages)[i] != (*pages)[i - 1] + 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief View of "size" bytes of the note, starting at "offset" (relative to the start of the note).
+ *
+ * @return An empty view if those bytes aren't stored contiguously (see "copyTo()" for that case), or if they're out of bounds.
+ */
+QByteArrayView ControllerPakImage::PageChain::sliced(const unsigned int offset, const unsigned int size) const {
+    if (size == 0) {
+        return QByteArrayView();
+    }
+
+    const unsigned int firstPage = offset / PAGE_SIZE;
+    const unsigned int lastPage = (offset + size - 1) / PAGE_SIZE;
+
+    if (!isContiguous(firstPage, lastPage - firstPage + 1)) {
+        return QByteArrayView();
+    }
+
+    const unsigned int startOffset = getPageOffset(firstPage) + (offset % PAGE_SIZE);
+
+    if (startOffset + size > pakData.size()) {
+        return QByteArrayView();
+    }
+
+    return pakData.sliced(startOffset, size);
+}
+
+/**
+ * @brief Copies "size" bytes of the note, starting at "offset" (relative to the start of the note), into "dst", page by page.
+ *
+ * @return The number of bytes copied, which is less than "size" if the note (or the Controller Pak data) ends before.
+ */
+unsigned int ControllerPakImage::PageChain::copyTo(const unsigned int offset, const unsigned int size, char* dst) const {
+    unsigned int numBytesCopied = 0;
+
+    while (numBytesCopied < size) {
+        const unsigned int noteOffset = offset + numBytesCopied;
+        const QByteArrayView page = getPage(noteOffset / PAGE_SIZE);
+
+        if (page.isEmpty()) {
+            break;
+        }
+
+        const unsigned int pageOffset = noteOffset % PAGE_SIZE;
+        const unsigned int numBytes = qMin(size - numBytesCopied, PAGE_SIZE - pageOffset);
+
+        memcpy(dst + numBytesCopied, page.constData() + pageOffset, numBytes);
+        numBytesCopied += numBytes;
+    }
+
+    return numBytesCopied;
+}
+
+/**
+ * @brief Splits the first "size" bytes of the note into runs of consecutive pages, so each run can be accessed with a single call.
+ * A note that isn't fragmented is a single run.
+ *
+ * @return An empty list if the note is smaller than "size".
+ */
+std::vector<ControllerPakImage::PageChain::Run> ControllerPakImage::PageChain::getRuns(const unsigned int size) const {
+    std::vector<Run> runs;
+    const unsigned int numPages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    if (size == 0 || getNumPages() < numPages) {
+        return runs;
+    }
+
+    for (unsigned int firstPage = 0; firstPage < numPages;) {
+        unsigned int numRunPages = 1;
+
+        while (firstPage + numRunPages < numPages && (*pages)[firstPage + numRunPages] == (*pages)[firstPage + numRunPages - 1] + 1) {
+            numRunPages++;
+        }
+
+        Run run;
+        run.noteOffset = firstPage * PAGE_SIZE;
+        run.pakOffset = getPageOffset(firstPage);
+        run.size = qMin(numRunPages * PAGE_SIZE, size - run.noteOffset);
+        runs.push_back(run);
+
+        firstPage += numRunPages;
+    }
+
+    return runs;
+}
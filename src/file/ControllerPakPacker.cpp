@@ -0,0 +1,109 @@
+/**
+ * @file ControllerPakPacker.cpp
+ * @brief ControllerPakPacker source code file
+ *
+ * This source code file contains the code that builds Controller Pak images out of individual notes.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/ControllerPakPacker.h"
+#include <QtEndian>
+#include <cstring>  // memcpy
+
+/**
+ * @brief Starts a new, empty Controller Pak: a valid ID block (and its backups), every data page free, and an empty note table.
+ */
+void ControllerPakPacker::reset() {
+    pakData.fill('\0', PAK_SIZE);
+    nextFreePage = ControllerPakImage::FIRST_DATA_PAGE;
+    numNotes = 0;
+
+    for (const unsigned int offset: ControllerPakImage::ID_BLOCK_OFFSETS) {
+        writeIdBlock(pakData.data() + offset);
+    }
+
+    for (unsigned int page = ControllerPakImage::FIRST_DATA_PAGE; page < ControllerPakImage::NUM_PAGES; page++) {
+        qToBigEndian<quint16>(ControllerPakImage::INDEX_FREE_PAGE, pakData.data() + ControllerPakImage::INDEX_TABLE_OFFSET + (page * sizeof(quint16)));
+    }
+}
+
+/**
+ * @brief Stores a note in the next free pages, and adds its entry to the note table.
+ *
+ * @param noteEntry The note's entry (game ID, status, extension, name, etc). Its start page is replaced with the one that gets allocated.
+ * @param noteData The note's data. If it doesn't fill its last page, the rest of that page is zeroed out.
+ * @return -1 if the note doesn't fit in the current pak (see "canFit()"). Otherwise, the index of the note in the note table.
+ */
+int ControllerPakPacker::addNote(QByteArrayView noteEntry, QByteArrayView noteData) {
+    const unsigned int numPages = getNumPages(noteData.size());
+
+    if (noteEntry.size() < ControllerPakImage::NOTE_TABLE_ENTRY_SIZE || numPages == 0 || !canFit(numPages)) {
+        return -1;
+    }
+
+    const unsigned int startPage = nextFreePage;
+    char* indexTable = pakData.data() + ControllerPakImage::INDEX_TABLE_OFFSET;
+    char* entry = pakData.data() + ControllerPakImage::NOTE_TABLE_OFFSET + (numNotes * ControllerPakImage::NOTE_TABLE_ENTRY_SIZE);
+
+    memcpy(pakData.data() + (startPage * ControllerPakImage::PAGE_SIZE), noteData.constData(), noteData.size());
+
+    // Link the pages one after another
+    for (unsigned int page = startPage; page < startPage + numPages; page++) {
+        const quint16 nextPage = (page == startPage + numPages - 1) ? ControllerPakImage::INDEX_END_OF_NOTE : page + 1;
+        qToBigEndian<quint16>(nextPage, indexTable + (page * sizeof(quint16)));
+    }
+
+    memcpy(entry, noteEntry.constData(), ControllerPakImage::NOTE_TABLE_ENTRY_SIZE);
+    qToBigEndian<quint16>(startPage, entry + 0x06);
+
+    nextFreePage += numPages;
+    return numNotes++;
+}
+
+/**
+ * @brief Writes the index table checksum, along with the index table backup, and returns the finished Controller Pak.
+ *
+ * @note The returned data stays valid until the next call to "reset()" or "addNote()".
+ */
+const QByteArray& ControllerPakPacker::finish() {
+    char* indexTable = pakData.data() + ControllerPakImage::INDEX_TABLE_OFFSET;
+
+    indexTable[1] = static_cast<char>(calculateIndexTableChecksum(indexTable));
+    memcpy(pakData.data() + INDEX_TABLE_BACKUP_OFFSET, indexTable, ControllerPakImage::PAGE_SIZE);
+
+    return pakData;
+}
+
+/**
+ * @brief Writes an ID block for a single-bank pak (with a blank serial number), followed by its checksums (see "ControllerPakImage::isIdBlockValid()").
+ */
+void ControllerPakPacker::writeIdBlock(char* idBlock) {
+    const unsigned int CHECKSUM_OFFSET = 0x1C;
+    quint16 checksum = 0;
+
+    memset(idBlock, 0, ControllerPakImage::ID_BLOCK_SIZE);
+    qToBigEndian<quint16>(0x0001, idBlock + 0x18);  // Device ID
+    idBlock[0x1A] = 0x01;                           // Number of banks
+
+    for (unsigned int offset = 0; offset < CHECKSUM_OFFSET; offset += sizeof(quint16)) {
+        checksum += qFromBigEndian<quint16>(idBlock + offset);
+    }
+
+    qToBigEndian<quint16>(checksum, idBlock + CHECKSUM_OFFSET);
+    qToBigEndian<quint16>(0xFFF2 - checksum, idBlock + CHECKSUM_OFFSET + 2);
+}
+
+/**
+ * @brief The index table checksum is the lowest byte of the sum of the entries of every data page.
+ * It's stored in the second byte of the table (the entries of the system area pages aren't used).
+ */
+quint8 ControllerPakPacker::calculateIndexTableChecksum(const char* indexTable) {
+    quint8 checksum = 0;
+
+    for (unsigned int offset = ControllerPakImage::FIRST_DATA_PAGE * sizeof(quint16); offset < ControllerPakImage::PAGE_SIZE; offset++) {
+        checksum += static_cast<quint8>(indexTable[offset]);
+    }
+
+    return checksum;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file FileConverter.cpp
+ * @brief FileConverter source code file
+ *
+ * This source code file contains the code that converts saves between the supported file formats.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileConverter.h"
+#include "include/file/ControllerPakPacker.h"
+#include "include/save/RegionConversion.h"
+#include <QtConcurrentMap>
+#include <algorithm>  // std::copy
+#include <memory>     // std::unique_ptr
+
+namespace {
+    /**
+     * @brief Writes a whole file with a single call.
+     */
+    bool writeWholeFile(const QString& filepath_, QByteArrayView data) {
+        QFile outputFile(filepath_);
+
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        return outputFile.write(data) == data.size();
+    }
+
+    /**
+     * Writes the saves of a single job as they get decoded, so only one output file (or one Controller Pak) is kept in memory at a time.
+     */
+    class ConversionWriter {
+        public:
+            ConversionWriter(const FileConverter::Job& job_, FileConverter::Result& result_) : job(job_), result(result_) {}
+
+            bool isControllerPak() const {
+                return job.outputFormat == FileManager::FORMAT_CONTROLLERPAK || job.outputFormat == FileManager::FORMAT_DEXDRIVE;
+            }
+
+            /**
+             * @return false if an output file couldn't be written.
+             */
+            bool write(const FileLoader::DecodedSave& decodedSave) {
+                const short region = (job.outputRegion >= SaveData::USA && job.outputRegion <= SaveData::PAL) ? job.outputRegion : decodedSave.region;
+
+                // Cartridge saves only exist in the Japanese version
+                if (job.outputFormat == FileManager::FORMAT_CARTRIDGE && region != SaveData::JPN) {
+                    result.numSkippedSaves++;
+                    return true;
+                }
+
+                const SaveSlot* saveSlots = decodedSave.saveSlots;
+
+                if (region != decodedSave.region) {
+                    std::copy(decodedSave.saveSlots, decodedSave.saveSlots + NUM_SAVES, convertedSaveSlots);
+                    RegionConversion::convertSaveSlots(convertedSaveSlots, NUM_SAVES, decodedSave.region, region);
+                    saveSlots = convertedSaveSlots;
+                }
+
+                const FileLoader& outputLoader = (job.outputFormat == FileManager::FORMAT_CARTRIDGE) ?
+                                                 static_cast<const FileLoader&>(cartridgeLoader) : static_cast<const FileLoader&>(noteLoader);
+                outputLoader.encodeSaveImage(image, saveSlots, region);
+                result.numSaves++;
+
+                if (!isControllerPak()) {
+                    return writeOutputFile(image);
+                }
+
+                // Controller Paks get each save as a note, using the note table entry from the .note header
+                const unsigned int numPages = ControllerPakPacker::getNumPages(image.size() - ControllerPakPacker::NOTE_FILE_DATA_OFFSET);
+
+                if (!packer.canFit(numPages) && !flush()) {
+                    return false;
+                }
+
+                packer.addNote(QByteArrayView(image).sliced(ControllerPakPacker::NOTE_FILE_ENTRY_OFFSET, ControllerPakImage::NOTE_TABLE_ENTRY_SIZE),
+                               QByteArrayView(image).sliced(ControllerPakPacker::NOTE_FILE_DATA_OFFSET));
+                return true;
+            }
+
+            /**
+             * @brief Writes the Controller Pak being built, if there's one.
+             */
+            bool flush() {
+                if (!isControllerPak() || packer.getNumNotes() == 0) {
+                    return true;
+                }
+
+                const QString outputPath = getNextOutputPath();
+
+                if (!FileManager::writeControllerPak(outputPath, job.outputFormat, packer.finish())) {
+                    return false;
+                }
+
+                result.outputFiles.append(outputPath);
+                packer.reset();
+                return true;
+            }
+
+        private:
+            QString getNextOutputPath() const {
+                return job.outputBasePath + "_" + QString::number(result.outputFiles.size() + 1) + FileConverter::getExtension(job.outputFormat);
+            }
+
+            bool writeOutputFile(QByteArrayView data) {
+                const QString outputPath = getNextOutputPath();
+
+                if (!writeWholeFile(outputPath, data)) {
+                    return false;
+                }
+
+                result.outputFiles.append(outputPath);
+                return true;
+            }
+
+            const FileConverter::Job& job;
+            FileConverter::Result& result;
+            const FileLoaderNote noteLoader{FormatDescriptors::NOTE};
+            const FileLoaderCartridge cartridgeLoader{FormatDescriptors::CARTRIDGE};
+            ControllerPakPacker packer;
+            QByteArray image;                               /**< Encoded save, reused for every save */
+            SaveSlot convertedSaveSlots[NUM_SAVES] = {};    /**< Copy of the save being converted to another region */
+    };
+}
+
+/**
+ * @brief Runs a single conversion (see "Job"). Nothing global is modified, so this can be called from any thread.
+ *
+ * @note The checksums of every converted save slot are recalculated.
+ */
+FileConverter::Result FileConverter::convert(const Job& job) {
+    Result result;
+
+    if (job.outputFormat != FileManager::FORMAT_NOTE && job.outputFormat != FileManager::FORMAT_CARTRIDGE &&
+        job.outputFormat != FileManager::FORMAT_CONTROLLERPAK && job.outputFormat != FileManager::FORMAT_DEXDRIVE) {
+        result.status = -1;
+        return result;
+    }
+
+    ConversionWriter writer(job, result);
+
+    for (const QString& inputPath: job.inputPaths) {
+        const int inputFormat = FileManager::findFileFormat(inputPath, true);
+        std::unique_ptr<FileLoader> inputLoader(FileManager::createLoader(inputFormat));
+        QFile inputFile(inputPath);
+        std::vector<FileLoader::DecodedSave> decodedSaves;
+
+        if (inputLoader != nullptr && inputFile.open(QIODevice::ReadOnly)) {
+            decodedSaves = inputLoader->decodeSaves(inputFile.readAll());
+        }
+
+        if (decodedSaves.empty()) {
+            result.numSkippedFiles++;
+            result.skippedFiles.append(inputPath);
+            continue;
+        }
+
+        for (const FileLoader::DecodedSave& decodedSave: decodedSaves) {
+            if (!writer.write(decodedSave)) {
+                result.status = -1;
+                return result;
+            }
+        }
+    }
+
+    if (!writer.flush()) {
+        result.status = -1;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Runs every job on the given thread pool, and waits for all of them to finish.
+ *
+ * @return The result of each job, in the same order as "jobs".
+ */
+QList<FileConverter::Result> FileConverter::convertAll(const QList<Job>& jobs, QThreadPool* threadPool) {
+    return QtConcurrent::blockingMapped<QList<Result>>(threadPool, jobs, convert);
+}
+
+/**
+ * @brief Extension of the files written in the given format (including the dot).
+ */
+QString FileConverter::getExtension(const int format) {
+    switch (format) {
+        default:
+        case FileManager::FORMAT_NOTE:
+            return ".note";
+
+        case FileManager::FORMAT_CARTRIDGE:
+            return ".eep";
+
+        case FileManager::FORMAT_CONTROLLERPAK:
+            return ".mpk";
+
+        case FileManager::FORMAT_DEXDRIVE:
+            return ".n64";
+
+        case FileManager::FORMAT_SRM:
+            return ".srm";
+    }
+}
@@ -0,0 +1,536 @@
+/**
+ * @file FileIngestor.cpp
+ * @brief FileIngestor source code file
+ *
+ * This source code file contains the code that reads batches of files, either through io_uring (Linux only)
+ * or through QFile on a thread pool, and hands their contents to the decoders.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileIngestor.h"
+#include <QByteArray>
+#include <QFile>
+#include <QSemaphore>
+#include <QtConcurrentMap>
+#include <atomic>
+#include <numeric>  // std::iota
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define FILEINGESTOR_IO_URING
+#include <sys/mman.h>
+#include <sys/stat.h>   // struct statx
+#include <fcntl.h>      // AT_FDCWD, O_RDONLY
+#include <unistd.h>
+#include <cstring>      // memset
+#endif
+#endif
+
+namespace {
+    /**
+     * @brief View handed to the handler for a file that was read. Empty files still get a non-null view.
+     */
+    QByteArrayView viewOf(const QByteArray& fileData) {
+        return fileData.isNull() ? QByteArrayView("", 0) : QByteArrayView(fileData);
+    }
+
+    /**
+     * @brief Reads a whole file with QFile.
+     *
+     * @return false if the file couldn't be read, or if it's bigger than "MAX_FILE_SIZE".
+     */
+    bool readWholeFile(const QString& filepath_, QByteArray& fileData) {
+        QFile inputFile(filepath_);
+
+        if (!inputFile.open(QIODevice::ReadOnly) || inputFile.size() > FileIngestor::MAX_FILE_SIZE) {
+            return false;
+        }
+
+        fileData = inputFile.readAll();
+        return true;
+    }
+
+    /**
+     * @brief Reads every file with QFile, spread over the thread pool. Each file is handed to the handler by the thread that read it.
+     */
+    FileIngestor::Stats ingestWithThreadPool(const QStringList& filepaths, const FileIngestor::FileHandler& handler, QThreadPool* threadPool) {
+        std::vector<qsizetype> indices(filepaths.size());
+        std::atomic<unsigned int> numFiles{0};
+        std::atomic<unsigned int> numFailedFiles{0};
+        std::atomic<qint64> numBytes{0};
+
+        std::iota(indices.begin(), indices.end(), 0);
+
+        QtConcurrent::blockingMap(threadPool, indices, [&](const qsizetype index) {
+            QByteArray fileData;
+
+            if (!readWholeFile(filepaths[index], fileData)) {
+                numFailedFiles++;
+                handler(index, QByteArrayView());
+                return;
+            }
+
+            numFiles++;
+            numBytes += fileData.size();
+            handler(index, viewOf(fileData));
+        });
+
+        FileIngestor::Stats stats;
+        stats.backend = FileIngestor::BACKEND_THREAD_POOL;
+        stats.numFiles = numFiles;
+        stats.numFailedFiles = numFailedFiles;
+        stats.numBytes = numBytes;
+
+        return stats;
+    }
+
+#ifdef FILEINGESTOR_IO_URING
+    /**
+     * Minimal io_uring instance (submission and completion rings), using the system calls directly.
+     */
+    class IoUring {
+        public:
+            IoUring() {}
+            IoUring(const IoUring& obj) = delete;
+
+            ~IoUring() {
+                if (sqes != MAP_FAILED) {
+                    munmap(sqes, sqesSize);
+                }
+
+                if (cqRing != MAP_FAILED && cqRing != sqRing) {
+                    munmap(cqRing, cqRingSize);
+                }
+
+                if (sqRing != MAP_FAILED) {
+                    munmap(sqRing, sqRingSize);
+                }
+
+                if (ringFd >= 0) {
+                    close(ringFd);
+                }
+            }
+
+            /**
+             * @return false if io_uring isn't available, or if the kernel doesn't support every operation the ingestion needs.
+             */
+            bool init(const unsigned int numEntries) {
+                io_uring_params params;
+                memset(&params, 0, sizeof(params));
+
+                ringFd = static_cast<int>(syscall(__NR_io_uring_setup, numEntries, &params));
+
+                if (ringFd < 0 || !supportsOperations({IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE})) {
+                    return false;
+                }
+
+                sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+                cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+
+                // Since Linux 5.4, both rings share a single mapping
+                if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                    sqRingSize = qMax(sqRingSize, cqRingSize);
+                }
+
+                sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+
+                if (sqRing == MAP_FAILED) {
+                    return false;
+                }
+
+                cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqRing :
+                         mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+
+                sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+
+                if (cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+                    return false;
+                }
+
+                char* sq = static_cast<char*>(sqRing);
+                char* cq = static_cast<char*>(cqRing);
+
+                sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+                sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+                sqMask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+                sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+                sqEntries = params.sq_entries;
+                cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+                cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+                cqMask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+                return true;
+            }
+
+            /**
+             * @brief Queues a new, cleared operation. If the submission ring is full, the queued operations are submitted first.
+             */
+            io_uring_sqe* queueOperation(const quint8 opcode, const int fd, const void* address, const unsigned int length, const quint64 userData) {
+                if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+                    submit(0);
+                }
+
+                const unsigned int entry = sqLocalTail & sqMask;
+                io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes) + entry;
+
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = opcode;
+                sqe->fd = fd;
+                sqe->addr = reinterpret_cast<quint64>(address);
+                sqe->len = length;
+                sqe->user_data = userData;
+
+                sqArray[entry] = entry;
+                sqLocalTail++;
+                numQueued++;
+
+                return sqe;
+            }
+
+            /**
+             * @brief Submits every queued operation, and waits until at least "minComplete" operations have completed.
+             *
+             * @return false if the kernel refused the submission.
+             */
+            bool submit(const unsigned int minComplete) {
+                __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+
+                while (numQueued > 0 || minComplete > 0) {
+                    const int result = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, numQueued, minComplete,
+                                                                (minComplete > 0) ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+
+                    if (result < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+
+                        return false;
+                    }
+
+                    numQueued -= qMin<unsigned int>(numQueued, result);
+
+                    if (minComplete > 0 || numQueued == 0) {
+                        break;
+                    }
+                }
+
+                return true;
+            }
+
+            /**
+             * @brief Takes the next completed operation, if there's one.
+             */
+            bool takeCompletion(io_uring_cqe& cqe) {
+                const unsigned int head = *cqHead;
+
+                if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                    return false;
+                }
+
+                cqe = cqes[head & cqMask];
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+                return true;
+            }
+
+        private:
+            bool supportsOperations(std::initializer_list<quint8> opcodes) const {
+                constexpr unsigned int NUM_PROBED_OPS = 256;
+                std::vector<char> probeData(sizeof(io_uring_probe) + (NUM_PROBED_OPS * sizeof(io_uring_probe_op)), 0);
+                io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeData.data());
+
+                if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, NUM_PROBED_OPS) < 0) {
+                    return false;
+                }
+
+                for (const quint8 opcode: opcodes) {
+                    if (opcode >= probe->ops_len || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            int ringFd = -1;
+            void* sqRing = MAP_FAILED;
+            void* cqRing = MAP_FAILED;
+            void* sqes = MAP_FAILED;
+            std::size_t sqRingSize = 0;
+            std::size_t cqRingSize = 0;
+            std::size_t sqesSize = 0;
+
+            unsigned int* sqHead = nullptr;
+            unsigned int* sqTail = nullptr;
+            unsigned int* sqArray = nullptr;
+            unsigned int sqMask = 0;
+            unsigned int sqEntries = 0;
+            unsigned int sqLocalTail = 0;   /**< Tail including the operations that weren't published to the kernel yet */
+            unsigned int numQueued = 0;     /**< Operations queued since the last submission */
+
+            unsigned int* cqHead = nullptr;
+            unsigned int* cqTail = nullptr;
+            unsigned int cqMask = 0;
+            io_uring_cqe* cqes = nullptr;
+    };
+
+    /**
+     * Reads files through io_uring. Each file goes through these operations:
+     * open and size query (submitted together), then read (once both finished), and finally close.
+     *
+     * Up to "queueDepth" files are being read at the same time, and every operation that's ready is submitted with a single system call.
+     * Once a file is read, its contents are handed to the handler on the thread pool.
+     */
+    class IoUringIngestor {
+        public:
+            IoUringIngestor(const QStringList& filepaths_, const FileIngestor::FileHandler& handler_, const FileIngestor::Options& options)
+                : filepaths(filepaths_), handler(handler_), threadPool(options.threadPool),
+                  requests(qMax(1u, options.queueDepth)), maxPendingHandlers(requests.size() * 2), pendingHandlers(maxPendingHandlers) {}
+
+            bool init() {
+                // Each file has at most 3 operations waiting to be submitted at once (a close, and the open and size query of the next file)
+                return ring.init(requests.size() * 4);
+            }
+
+            /**
+             * @return false if the ring stopped working midway. Every file is handed to the handler regardless.
+             */
+            bool run() {
+                bool isRingWorking = true;
+
+                for (unsigned int i = 0; i < requests.size(); i++) {
+                    freeRequests.push_back(requests.size() - 1 - i);
+                }
+
+                while (isRingWorking && (nextIndex < filepaths.size() || numPendingOperations > 0)) {
+                    while (nextIndex < filepaths.size() && !freeRequests.empty()) {
+                        startRequest(nextIndex++);
+                    }
+
+                    isRingWorking = ring.submit(1);
+                    io_uring_cqe cqe;
+
+                    while (ring.takeCompletion(cqe)) {
+                        completeOperation(static_cast<unsigned int>(cqe.user_data >> OPERATION_BITS),
+                                          static_cast<int>(cqe.user_data & OPERATION_MASK), cqe.res);
+                    }
+                }
+
+                // If the ring failed, the files that weren't read yet are reported as unreadable.
+                // Their buffers are kept until the ring is destroyed, since the kernel may still be using them
+                for (Request& request: requests) {
+                    if (request.index != -1) {
+                        if (request.fd >= 0) {
+                            close(request.fd);
+                        }
+
+                        handOver(request.index, QByteArray(), false);
+                        request.index = -1;
+                    }
+                }
+
+                for (; nextIndex < filepaths.size(); nextIndex++) {
+                    handOver(nextIndex, QByteArray(), false);
+                }
+
+                // Wait for every handler to finish
+                pendingHandlers.acquire(maxPendingHandlers);
+                pendingHandlers.release(maxPendingHandlers);
+
+                return isRingWorking;
+            }
+
+            FileIngestor::Stats getStats() const {
+                return stats;
+            }
+
+        private:
+            enum eOperation {
+                OPERATION_OPEN,
+                OPERATION_STATX,
+                OPERATION_READ,
+                OPERATION_CLOSE
+            };
+
+            static constexpr unsigned int OPERATION_BITS = 2;
+            static constexpr quint64 OPERATION_MASK = (1 << OPERATION_BITS) - 1;
+
+            /**
+             * A file being read.
+             */
+            struct Request {
+                qsizetype index = -1;
+                QByteArray path;                /**< Encoded file path. Kept alive until both the open and size query finish */
+                QByteArray fileData;
+                struct statx statxBuffer;
+                int fd = -1;
+                int statxResult = 0;
+                unsigned int numPendingOperations = 0;
+            };
+
+            io_uring_sqe* queue(const quint8 opcode, const int fd, const void* address, const unsigned int length,
+                                const unsigned int requestIndex, const eOperation operation) {
+                numPendingOperations++;
+                return ring.queueOperation(opcode, fd, address, length, (static_cast<quint64>(requestIndex) << OPERATION_BITS) | operation);
+            }
+
+            void startRequest(const qsizetype index) {
+                const unsigned int requestIndex = freeRequests.back();
+                Request& request = requests[requestIndex];
+
+                freeRequests.pop_back();
+                request.index = index;
+                request.path = QFile::encodeName(filepaths[index]);
+                request.fd = -1;
+                request.numPendingOperations = 2;
+
+                queue(IORING_OP_OPENAT, AT_FDCWD, request.path.constData(), 0, requestIndex, OPERATION_OPEN)->open_flags = O_RDONLY | O_CLOEXEC;
+
+                io_uring_sqe* sqe = queue(IORING_OP_STATX, AT_FDCWD, request.path.constData(), STATX_SIZE | STATX_TYPE, requestIndex, OPERATION_STATX);
+                sqe->off = reinterpret_cast<quint64>(&request.statxBuffer);
+            }
+
+            void completeOperation(const unsigned int requestIndex, const int operation, const int result) {
+                numPendingOperations--;
+
+                if (operation == OPERATION_CLOSE) {
+                    return;
+                }
+
+                Request& request = requests[requestIndex];
+
+                switch (operation) {
+                    case OPERATION_OPEN:
+                        request.fd = result;
+                        break;
+
+                    case OPERATION_STATX:
+                        request.statxResult = result;
+                        break;
+
+                    case OPERATION_READ:
+                        if (result >= 0) {
+                            request.fileData.truncate(result);
+                        }
+
+                        finishRequest(requestIndex, result >= 0);
+                        return;
+                }
+
+                if (--request.numPendingOperations > 0) {
+                    return;
+                }
+
+                // Both the open and the size query finished, so the file can be read now
+                const quint64 fileSize = request.statxBuffer.stx_size;
+
+                if (request.fd < 0 || request.statxResult < 0 || !S_ISREG(request.statxBuffer.stx_mode) ||
+                    fileSize > static_cast<quint64>(FileIngestor::MAX_FILE_SIZE)) {
+                    finishRequest(requestIndex, false);
+                    return;
+                }
+
+                if (fileSize == 0) {
+                    request.fileData.clear();
+                    finishRequest(requestIndex, true);
+                    return;
+                }
+
+                request.fileData.resize(fileSize);
+                queue(IORING_OP_READ, request.fd, request.fileData.data(), fileSize, requestIndex, OPERATION_READ);
+            }
+
+            void finishRequest(const unsigned int requestIndex, const bool wasRead) {
+                Request& request = requests[requestIndex];
+
+                if (request.fd >= 0) {
+                    queue(IORING_OP_CLOSE, request.fd, nullptr, 0, requestIndex, OPERATION_CLOSE);
+                    request.fd = -1;
+                }
+
+                handOver(request.index, std::move(request.fileData), wasRead);
+                request.index = -1;
+                request.fileData = QByteArray();
+                freeRequests.push_back(requestIndex);
+            }
+
+            /**
+             * @brief Runs the handler for a file on the thread pool. If too many files are waiting to be handled, this waits
+             * for some of them to finish first, so only a bounded number of files is kept in memory.
+             */
+            void handOver(const qsizetype index, QByteArray fileData, const bool wasRead) {
+                if (wasRead) {
+                    stats.numFiles++;
+                    stats.numBytes += fileData.size();
+                }
+                else {
+                    stats.numFailedFiles++;
+                }
+
+                pendingHandlers.acquire();
+
+                threadPool->start([this, index, fileData, wasRead]() {
+                    handler(index, wasRead ? viewOf(fileData) : QByteArrayView());
+                    pendingHandlers.release();
+                });
+            }
+
+            const QStringList& filepaths;
+            const FileIngestor::FileHandler& handler;
+            QThreadPool* threadPool;
+            std::vector<Request> requests;
+            std::vector<unsigned int> freeRequests;
+            qsizetype nextIndex = 0;
+            unsigned int numPendingOperations = 0;
+
+            const int maxPendingHandlers;
+            QSemaphore pendingHandlers;     /**< One resource per file that can wait to be handled */
+
+            IoUring ring;                   /**< Declared last, so it's destroyed before the buffers it may write to */
+
+            FileIngestor::Stats stats;
+    };
+#endif
+}
+
+/**
+ * @brief Whether the io_uring backend can be used. Checked only once.
+ */
+bool FileIngestor::isIoUringAvailable() {
+#ifdef FILEINGESTOR_IO_URING
+    static const bool isAvailable = IoUring().init(4);
+    return isAvailable;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Reads every file, and hands its contents to "handler" (see "FileHandler").
+ *
+ * @note The handler has been called for every file by the time this returns.
+ */
+FileIngestor::Stats FileIngestor::ingest(const QStringList& filepaths, const FileHandler& handler, const Options& options) {
+#ifdef FILEINGESTOR_IO_URING
+    if (options.backend != BACKEND_THREAD_POOL && isIoUringAvailable()) {
+        IoUringIngestor ingestor(filepaths, handler, options);
+
+        if (ingestor.init()) {
+            ingestor.run();
+
+            Stats stats = ingestor.getStats();
+            stats.backend = BACKEND_IO_URING;
+            return stats;
+        }
+    }
+#endif
+
+    return ingestWithThreadPool(filepaths, handler, options.threadPool);
+}
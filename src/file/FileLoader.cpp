@@ -8,82 +8,181 @@
  */
 
 #include "include/file/FileLoader.h"
-#include "include/file/FileManager.h"
-#include <QDataStream>
+#include "include/file/ByteSwap.h"
 #include <QDebug>
-#include <algorithm> // std::search, std::distance
-#include <cstddef>   // offsetof
+#include <algorithm> // std::copy
+#include <cstring>   // memchr, memcmp
 
 /**
- * @brief Reads the data associated to a save slot from a file given the start offset within said file.
+ * @brief Picks the codec every save slot of the file is decoded and encoded with (see SlotCodec.h).
+ *
+ * This is the only place where the region is checked, so it must be called whenever the file's region is known
+ * (when the file is opened, and before it's written).
  */
-void FileLoader::readSaveSlot(QFile& file, SaveSlot& slot, unsigned int startOffset) {
-    QDataStream inputStream(&file);
+void FileLoader::selectSlotCodec(const short region) {
+    slotCodec = &SlotCodecTable::get(region);
+}
 
-    // Return if we reached the end of the file
-    if (startOffset >= getMaxFileSize()) {
+/**
+ * @brief Decodes a save slot from an in-memory copy of its raw data into "slot", using the codec of the file's region.
+ * Nothing is decoded if "slotData" is smaller than a save slot of that region.
+ *
+ * @note "slotData" must start at the beginning of the slot.
+ */
+void FileLoader::readSaveSlot(QByteArrayView slotData, SaveSlot& slot) const {
+    if (slotData.size() < slotCodec->saveSlotSize) {
         return;
     }
 
-    slot.mainSave = readSaveData(inputStream, startOffset);
-    slot.beginningOfStage = readSaveData(inputStream, inputStream.device()->pos());
-    slot.checksum1 = readData<unsigned int>(inputStream, inputStream.device()->pos());
-    slot.checksum2 = readData<unsigned int>(inputStream, inputStream.device()->pos());
+    // The byte order of the whole slot is converted at once (see SaveDataSchema::decodeSaveSlot())
+    slotCodec->decodeSaveSlot(slotData.constData(), slot);
 }
 
 /**
- * @brief Writes the data associated from a save slot to a file at the start offset within said file.
+ * @brief Decodes a save slot of the given region from an in-memory copy of its raw data into "slot".
+ * Nothing is decoded if "slotData" is smaller than a save slot of that region.
  */
-void FileLoader::writeSaveSlot(QFile& file, SaveSlot& slot, unsigned int startOffset) {
-    SaveManager* saveManager = SaveManager::getInstance();
-    QDataStream outputStream(&file);
+void FileLoader::decodeSaveSlot(QByteArrayView slotData, SaveSlot& slot, const short region) {
+    const SlotCodecTable& codec = SlotCodecTable::get(region);
+
+    if (slotData.size() >= codec.saveSlotSize) {
+        codec.decodeSaveSlot(slotData.constData(), slot);
+    }
+}
+
+/**
+ * @brief Encodes "slot" into a caller-owned buffer, and calculates its checksums from the encoded data.
+ *
+ * @note "slotData" must be at least "getSaveSlotSize()" bytes long.
+ */
+void FileLoader::writeSaveSlot(char* slotData, const SaveSlot& slot) const {
+    encodeSaveSlot(slotData, slot);
+    writeSaveSlotChecksums(slotData, 0, 1);
+}
 
-    unsigned int firstChecksumOffset = 0;
-    unsigned int secondChecksumOffset = 0;
-    unsigned int saveDataSize = 0;
+/**
+ * @brief Encodes "slot" into a caller-owned buffer, converting the byte order of the whole slot in a single pass.
+ * The checksums are copied as-is from "slot" (see "writeSaveSlotChecksums()").
+ *
+ * @note "slotData" must be at least "getSaveSlotSize()" bytes long.
+ */
+void FileLoader::encodeSaveSlot(char* slotData, const SaveSlot& slot) const {
+    slotCodec->encodeSaveSlot(slot, slotData);
+}
 
-    if (SaveManager::getInstance()->getRegion() == SaveData::PAL) {
-        firstChecksumOffset = offsetof(SaveSlot, checksum1);
-        secondChecksumOffset = offsetof(SaveSlot, checksum2);
-        saveDataSize = sizeof(SaveData);
+/**
+ * @brief Encodes "slot" as a save slot of the given region (see "encodeSaveSlot()" above).
+ */
+void FileLoader::encodeSaveSlot(char* slotData, const SaveSlot& slot, const short region) {
+    SlotCodecTable::get(region).encodeSaveSlot(slot, slotData);
+}
+
+/**
+ * @brief Calculates the checksums of "numSlots" already-encoded save slots, and writes them after each slot's save data.
+ * Each slot starts "stride" bytes after the previous one.
+ *
+ * All of the checksums are calculated with a single call, straight from the encoded (big endian) data.
+ */
+void FileLoader::writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots) const {
+    writeSaveSlotChecksums(firstSlotData, stride, numSlots, *slotCodec);
+}
+
+/**
+ * @brief Calculates and writes the checksums of "numSlots" already-encoded save slots of the given region
+ * (see "writeSaveSlotChecksums()" above).
+ */
+void FileLoader::writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots, const short region) {
+    writeSaveSlotChecksums(firstSlotData, stride, numSlots, SlotCodecTable::get(region));
+}
+
+/**
+ * @brief Calculates and writes the checksums of "numSlots" already-encoded save slots of the codec's region
+ * (see "writeSaveSlotChecksums()" above).
+ */
+void FileLoader::writeSaveSlotChecksums(char* firstSlotData, const unsigned int stride, const unsigned int numSlots, const SlotCodecTable& codec) {
+    const unsigned int saveDataSize = codec.saveDataSize;
+    SaveManager::SaveSlotChecksums checksums[NUM_SAVES];
+
+    for (unsigned int first = 0; first < numSlots; first += NUM_SAVES) {
+        const unsigned int count = qMin<unsigned int>(NUM_SAVES, numSlots - first);
+        char* slotData = firstSlotData + (static_cast<std::size_t>(stride) * first);
+
+        SaveManager::calcChecksums(slotData, saveDataSize, stride, count, checksums);
+
+        for (unsigned int i = 0; i < count; i++) {
+            qToBigEndian<unsigned int>(checksums[i].checksum1, slotData + (stride * i) + (saveDataSize * 2));
+            qToBigEndian<unsigned int>(checksums[i].checksum2, slotData + (stride * i) + (saveDataSize * 2) + sizeof(unsigned int));
+        }
     }
-    else {
-        // Since the PAL version of the SaveSlot added 4 extra bytes (and this project uses the PAL definition of the struct),
-        // we will remove those extra 4 bytes (plus 4 -> 8 bytes) from the offset to get the correct address to write the checksums to.
-        firstChecksumOffset = offsetof(SaveSlot, checksum1) - 8;
-        secondChecksumOffset = offsetof(SaveSlot, checksum2) - 8;
-        saveDataSize = sizeof(SaveData) - 4;
+}
+
+/**
+ * @brief Checks the checksums stored in a group of save slots against the data they protect, and fills in "statuses" for each slot.
+ * Slots that don't fit inside "fileData" are left as "CHECKSUM_STATUS_UNVERIFIED".
+ *
+ * All of the checksums are calculated with a single call, straight from the raw (big endian) data.
+ *
+ * @note "statuses" must have at least "NUM_SAVES" entries.
+ * @return The number of slots that were verified.
+ */
+unsigned int FileLoader::verifySaveSlots(QByteArrayView fileData, const SaveSlotGroup& group, SaveManager::SaveSlotStatus* statuses) const {
+    const SlotCodecTable& codec = SlotCodecTable::get(group.region);
+    const unsigned int saveDataSize = codec.saveDataSize;
+    const unsigned int saveSlotSize = codec.saveSlotSize;
+    const unsigned int stride = getSaveSlotPaddedSize();
+    SaveManager::SaveSlotChecksums checksums[NUM_SAVES];
+    unsigned int numSlots = 0;
+
+    for (int i = 0; i < NUM_SAVES; i++) {
+        statuses[i] = SaveManager::SaveSlotStatus();
+    }
+
+    // Slots are stored one after another, so only the last ones can be truncated
+    while (numSlots < qMin<unsigned int>(group.numSaveSlots, NUM_SAVES) && group.startOffset + (stride * numSlots) + saveSlotSize <= fileData.size()) {
+        numSlots++;
+    }
+
+    if (numSlots == 0) {
+        return 0;
     }
 
-    // Write the main and beginning of stage saves
-    writeSaveData(outputStream, slot.mainSave, startOffset);
-    writeSaveData(outputStream, slot.beginningOfStage, outputStream.device()->pos());
+    SaveManager::calcChecksums(fileData.constData() + group.startOffset, saveDataSize, stride, numSlots, checksums);
 
-    /**
-     * Write the checksums. To ensure the checksums are properly calculated,
-     * we convert the data to a byte array, then swap the endianness (since the save file is stored in big endian)
-     */
-    QIODevice* device = outputStream.device();
-    device->seek(startOffset);
-    QByteArray rawData = device->read(saveDataSize);
+    for (unsigned int i = 0; i < numSlots; i++) {
+        const unsigned int checksumsOffset = group.startOffset + (stride * i) + (saveDataSize * 2);
+        const bool isValid = (readData<unsigned int>(fileData, checksumsOffset) == checksums[i].checksum1 &&
+                              readData<unsigned int>(fileData, checksumsOffset + sizeof(unsigned int)) == checksums[i].checksum2);
 
-    // Convert "rawData" to big-endian
-    swapEndianness(&rawData);
+        statuses[i].mainSave = isValid ? SaveManager::CHECKSUM_STATUS_VALID : SaveManager::CHECKSUM_STATUS_INVALID;
+        statuses[i].beginningOfStage = SaveManager::CHECKSUM_STATUS_NOT_COVERED;
+        statuses[i].calculatedChecksums = checksums[i];
+    }
+
+    return numSlots;
+}
+
+/**
+ * @brief Verifies the checksums of the save slots that start at "startOffset" within "fileData"
+ * (using the region of the selected codec), and stores the results in the SaveManager.
+ */
+void FileLoader::verifyAllSaveSlots(QByteArrayView fileData, const unsigned int startOffset) {
+    SaveManager* saveManager = SaveManager::getInstance();
+    SaveManager::SaveSlotStatus statuses[NUM_SAVES];
+    SaveSlotGroup group;
 
-    // Write the SaveSlot main's checksum at the specific offsets within the SaveSlot struct
-    unsigned int firstChecksum = saveManager->calcFirstChecksum(rawData);
-    unsigned int secondChecksum = saveManager->calcSecondChecksum(rawData);
+    group.startOffset = startOffset;
+    group.region = slotCodec->region;
+    verifySaveSlots(fileData, group, statuses);
 
-    device->seek(startOffset + firstChecksumOffset);
-    outputStream << firstChecksum;
-    device->seek(startOffset + secondChecksumOffset);
-    outputStream << secondChecksum;
+    for (int i = 0; i < NUM_SAVES; i++) {
+        saveManager->setSaveSlotStatus(i, statuses[i]);
+    }
 }
 
 /**
  * @brief Returns the region numeric ID given its equivalent character ID.
  */
-short FileLoader::getRegionEnumFromChar(const unsigned char regionFromFile) {
+short FileLoader::getRegionEnumFromChar(const unsigned char regionFromFile) const {
     switch (regionFromFile) {
         default:
         case 'E':
@@ -98,500 +197,846 @@ short FileLoader::getRegionEnumFromChar(const unsigned char regionFromFile) {
 }
 
 /**
- * @brief Finds the region's character ID and sets the actual region value within the program accordingly.
+ * @brief Get the size the SaveData struct takes up inside the file.
+ *
+ * @note This project uses the PAL definition of the struct, which has 4 extra bytes
+ * (the "language" and "padding5A_PAL" fields) not found in the other versions.
  */
-void FileLoaderNote::parseRegion(QFile& file) {
-    SaveManager* saveManager = SaveManager::getInstance();
-    QDataStream inputStream(&file);
+unsigned int FileLoader::getSaveDataSize() const {
+    return slotCodec->saveDataSize;
+}
 
-    unsigned char regionFromFile = readData<unsigned char>(inputStream, getRegionIdOffset());
-    saveManager->setRegion(getRegionEnumFromChar(regionFromFile));
+/**
+ * @brief Get the size the SaveSlot struct takes up inside the file (without padding).
+ */
+unsigned int FileLoader::getSaveSlotSize() const {
+    return slotCodec->saveSlotSize;
 }
 
 /**
- * @brief Reads an entire save from the given file. The start offset for this data depends on the file format.
+ * @brief Get the offset where the raw data of the first save slot starts.
+ *
+ * For formats with a note table, it's where the note being handled starts (see "setLoadContext()").
  */
-void FileLoader::readAllSaveSlots(QFile& file) {
-    for (unsigned int i = 0; i < NUM_SAVES; i++) {
-        readSaveSlot(file, SaveManager::getInstance()->getSaveSlot(i), getRawDataOffsetStart() + (getSaveSlotPaddedSize() * i));
+unsigned int FileLoader::getRawDataOffsetStart() const {
+    if (formatDescriptor->hasNoteTable()) {
+        return loadContext.noteStartOffset;
     }
+
+    return formatDescriptor->rawDataStartOffset;
 }
 
 /**
- * @brief Writes an entire save to the given file. The start offset for this data depends on the file format.
+ * @brief Get the size of the padding data after the end of the actual save slot data.
+ *
+ * @note If each save slot starts with the header, it isn't part of the padding.
  */
-void FileLoader::writeAllSaveSlots(QFile& file) {
-    for (unsigned int i = 0; i < NUM_SAVES; i++) {
-        writeSaveSlot(file, SaveManager::getInstance()->getSaveSlot(i), getRawDataOffsetStart() + (getSaveSlotPaddedSize() * i));
+unsigned int FileLoader::getSaveSlotPaddingBytesSize() const {
+    const unsigned int headerSize = formatDescriptor->isHeaderPerSaveSlot ? formatDescriptor->headerSize : 0;
+    return getSaveSlotPaddedSize() - headerSize - getSaveSlotSize();
+}
+
+QByteArrayView FileLoader::getHeaderBytes() const {
+    return formatDescriptor->getHeaderBytes(loadContext.region);
+}
+
+/**
+ * @brief Notes contain a single group of save slots right after the header. The region is taken from the header.
+ */
+std::vector<FileLoader::SaveSlotGroup> FileLoaderNote::findSaveSlotGroups(QByteArrayView fileData) const {
+    if (fileData.size() <= getRegionIdOffset()) {
+        return {};
     }
+
+    SaveSlotGroup group;
+    group.startOffset = getRawDataOffsetStart();
+    group.region = getRegionEnumFromChar(readData<unsigned char>(fileData, getRegionIdOffset()));
+
+    return {group};
 }
 
 /**
- * @brief Reads a save data entry from the given data stream. The start offset for this data depends on the file format.
+ * @brief Writes an entire save to the given file.
+ *
+ * The whole save is serialized into a single buffer first (see "writeSaveImage()"),
+ * and then written to the file (see "writeSaveImageToFile()").
+ *
+ * @return true if the whole save was written.
  */
-const SaveData& FileLoader::readSaveData(QDataStream& inputStream, unsigned int startOffset) {
-    SaveData* currentSave = new SaveData();
+bool FileLoader::writeAllSaveSlots(QFile& file) {
+    QByteArray image;
 
-    // Seek to the start of the save data
-    inputStream.device()->seek(startOffset);
+    // The region may have been changed since the file was opened
+    selectSlotCodec(SaveManager::getInstance()->getRegion());
+    writeSaveImage(image);
 
-    // Read save data contents into "currentSave"
-    for (unsigned int i = 0; i < NUM_EVENT_FLAGS; i++) {
-        currentSave->event_flags[i] = readData<unsigned int>(inputStream, inputStream.device()->pos());
+    if (!writeSaveImageToFile(file, image)) {
+        return false;
     }
-    currentSave->flags = readData<unsigned int>(inputStream, inputStream.device()->pos());
 
-    currentSave->week = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->day = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->hour = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->minute = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->seconds = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->milliseconds = readData<unsigned short>(inputStream, inputStream.device()->pos());
-    currentSave->gameplay_framecount = readData<unsigned int>(inputStream, inputStream.device()->pos());
+    // The checksums were just recalculated, so update the status of each slot to match what's in the file now
+    verifyAllSaveSlots(image, getRawDataOffsetStart() - getSaveImageOffset());
 
-    currentSave->button_config = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->sound_mode = readData<short>(inputStream, inputStream.device()->pos());
+    return true;
+}
 
-    // PAL-exclusive data
-    if (SaveManager::getInstance()->getRegion() == SaveData::PAL) {
-        currentSave->language = readData<short>(inputStream, inputStream.device()->pos());
-        currentSave->padding5A_PAL = readData<short>(inputStream, inputStream.device()->pos());
-    }
+/**
+ * @brief Writes only the save slots that changed since the file was opened or last written (see "SaveManager::isSaveSlotDirty()").
+ *
+ * The whole save is still serialized in memory (see "writeSaveImage()"), but only the bytes of each changed slot
+ * (its save data and its checksums) are written, with one positioned write per slot (see "writeSaveImageRange()").
+ * Every other byte of the file is left untouched.
+ *
+ * @note The file must already hold the saves with the current region (see "SaveManager::hasCleanSaveSlots()").
+ * @return true if every changed slot was written.
+ */
+bool FileLoader::writeDirtySaveSlots(QFile& file) {
+    SaveManager* saveManager = SaveManager::getInstance();
+    QByteArray image;
 
-    currentSave->character = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->life = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->field_0x5C = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->subweapon = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->gold = readData<unsigned int>(inputStream, inputStream.device()->pos());
+    selectSlotCodec(saveManager->getRegion());
+    writeSaveImage(image);
 
-    for (unsigned int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
-        currentSave->items[j] = readData<unsigned char>(inputStream, inputStream.device()->pos());
+    const unsigned int firstSlotOffset = getRawDataOffsetStart() - getSaveImageOffset();
+
+    for (int i = 0; i < NUM_SAVES; i++) {
+        if (saveManager->isSaveSlotDirty(i) &&
+            !writeSaveImageRange(file, image, firstSlotOffset + (getSaveSlotPaddedSize() * i), getSaveSlotSize())) {
+            return false;
+        }
     }
 
-    currentSave->player_status = readData<unsigned int>(inputStream, inputStream.device()->pos());
-    currentSave->health_depletion_rate_while_poisoned = readData<short>(inputStream, inputStream.device()->pos());
+    // The checksums were just recalculated, so update the status of each slot to match what's in the file now
+    verifyAllSaveSlots(image, firstSlotOffset);
 
-    currentSave->current_hour_VAMP = readData<unsigned short>(inputStream, inputStream.device()->pos());
-    currentSave->map = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->spawn = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->save_crystal_number = readData<unsigned short>(inputStream, inputStream.device()->pos());
+    return true;
+}
 
-    currentSave->field51_0xb2 = readData<unsigned char>(inputStream, inputStream.device()->pos());
-    currentSave->field52_0xb3 = readData<unsigned char>(inputStream, inputStream.device()->pos());
+/**
+ * @brief Writes the serialized save with one call, at the offset given by "getSaveImageOffset()".
+ *
+ * @return true if the whole image was written.
+ */
+bool FileLoader::writeSaveImageToFile(QFile& file, const QByteArray& image) const {
+    file.seek(getSaveImageOffset());
 
-    currentSave->time_saved_counter = readData<unsigned int>(inputStream, inputStream.device()->pos());
-    currentSave->death_counter = readData<unsigned int>(inputStream, inputStream.device()->pos());
+    return (file.write(image) == image.size());
+}
 
-    currentSave->field55_0xbc = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->field59_0xc0 = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->field63_0xc4 = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->field67_0xc8 = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->field69_0xca = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->field71_0xcc = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->field75_0xd0 = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->field77_0xd2 = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->field79_0xd4 = readData<short>(inputStream, inputStream.device()->pos());
-    currentSave->field83_0xd8 = readData<int>(inputStream, inputStream.device()->pos());
-    currentSave->gold_spent_on_Renon = readData<unsigned int>(inputStream, inputStream.device()->pos());
+/**
+ * @brief Writes "size" bytes of the serialized save, starting at "offset" within it, to the same place "writeSaveImageToFile()" would.
+ *
+ * @return true if the whole range was written.
+ */
+bool FileLoader::writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const {
+    if (offset + size > image.size()) {
+        return false;
+    }
 
-    return *currentSave;
+    file.seek(getSaveImageOffset() + offset);
+
+    return (file.write(image.constData() + offset, size) == size);
+}
+
+/**
+ * @brief Serializes the save slots loaded in the SaveManager into "image" (see "encodeSaveImage()").
+ */
+void FileLoader::writeSaveImage(QByteArray& image) const {
+    SaveManager* saveManager = SaveManager::getInstance();
+    encodeSaveImage(image, saveManager->getAllSaves(), saveManager->getRegion());
 }
 
 /**
- * @brief Writes a save data entry to the given data stream. The start offset for this data depends on the file format.
+ * @brief Serializes "NUM_SAVES" save slots of the given region (along with their padding) into "image".
+ *
+ * By default, the image only contains the save slots, which are written in place
+ * starting at the raw data start offset (i.e. Controller Pak notes).
  */
-void FileLoader::writeSaveData(QDataStream& outputStream, const SaveData& saveData, unsigned int startOffset) {
-    outputStream.device()->seek(startOffset);
+void FileLoader::encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const {
+    const SlotCodecTable& codec = SlotCodecTable::get(region);
+    image.fill('\0', getSaveSlotPaddedSize() * NUM_SAVES);
 
-    for (unsigned int i = 0; i < NUM_EVENT_FLAGS; i++) {
-        writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.event_flags[i]);
+    for (unsigned int i = 0; i < NUM_SAVES; i++) {
+        codec.encodeSaveSlot(saveSlots[i], image.data() + (getSaveSlotPaddedSize() * i));
     }
 
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.flags);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.week);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.day);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.hour);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.minute);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.seconds);
-    writeData<unsigned short>(outputStream, outputStream.device()->pos(), saveData.milliseconds);
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.gameplay_framecount);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.button_config);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.sound_mode);
+    writeSaveSlotChecksums(image.data(), getSaveSlotPaddedSize(), NUM_SAVES, codec);
+}
 
-    // PAL-related saves
-    if (SaveManager::getInstance()->getRegion() == SaveData::PAL) {
-        writeData<short>(outputStream, outputStream.device()->pos(), saveData.language);
-        writeData<short>(outputStream, outputStream.device()->pos(), saveData.padding5A_PAL);
-    }
+/**
+ * @brief Decodes every group of save slots in "fileData" (see "findSaveSlotGroups()"), without going through the SaveManager.
+ * Slots that don't fit inside "fileData" are left out.
+ */
+std::vector<FileLoader::DecodedSave> FileLoader::decodeSaves(QByteArrayView fileData) const {
+    std::vector<DecodedSave> decodedSaves;
+
+    for (const SaveSlotGroup& group: findSaveSlotGroups(fileData)) {
+        const SlotCodecTable& codec = SlotCodecTable::get(group.region);
+        DecodedSave decodedSave;
+        decodedSave.region = group.region;
 
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.character);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.life);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.field_0x5C);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.subweapon);
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.gold);
+        while (decodedSave.numSaveSlots < qMin<unsigned int>(group.numSaveSlots, NUM_SAVES)) {
+            const unsigned int startOffset = group.startOffset + (getSaveSlotPaddedSize() * decodedSave.numSaveSlots);
 
-    for (unsigned int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
-        writeData<unsigned char>(outputStream, outputStream.device()->pos(), saveData.items[j]);
+            if (startOffset + codec.saveSlotSize > fileData.size()) {
+                break;
+            }
+
+            codec.decodeSaveSlot(fileData.constData() + startOffset, decodedSave.saveSlots[decodedSave.numSaveSlots]);
+            decodedSave.numSaveSlots++;
+        }
+
+        if (decodedSave.numSaveSlots != 0) {
+            decodedSaves.push_back(decodedSave);
+        }
     }
 
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.player_status);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.health_depletion_rate_while_poisoned);
-    writeData<unsigned short>(outputStream, outputStream.device()->pos(), saveData.current_hour_VAMP);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.map);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.spawn);
-    writeData<unsigned short>(outputStream, outputStream.device()->pos(), saveData.save_crystal_number);
-    writeData<unsigned char>(outputStream, outputStream.device()->pos(), saveData.field51_0xb2);
-    writeData<unsigned char>(outputStream, outputStream.device()->pos(), saveData.field52_0xb3);
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.time_saved_counter);
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.death_counter);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field55_0xbc);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field59_0xc0);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field63_0xc4);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.field67_0xc8);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.field69_0xca);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field71_0xcc);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field75_0xd0);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.field77_0xd2);
-    writeData<short>(outputStream, outputStream.device()->pos(), saveData.field79_0xd4);
-    writeData<int>(outputStream, outputStream.device()->pos(), saveData.field83_0xd8);
-    writeData<unsigned int>(outputStream, outputStream.device()->pos(), saveData.gold_spent_on_Renon);
+    return decodedSaves;
 }
 
 /**
- * @brief Get the raw header bytes for Note-formatted files.
+ * @brief Decodes the saves of a whole file, given as "fileData", without going through the SaveManager nor the FileManager.
  *
- * @note source: https://github.com/bryc/mpkedit/wiki/Note-file-formats
- * @note This implements the format last updated on Sep 29, 2023.
+ * Nothing but "fileData" and "context" is read, and nothing but "decodedFile" is written, so this can be called from any thread
+ * (with one loader per thread). The result can then be loaded with "FileManager::openDecodedFile()".
+ *
+ * @return -1 if the file doesn't have the size of its format, or if it doesn't have any save to decode.
+ * -3 if the file is fine but doesn't hold any Castlevania 64 save (i.e. a Controller Pak without Castlevania 64 notes). 0 on success.
  */
-std::vector<unsigned char> FileLoaderNote::getHeaderBytes() const {
-    switch (SaveManager::getInstance()->getRegion()) {
-        case SaveData::USA:
-            return {
-                0x01, 0x4D, 0x50, 0x4B, 0x4E, 0x6F, 0x74, 0x65, 0x00, 0x00, 0x00, 0x67,
-                0x89, 0x7E, 0x56, 0x00, 0x4E, 0x44, 0x33, 0x45, 0x41, 0x34, 0xCA, 0xFE,
-                0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x1A, 0x2C, 0x2D,
-                0x25, 0x1E, 0x2F, 0x1A, 0x27, 0x22, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00
-            };
-
-        case SaveData::JPN:
-            return {
-                0x01, 0x4D, 0x50, 0x4B, 0x4E, 0x6F, 0x74, 0x65, 0x00, 0x00, 0x00, 0x67,
-                0x89, 0x7E, 0x56, 0x00, 0x4E, 0x44, 0x33, 0x4A, 0x41, 0x34, 0xCA, 0xFE,
-                0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x1A, 0x2C, 0x2D,
-                0x25, 0x1E, 0x2F, 0x1A, 0x27, 0x22, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00
-            };
+int FileLoader::decodeFile(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const {
+    decodedFile = DecodedFile();
+    decodedFile.format = context.format;
 
-        case SaveData::PAL:
-            return {
-                0x01, 0x4D, 0x50, 0x4B, 0x4E, 0x6F, 0x74, 0x65, 0x00, 0x00, 0x00, 0x67,
-                0x89, 0x7E, 0x56, 0x00, 0x4E, 0x44, 0x33, 0x50, 0x41, 0x34, 0xCA, 0xFE,
-                0x02, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x1A, 0x2C, 0x2D,
-                0x25, 0x1E, 0x2F, 0x1A, 0x27, 0x22, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00
-            };
+    if (!hasValidFileSize(fileData.size())) {
+        return -1;
     }
 
-    return {};
+    return decodeFileContents(fileData, context, decodedFile);
 }
 
 /**
- * @note Cartridge saves are exclusive to the Japanese version.
+ * @brief Checks that a file has the size of its format.
  */
-void FileLoaderCartridge::parseRegion(QFile& file) {
-    SaveManager::getInstance()->setRegion(SaveData::JPN);
+bool FileLoader::hasValidFileSize(const qsizetype fileSize) const {
+    return fileSize == formatDescriptor->maxFileSize;
 }
 
-std::vector<unsigned char> FileLoaderCartridge::getHeaderBytes() const {
-    return {
-        0x4B, 0x43, 0x45, 0x4B, 0x20, 0x46, 0x6F, 0x72, 0x6D, 0x61, 0x74, 0x20, 0x31, 0x32, 0x30, 0x39
-    };
+/**
+ * @brief By default, the saves are taken from the first group of save slots in the file (see "findSaveSlotGroups()").
+ *
+ * @note "context" is ignored here: files without a note table nor parts only have one group of save slots to choose from.
+ */
+int FileLoader::decodeFileContents(QByteArrayView fileData, [[maybe_unused]] const LoadContext& context, DecodedFile& decodedFile) const {
+    const std::vector<SaveSlotGroup> groups = findSaveSlotGroups(fileData);
+
+    if (groups.empty() || groups.front().startOffset >= fileData.size()) {
+        return -1;
+    }
+
+    return decodeSaveSlotsData(fileData.sliced(groups.front().startOffset), groups.front().region, decodedFile);
 }
 
 /**
- * @brief Get the raw save slot size + its padding.
+ * @brief Decodes (and verifies the checksums of) the save slots stored one after another in "saveSlotsData",
+ * with the first slot at the very beginning. Slots that don't fit inside "saveSlotsData" are left out.
+ *
+ * @return -1 if not even one slot fits. 0 otherwise.
  */
-unsigned int FileLoaderNote::getSaveSlotPaddedSize() const {
-    return sizeof(SaveSlot) + (getSavePaddedSize() - sizeof(SaveSlot));
+int FileLoader::decodeSaveSlotsData(QByteArrayView saveSlotsData, const short region, DecodedFile& decodedFile) const {
+    const SlotCodecTable& codec = SlotCodecTable::get(region);
+    SaveSlotGroup group;
+
+    group.startOffset = 0;
+    group.region = region;
+    decodedFile.region = region;
+    decodedFile.numSaveSlots = 0;
+
+    while (decodedFile.numSaveSlots < NUM_SAVES &&
+           (getSaveSlotPaddedSize() * decodedFile.numSaveSlots) + codec.saveSlotSize <= saveSlotsData.size()) {
+        codec.decodeSaveSlot(saveSlotsData.constData() + (getSaveSlotPaddedSize() * decodedFile.numSaveSlots),
+                             decodedFile.saveSlots[decodedFile.numSaveSlots]);
+        decodedFile.numSaveSlots++;
+    }
+
+    verifySaveSlots(saveSlotsData, group, decodedFile.saveSlotStatus);
+
+    return (decodedFile.numSaveSlots != 0) ? 0 : -1;
 }
 
 /**
- * @note Always 0x900 bytes in practice.
+ * @brief Decodes a save data entry from an in-memory copy of the save slot into "saveData".
+ * The start offset is relative to the start of "slotData".
+ *
+ * The field layout comes from the table in SaveDataSchema.h.
  */
-unsigned int FileLoaderNote::getMaxFileSize() const {
-    unsigned int headerSize = getHeaderBytes().size();
-    unsigned int maxFileSize = headerSize + (getSaveSlotPaddedSize() * NUM_SAVES) + getUnusedExtraSize();
+void FileLoader::readSaveData(QByteArrayView slotData, unsigned int startOffset, SaveData& saveData) const {
+    slotCodec->decodeSaveData(slotData.constData() + startOffset, saveData);
+}
 
-    return maxFileSize;
-};
+/**
+ * @brief Encodes a save data entry into a caller-owned buffer.
+ * The start offset is relative to the start of "slotData".
+ *
+ * The field layout comes from the table in SaveDataSchema.h.
+ */
+void FileLoader::writeSaveData(char* slotData, unsigned int startOffset, const SaveData& saveData) const {
+    slotCodec->encodeSaveData(saveData, slotData + startOffset);
+}
 
-bool FileLoader::searchHexInFile(const QByteArray& data, const std::vector<unsigned char>& target) {
-    if (data.isEmpty() || target.empty()) {
-        return false;
+/**
+ * @brief Cartridge saves contain a single group of save slots, each preceded by the header. They're always Japanese saves.
+ */
+std::vector<FileLoader::SaveSlotGroup> FileLoaderCartridge::findSaveSlotGroups(QByteArrayView fileData) const {
+    if (fileData.size() < static_cast<qsizetype>(getRawDataOffsetStart() + getSaveSlotSize())) {
+        return {};
     }
 
-    // Convert QByteArray to std::vector<unsigned char>
-    std::vector<unsigned char> fileContents(data.begin(), data.end());
+    SaveSlotGroup group;
+    group.startOffset = getRawDataOffsetStart();
+    group.region = SaveData::JPN;
 
-    // Search for the target sequence
-    auto it = std::search(fileContents.begin(), fileContents.end(), target.begin(), target.end());
+    return {group};
+}
 
-    return it != fileContents.end(); // True if found, false otherwise
+/**
+ * @brief Cartridge saves are made up of whole save slots.
+ */
+bool FileLoaderCartridge::hasValidFileSize(const qsizetype fileSize) const {
+    return fileSize > 0 && (fileSize % getSaveSlotPaddedSize()) == 0;
 }
 
-unsigned int FileLoaderNote::countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const {
-    if (data.isEmpty() || target.empty()) {
-        return 0;
+/**
+ * @brief Every save slot of a cartridge save must start with the header, so the file has to be as big as
+ * the number of saves found in it, and have at least one of them (see "getCartridgeNumSaves()").
+ *
+ * @note The EEPROM inside .srm files has a fixed size instead (see "FormatDescriptors::SRM_EEPROM"), so only its own bytes are searched.
+ */
+int FileLoaderCartridge::decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const {
+    const bool hasFixedSize = (getMaxFileSize() != 0);
+    const unsigned int numSaves = getCartridgeNumSaves(hasFixedSize ? fileData.first(qMin<qsizetype>(fileData.size(), getMaxFileSize())) : fileData);
+
+    if (numSaves == 0 || (!hasFixedSize && fileData.size() != static_cast<qsizetype>(getSaveSlotPaddedSize() * numSaves))) {
+        return -1;
     }
 
-    // Convert QByteArray to std::vector<unsigned char>
-    std::vector<unsigned char> fileContents(data.begin(), data.end());
+    return FileLoader::decodeFileContents(fileData, context, decodedFile);
+}
+
+/**
+ * @brief Finds every (non-overlapping) occurrence of "target" within "data" in a single pass, without copying the data.
+ *
+ * "memchr" (which is vectorized in every common C library) is used to skip straight to the next possible match
+ * by looking for the first byte of "target", and each candidate is then verified with "memcmp".
+ *
+ * @return The offsets of all occurrences, in ascending order.
+ */
+std::vector<unsigned int> FileLoader::findHexOccurrences(QByteArrayView data, QByteArrayView target) {
+    std::vector<unsigned int> offsets;
+
+    if (data.isEmpty() || target.isEmpty() || target.size() > data.size()) {
+        return offsets;
+    }
 
-    int count = 0;
-    auto it = fileContents.begin();
+    const char* begin = data.constData();
+    const char* current = begin;
+    const char* lastCandidate = begin + (data.size() - target.size());
 
-    // Search for all occurrences
-    while (searchHexInFile(data, target)) {
-        ++count;
-        // Move past this occurrence
-        it += getSaveSlotPaddedSize();
+    while (current <= lastCandidate) {
+        const char* candidate = static_cast<const char*>(memchr(current, target[0], (lastCandidate - current) + 1));
 
-        // Break if the iterator reaches or exceeds the end of the buffer
-        if (std::distance(fileContents.begin(), it) >= fileContents.size()) {
+        if (candidate == nullptr) {
             break;
         }
+
+        if (memcmp(candidate, target.constData(), target.size()) == 0) {
+            offsets.push_back(static_cast<unsigned int>(candidate - begin));
+            current = candidate + target.size();
+        }
+        else {
+            current = candidate + 1;
+        }
     }
 
-    return count;
+    return offsets;
 }
 
-unsigned int FileLoaderCartridge::countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const {
-    if (data.isEmpty() || target.empty()) {
-        return 0;
+/**
+ * @brief Given a cartridge save (which has dynamic size), return the number of saves it currently has.
+ *
+ * Each save slot starts with its own header, so the number of times the header is found at the start of a slot
+ * is equal to the number of saves the file has. Bytes inside the save data can never be mistaken for one.
+ */
+unsigned int FileLoaderCartridge::getCartridgeNumSaves(QByteArrayView fileData) const {
+    unsigned int numSaves = 0;
+
+    for (const unsigned int offset: findHexOccurrences(fileData, getFormatDescriptor().getHeaderBytes(SaveData::JPN))) {
+        if (offset % getSaveSlotPaddedSize() == 0) {
+            numSaves++;
+        }
     }
 
-    // Convert QByteArray to std::vector<unsigned char>
-    std::vector<unsigned char> fileContents(data.begin(), data.end());
+    return numSaves;
+}
 
-    int count = 0;
-    auto it = fileContents.begin();
+/**
+ * @brief Controller Paks contain one group of save slots for each Castlevania 64 note in the note table.
+ *
+ * Notes are followed through the index table (see ControllerPakImage.h), so fragmented notes are split into
+ * one group for each run of save slots that are stored one after another. Slots whose pages aren't next to each other
+ * can't be checked in place, so they're left out.
+ *
+ * @note This parses the file system straight from "fileData", so it doesn't depend on which note is currently selected.
+ */
+std::vector<FileLoader::SaveSlotGroup> FileLoaderControllerPak::findSaveSlotGroups(QByteArrayView fileData) const {
+    std::vector<SaveSlotGroup> groups;
+    const QByteArrayView pakData = getControllerPakData(fileData);
+    const unsigned int pagesPerSaveSlot = getSaveSlotPaddedSize() / ControllerPakImage::PAGE_SIZE;
+    ControllerPakImage pakImage;
+
+    if (pakImage.parse(pakData) != 0) {
+        return groups;
+    }
 
-    // Search for all occurrences
-    while (searchHexInFile(data, target)) {
-        ++count;
-        // Move past this occurrence
-        it += getSaveSlotPaddedSize();
+    for (unsigned int i = 0; i < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES; i++) {
+        const ControllerPakImage::NoteEntry& note = pakImage.getNote(i);
 
-        // Break if the iterator reaches or exceeds the end of the buffer
-        if (std::distance(fileContents.begin(), it) >= fileContents.size()) {
-            break;
+        if (!note.isUsed() || !ControllerPakImage::isCastlevaniaGameId(note.gameId)) {
+            continue;
+        }
+
+        const ControllerPakImage::PageChain pageChain = pakImage.getPageChain(pakData, i);
+        SaveSlotGroup group;
+        group.region = getRegionEnumFromChar(note.gameId[3]);
+        group.numSaveSlots = 0;
+
+        for (unsigned int slot = 0; slot < NUM_SAVES; slot++) {
+            const unsigned int firstPage = slot * pagesPerSaveSlot;
+
+            if (!pageChain.isContiguous(firstPage, pagesPerSaveSlot)) {
+                if (group.numSaveSlots != 0) {
+                    groups.push_back(group);
+                    group.numSaveSlots = 0;
+                }
+
+                continue;
+            }
+
+            const unsigned int startOffset = getFormatDescriptor().pakDataOffset + pageChain.getPageOffset(firstPage);
+
+            // Start a new group, unless this slot comes right after the last one
+            if (group.numSaveSlots != 0 && startOffset != group.startOffset + (getSaveSlotPaddedSize() * group.numSaveSlots)) {
+                groups.push_back(group);
+                group.numSaveSlots = 0;
+            }
+
+            if (group.numSaveSlots == 0) {
+                group.startOffset = startOffset;
+            }
+
+            group.numSaveSlots++;
+        }
+
+        if (group.numSaveSlots != 0) {
+            groups.push_back(group);
         }
     }
 
-    return count;
+    return groups;
 }
 
-unsigned int FileLoaderControllerPak::countHexOccurrences(const QByteArray& data, const std::vector<unsigned char>& target) const {
-    if (data.isEmpty() || target.empty()) {
-        return 0;
+/**
+ * @brief Decodes every Castlevania 64 note in the Controller Pak, following its pages (so fragmented notes are decoded whole).
+ *
+ * @note This parses the file system straight from "fileData", so it doesn't depend on which note is currently selected.
+ */
+std::vector<FileLoader::DecodedSave> FileLoaderControllerPak::decodeSaves(QByteArrayView fileData) const {
+    std::vector<DecodedSave> decodedSaves;
+    const QByteArrayView pakData = getControllerPakData(fileData);
+    ControllerPakImage pakImage;
+
+    if (pakImage.parse(pakData) != 0) {
+        return decodedSaves;
     }
 
-    // Convert QByteArray to std::vector<unsigned char>
-    std::vector<unsigned char> fileContents(data.begin(), data.end());
+    for (unsigned int i = 0; i < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES; i++) {
+        const ControllerPakImage::NoteEntry& note = pakImage.getNote(i);
 
-    int count = 0;
-    auto it = fileContents.begin();
+        if (!note.isUsed() || !ControllerPakImage::isCastlevaniaGameId(note.gameId)) {
+            continue;
+        }
 
-    // Search for all occurrences
-    while (searchHexInFile(data, target)) {
-        ++count;
-        // Move past this occurrence
-        it += getSaveSlotPaddedSize();
+        const ControllerPakImage::PageChain pageChain = pakImage.getPageChain(pakData, i);
+        DecodedSave decodedSave;
+        decodedSave.region = getRegionEnumFromChar(note.gameId[3]);
 
-        // Break if the iterator reaches or exceeds the end of the buffer
-        if (std::distance(fileContents.begin(), it) >= fileContents.size()) {
-            break;
+        const SlotCodecTable& codec = SlotCodecTable::get(decodedSave.region);
+        char slotData[sizeof(SaveSlot)];
+
+        while (decodedSave.numSaveSlots < NUM_SAVES &&
+               pageChain.copyTo(getSaveSlotPaddedSize() * decodedSave.numSaveSlots, codec.saveSlotSize, slotData) == codec.saveSlotSize) {
+            codec.decodeSaveSlot(slotData, decodedSave.saveSlots[decodedSave.numSaveSlots]);
+            decodedSave.numSaveSlots++;
+        }
+
+        if (decodedSave.numSaveSlots != 0) {
+            decodedSaves.push_back(decodedSave);
         }
     }
 
-    return count;
+    return decodedSaves;
 }
 
 /**
- * @brief Given a cartridge save (which has dynamic size), return the number of saves it currently has.
+ * @brief Decodes the note given by "context" (or the first Castlevania 64 note), following its pages.
+ *
+ * @note This parses the file system straight from "fileData", so it doesn't depend on which note is currently selected.
+ * The parsed file system is kept in "decodedFile", so the note can be written back later.
+ * @return -3 if no note is given and the Controller Pak doesn't have any Castlevania 64 note (see "decodeFile()").
  */
-unsigned int FileLoaderCartridge::getCartridgeNumSaves() const {
-    // We search the number of times the cartridge header data has been found, which is equal to the number of saves the file has
-    return countHexOccurrences(FileManager::getInstance()->getBuffer(), getHeaderBytes());
-}
+int FileLoaderControllerPak::decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const {
+    const QByteArrayView pakData = getControllerPakData(fileData);
+    ControllerPakImage& pakImage = decodedFile.controllerPakImage;
+
+    if (pakImage.parse(pakData) != 0) {
+        return -1;
+    }
+
+    int noteIndex = context.noteIndex;
+
+    if (noteIndex < 0) {
+        for (unsigned int i = 0; noteIndex < 0 && i < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES; i++) {
+            if (pakImage.getNote(i).isUsed() && ControllerPakImage::isCastlevaniaGameId(pakImage.getNote(i).gameId)) {
+                noteIndex = i;
+            }
+        }
+
+        if (noteIndex < 0) {
+            return -3;
+        }
+    }
+
+    if (noteIndex < 0 || noteIndex >= static_cast<int>(ControllerPakImage::NOTE_TABLE_NUM_ENTRIES) ||
+        !pakImage.getNote(noteIndex).isUsed() || !ControllerPakImage::isCastlevaniaGameId(pakImage.getNote(noteIndex).gameId)) {
+        return -1;
+    }
+
+    // Notes stored in consecutive pages are decoded in place. Otherwise, their pages are copied in order first
+    const ControllerPakImage::PageChain pageChain = pakImage.getPageChain(pakData, noteIndex);
+    const unsigned int size = qMin(pageChain.getNumPages() * ControllerPakImage::PAGE_SIZE, getSaveSlotPaddedSize() * NUM_SAVES);
+    QByteArrayView saveSlotsData = pageChain.sliced(0, size);
+    QByteArray noteCopy;
 
-unsigned int FileLoaderCartridge::getSaveSlotPaddedSize() const {
-    unsigned int headerSize = getHeaderBytes().size();
+    if (saveSlotsData.isEmpty() && size != 0) {
+        noteCopy.resize(size);
+        noteCopy.resize(pageChain.copyTo(0, size, noteCopy.data()));
+        saveSlotsData = noteCopy;
+    }
+
+    decodedFile.noteIndex = noteIndex;
 
-    // The complete save slot ends at offset 0x1F0, not 0x200, so we remove -0x10 bytes from it.
-    // Besides, each slot now starts with the header data.
-    return headerSize + (sizeof(SaveSlot) + (getSavePaddedSize() - sizeof(SaveSlot))) - 0x10;
+    return decodeSaveSlotsData(saveSlotsData, getRegionEnumFromChar(pakImage.getNote(noteIndex).gameId[3]), decodedFile);
 }
 
 /**
- * @note Cartridge saves have variable size.
+ * @brief Writes the serialized save slots into the pages of the currently selected note (see "writeSaveImageToPages()").
+ *
+ * @return true if the whole image was written.
  */
-unsigned int FileLoaderCartridge::getMaxFileSize() const {
-    unsigned int maxFileSize = getSaveSlotPaddedSize() * getCartridgeNumSaves();
-
-    return maxFileSize;
-};
+bool FileLoaderControllerPak::writeSaveImageToFile(QFile& file, const QByteArray& image) const {
+    // No note is selected (i.e. the file doesn't have a Castlevania 64 note), so there's nowhere to write to
+    if (getLoadContext().notePages.empty()) {
+        return false;
+    }
 
-void FileLoaderControllerPak::parseRegion(QFile& file) {
-    std::vector<FileManager::ControllerPakNotetableData>* noteTableArray = FileManager::getInstance()->getControllerPakNotetableDataArray();
+    const ControllerPakImage::PageChain pageChain(QByteArrayView(), getLoadContext().notePages);
 
-    // Set the region of the currently selected Controller Pak save
-    SaveManager::getInstance()->setRegion((*noteTableArray)[FileManager::getInstance()->getControllerPakCurrentlySelectedSaveIndex()].region);
+    return writeSaveImageToPages(file, image, pageChain);
 }
 
-unsigned int FileLoaderControllerPak::getRawDataOffsetStart() const {
-    // We obtain the raw data offset start from the note table data.
-    std::vector<FileManager::ControllerPakNotetableData>* noteTableArray = FileManager::getInstance()->getControllerPakNotetableDataArray();
-    return (*noteTableArray)[FileManager::getInstance()->getControllerPakCurrentlySelectedSaveIndex()].rawDataStartOffset;
-}
+/**
+ * @brief Writes "size" bytes of the serialized save slots, starting at "offset" within them, into the pages of the currently selected note.
+ *
+ * @return true if the whole range was written.
+ */
+bool FileLoaderControllerPak::writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const {
+    // No note is selected (i.e. the file doesn't have a Castlevania 64 note), so there's nowhere to write to
+    if (getLoadContext().notePages.empty()) {
+        return false;
+    }
+
+    const ControllerPakImage::PageChain pageChain(QByteArrayView(), getLoadContext().notePages);
 
-unsigned int FileLoaderControllerPak::getSaveSlotPaddedSize() const {
-    return sizeof(SaveSlot) + (getSavePaddedSize() - sizeof(SaveSlot));
+    return writeSaveImageToPages(file, image, pageChain, offset, size);
 }
 
 /**
- * @note Always 0x8000 bytes
+ * @brief Writes the serialized save slots into the pages of the note described by "pageChain" (for formats with a note table),
+ * with one positioned write per run of consecutive pages. Nothing outside of those pages is touched.
+ *
+ * @return true if the whole image was written.
  */
-unsigned int FileLoaderControllerPak::getMaxFileSize() const {
-    return 0x8000;
-};
+bool FileLoader::writeSaveImageToPages(QFile& file, const QByteArray& image, const ControllerPakImage::PageChain& pageChain) const {
+    return writeSaveImageToPages(file, image, pageChain, 0, image.size());
+}
 
 /**
- * @note In DexDrive saves, the Controller Pak data actually starts at 0x1040.
+ * @brief Writes "size" bytes of the serialized save slots, starting at "offset" within them, into the pages of the note
+ * described by "pageChain" (see "writeSaveImageToPages()" above). Only the part of each run of pages that overlaps the range is written.
+ *
+ * @return true if the whole range was written.
  */
-unsigned int FileLoaderDexDrive::getMaxFileSize() const {
-    return 0x8000 + 0x1040;
-};
+bool FileLoader::writeSaveImageToPages(QFile& file, const QByteArray& image, const ControllerPakImage::PageChain& pageChain,
+                                       const unsigned int offset, const unsigned int size) const {
+    const std::vector<ControllerPakImage::PageChain::Run> runs = pageChain.getRuns(image.size());
+    const unsigned int end = offset + size;
+    unsigned int numBytesWritten = 0;
+
+    if (runs.empty() || end > image.size()) {
+        return false;
+    }
+
+    for (const ControllerPakImage::PageChain::Run& run: runs) {
+        const unsigned int runStart = qMax(run.noteOffset, offset);
+        const unsigned int runEnd = qMin(run.noteOffset + run.size, end);
+
+        if (runStart >= runEnd) {
+            continue;
+        }
+
+        file.seek(getFormatDescriptor().pakDataOffset + run.pakOffset + (runStart - run.noteOffset));
+
+        if (file.write(image.constData() + runStart, runEnd - runStart) != runEnd - runStart) {
+            return false;
+        }
+
+        numBytesWritten += runEnd - runStart;
+    }
+
+    return numBytesWritten == size;
+}
 
 /**
  * @brief Given an byte array, it swaps the endianness between little endian<->big endian
+ *
+ * Every 32-bit word is swapped. The actual kernel (SIMD or scalar) is chosen at runtime, see ByteSwap.h.
  */
 void FileLoader::swapEndianness(QByteArray* rawData) {
     if (!rawData || rawData->size() < 4) {
         return;
     }
 
-    char* data = rawData->data();
-    int dataSize = rawData->size();
+    ByteSwap::swap32(rawData->data(), rawData->size());
+}
+
+/**
+ * @brief Serializes the whole cartridge save into "image". Each save slot is preceded by its own copy of the header.
+ */
+void FileLoaderCartridge::encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const {
+    const QByteArrayView headerBytes = getFormatDescriptor().getHeaderBytes(region);
+
+    // The padding bytes at the end of each saveslot are already zeroed here
+    image.fill('\0', getSaveSlotPaddedSize() * NUM_SAVES);
+
+    for (unsigned int i = 0; i < NUM_SAVES; i++) {
+        char* saveSlotStart = image.data() + (getSaveSlotPaddedSize() * i);
 
-    for (int i = 0; i + 3 < dataSize; i += 4) {
-        std::swap(data[i], data[i + 3]);
-        std::swap(data[i + 1], data[i + 2]);
+        // First, write the header, then the saveslot data
+        std::copy(headerBytes.begin(), headerBytes.end(), saveSlotStart);
+        encodeSaveSlot(saveSlotStart + headerBytes.size(), saveSlots[i], region);
     }
+
+    writeSaveSlotChecksums(image.data() + headerBytes.size(), getSaveSlotPaddedSize(), NUM_SAVES, region);
 }
 
-void FileLoaderCartridge::writeAllSaveSlots(QFile& file) {
-    file.seek(0);
+/**
+ * @brief Serializes the whole note into "image".
+ */
+void FileLoaderNote::encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const {
+    const QByteArrayView headerBytes = getFormatDescriptor().getHeaderBytes(region);
+
+    // The padding bytes at the end of each saveslot and at the end of the whole file are already zeroed here
+    image.fill('\0', getMaxFileSize());
+
+    // First, write the header, then the saveslot data
+    std::copy(headerBytes.begin(), headerBytes.end(), image.data());
 
     for (unsigned int i = 0; i < NUM_SAVES; i++) {
-        // First, write the header, then the saveslot data
-        std::vector<unsigned char> headerBytes = getHeaderBytes();
+        encodeSaveSlot(image.data() + getRawDataOffsetStart() + (getSaveSlotPaddedSize() * i), saveSlots[i], region);
+    }
 
-        if (!headerBytes.empty()) {
-            file.write(reinterpret_cast<const char*>(headerBytes.data()), headerBytes.size());
-        }
+    writeSaveSlotChecksums(image.data() + getRawDataOffsetStart(), getSaveSlotPaddedSize(), NUM_SAVES, region);
+}
 
-        writeSaveSlot(file, SaveManager::getInstance()->getSaveSlot(i), getRawDataOffsetStart() + (getSaveSlotPaddedSize() * i));
+/**
+ * @brief The context is shared with the loader of every part, and the part given by it is selected (see "selectPart()").
+ */
+void FileLoaderSrm::setLoadContext(const LoadContext& loadContext_) {
+    eepromLoader.setLoadContext(loadContext_);
 
-        // Add padding bytes at the end of each saveslot
-        std::vector<unsigned char> paddingBytes(getSaveSlotPaddingBytesSize(), 0);
-        file.write(reinterpret_cast<const char*>(paddingBytes.data()), paddingBytes.size());
+    for (FileLoaderControllerPak& controllerPakLoader: controllerPakLoaders) {
+        controllerPakLoader.setLoadContext(loadContext_);
     }
+
+    FileLoader::setLoadContext(loadContext_);
+    selectPart(loadContext_.srmPart);
 }
 
-void FileLoaderNote::writeAllSaveSlots(QFile& file) {
-    file.seek(0);
+/**
+ * @brief Selects the part of the file to handle (see "ePart"), and takes on its layout.
+ * The selected part is kept in the context (see "getLoadContext()").
+ */
+void FileLoaderSrm::selectPart(const int part_) {
+    LoadContext partContext = getLoadContext();
 
-    // First, write the header, then the saveslot data
-    std::vector<unsigned char> headerBytes = getHeaderBytes();
-    if (!headerBytes.empty()) {
-        file.write(reinterpret_cast<const char*>(headerBytes.data()), headerBytes.size());
+    if (part_ < PART_EEPROM || part_ > PART_CONTROLLER_PAK_1 + static_cast<int>(FormatDescriptors::SRM_NUM_CONTROLLER_PAKS) - 1) {
+        part = PART_NONE;
+        setFormatDescriptor(FormatDescriptors::SRM);
+    }
+    else {
+        part = part_;
+        setFormatDescriptor(getPartLoader()->getFormatDescriptor());
     }
 
-    for (unsigned int i = 0; i < NUM_SAVES; i++) {
-        writeSaveSlot(file, SaveManager::getInstance()->getSaveSlot(i), getRawDataOffsetStart() + (getSaveSlotPaddedSize() * i));
+    partContext.srmPart = part;
+    FileLoader::setLoadContext(partContext);
+}
 
-        // Add padding bytes at the end of each saveslot
-        std::vector<unsigned char> paddingSlotBytes(getSaveSlotPaddingBytesSize(), 0);
-        file.write(reinterpret_cast<const char*>(paddingSlotBytes.data()), paddingSlotBytes.size());
+FileLoader* FileLoaderSrm::getPartLoader() {
+    return const_cast<FileLoader*>(static_cast<const FileLoaderSrm*>(this)->getPartLoader());
+}
+
+const FileLoader* FileLoaderSrm::getPartLoader() const {
+    return getPartLoader(part);
+}
+
+/**
+ * @return nullptr if "part_" isn't a valid part (see "ePart").
+ */
+const FileLoader* FileLoaderSrm::getPartLoader(const int part_) const {
+    if (part_ == PART_EEPROM) {
+        return &eepromLoader;
+    }
+    else if (part_ >= PART_CONTROLLER_PAK_1 && part_ < PART_CONTROLLER_PAK_1 + static_cast<int>(FormatDescriptors::SRM_NUM_CONTROLLER_PAKS)) {
+        return &controllerPakLoaders[part_ - PART_CONTROLLER_PAK_1];
     }
 
-    // Add padding bytes at the end of the whole file
-    std::vector<unsigned char> paddingBytes(getUnusedExtraSize(), 0);
-    file.write(reinterpret_cast<const char*>(paddingBytes.data()), paddingBytes.size());
+    return nullptr;
 }
 
 /**
- * @brief Get the size of the padding data after the end of the actual save slot data.
+ * @brief The EEPROM holds Castlevania 64 saves if its first slot starts with the cartridge header.
  */
-unsigned int FileLoaderNote::getSaveSlotPaddingBytesSize() const {
-    unsigned int paddingBytes = getSavePaddedSize() - sizeof(SaveSlot);
+bool FileLoaderSrm::hasEepromSaves(QByteArrayView fileData) const {
+    const QByteArrayView headerBytes = FormatDescriptors::SRM_EEPROM.getHeaderBytes(SaveData::JPN);
 
-    switch (SaveManager::getInstance()->getRegion()) {
-        case SaveData::USA:
-        case SaveData::JPN:
-        default:
-            // Add the extra 8 bytes found in the PAL version of the saveslot
-            return paddingBytes + 8;
+    return fileData.size() >= FormatDescriptors::SRM_EEPROM_SIZE && fileData.first(headerBytes.size()) == headerBytes;
+}
 
-        case SaveData::PAL:
-            return paddingBytes;
+/**
+ * @brief Finds the part of the file that holds Castlevania 64 saves: the EEPROM if it has any,
+ * or the first Controller Pak with a Castlevania 64 note otherwise.
+ *
+ * @return "PART_NONE" if there are no Castlevania 64 saves in the file.
+ */
+int FileLoaderSrm::findDefaultPart(QByteArrayView fileData) const {
+    if (hasEepromSaves(fileData)) {
+        return PART_EEPROM;
+    }
+
+    for (unsigned int i = 0; i < FormatDescriptors::SRM_NUM_CONTROLLER_PAKS; i++) {
+        ControllerPakImage pakImage;
+
+        if (pakImage.parse(controllerPakLoaders[i].getControllerPakData(fileData)) != 0) {
+            continue;
+        }
+
+        for (unsigned int note = 0; note < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES; note++) {
+            if (pakImage.getNote(note).isUsed() && ControllerPakImage::isCastlevaniaGameId(pakImage.getNote(note).gameId)) {
+                return PART_CONTROLLER_PAK_1 + i;
+            }
+        }
+    }
+
+    return PART_NONE;
+}
+
+void FileLoaderSrm::encodeSaveImage(QByteArray& image, const SaveSlot* saveSlots, const short region) const {
+    if (getPartLoader() != nullptr) {
+        getPartLoader()->encodeSaveImage(image, saveSlots, region);
     }
 }
 
 /**
- * @brief Get the size of the padding data after the end of the actual save slot data.
+ * @note The offsets of every part are relative to the start of the .srm file, so they're written in place.
  */
-unsigned int FileLoaderCartridge::getSaveSlotPaddingBytesSize() const {
-    short region = SaveManager::getInstance()->getRegion();
+bool FileLoaderSrm::writeSaveImageToFile(QFile& file, const QByteArray& image) const {
+    return (getPartLoader() != nullptr) && getPartLoader()->writeSaveImageToFile(file, image);
+}
 
-    // Remove the extra 8 bytes found in the PAL version of the saveslot
-    // (when applicable)
-    unsigned int extraByteData = (region == SaveData::PAL) ? 0 : 8;
-    unsigned int paddingBytes = getSavePaddedSize() - (sizeof(SaveSlot) - extraByteData) - getHeaderBytes().size();
+bool FileLoaderSrm::writeSaveImageRange(QFile& file, const QByteArray& image, const unsigned int offset, const unsigned int size) const {
+    return (getPartLoader() != nullptr) && getPartLoader()->writeSaveImageRange(file, image, offset, size);
+}
 
-    return paddingBytes;
+unsigned int FileLoaderSrm::getSaveImageOffset() const {
+    return (getPartLoader() != nullptr) ? getPartLoader()->getSaveImageOffset() : 0;
 }
 
-int FileLoaderNote::checkFileOpenErrors() {
-    FileManager* fileManager = FileManager::getInstance();
+/**
+ * @brief Every part of the file with Castlevania 64 saves contributes its own groups of save slots,
+ * regardless of which part is selected.
+ */
+std::vector<FileLoader::SaveSlotGroup> FileLoaderSrm::findSaveSlotGroups(QByteArrayView fileData) const {
+    std::vector<SaveSlotGroup> groups;
 
-    // Ensure the file has the predefined size (0x900 bytes in practice)
-    if (fileManager->getFile().size() != getMaxFileSize()) {
-        return -1;
+    if (hasEepromSaves(fileData)) {
+        groups = eepromLoader.findSaveSlotGroups(fileData);
     }
 
-    return 0;
+    for (const FileLoaderControllerPak& controllerPakLoader: controllerPakLoaders) {
+        const std::vector<SaveSlotGroup> controllerPakGroups = controllerPakLoader.findSaveSlotGroups(fileData);
+        groups.insert(groups.end(), controllerPakGroups.begin(), controllerPakGroups.end());
+    }
+
+    return groups;
 }
 
-int FileLoaderCartridge::checkFileOpenErrors() {
-    FileManager* fileManager = FileManager::getInstance();
+/**
+ * @brief Decodes the saves of every part of the file, regardless of which part is selected.
+ */
+std::vector<FileLoader::DecodedSave> FileLoaderSrm::decodeSaves(QByteArrayView fileData) const {
+    std::vector<DecodedSave> decodedSaves;
 
-    // Ensure the file has the predefined size (0x900 bytes in practice),
-    // + that there's at least one valid save on it.
-    if (fileManager->getFile().size() != getMaxFileSize() ||
-        getCartridgeNumSaves() == 0) {
-        return -1;
+    if (hasEepromSaves(fileData)) {
+        decodedSaves = eepromLoader.decodeSaves(fileData);
     }
 
-    return 0;
+    for (const FileLoaderControllerPak& controllerPakLoader: controllerPakLoaders) {
+        const std::vector<DecodedSave> controllerPakSaves = controllerPakLoader.decodeSaves(fileData);
+        decodedSaves.insert(decodedSaves.end(), controllerPakSaves.begin(), controllerPakSaves.end());
+    }
+
+    return decodedSaves;
 }
 
-int FileLoaderControllerPak::checkFileOpenErrors() {
-    FileManager* fileManager = FileManager::getInstance();
+bool FileLoaderSrm::hasValidFileSize(const qsizetype fileSize) const {
+    return fileSize == FormatDescriptors::SRM_FILE_SIZE;
+}
 
-    // Ensure the file has the predefined size (0x900 bytes in practice)
-    if (fileManager->getFile().size() != getMaxFileSize()) {
-        return -1;
+/**
+ * @brief Decodes the part given by "context" (or the default part, see "findDefaultPart()") through its own loader.
+ * The selected part of this loader isn't changed.
+ *
+ * @return -3 if no part is given and no part of the file has Castlevania 64 saves (see "decodeFile()").
+ */
+int FileLoaderSrm::decodeFileContents(QByteArrayView fileData, const LoadContext& context, DecodedFile& decodedFile) const {
+    const int partToDecode = (context.srmPart != PART_NONE) ? context.srmPart : findDefaultPart(fileData);
+    const FileLoader* partLoader = getPartLoader(partToDecode);
+
+    if (partLoader == nullptr) {
+        return (context.srmPart == PART_NONE) ? -3 : -1;
     }
 
-    return 0;
+    decodedFile.srmPart = partToDecode;
+
+    return partLoader->decodeFileContents(fileData, context, decodedFile);
 }
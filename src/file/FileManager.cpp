@@ -8,122 +8,284 @@
  */
 
 #include "include/file/FileManager.h"
+#include "include/file/ControllerPakPacker.h"
 #include "include/save/SaveManager.h"
-#include "include/windows/ControllerPakSelection/ControllerPakSelectionwindow.h"
-#include <QMessageBox>
+#include "include/save/SlotCodec.h"
+#include <QDirIterator>
+#include <memory>     // std::unique_ptr
+#include <cstring>    // memcpy
+
+FileManager* FileManager::instance = nullptr;   /**< See "getInstance()" */
+
+namespace {
+    /**
+     * Bytes found at a fixed offset within the files of a given format.
+     * Optionally, "matches" performs extra checks on the header data (and the size of the file) once the bytes are found.
+     */
+    struct FormatSignature {
+        int format;
+        unsigned int offset;
+        QByteArrayView bytes;
+        bool (*matches)(QByteArrayView headerData, const qint64 fileSize);
+    };
+
+    /**
+     * @brief Cartridge saves are made up of whole save slots.
+     */
+    bool matchesCartridge(QByteArrayView /*headerData*/, const qint64 fileSize) {
+        return (fileSize % FormatDescriptors::CARTRIDGE.saveSlotPaddedSize) == 0;
+    }
 
-/**
- * @brief Given the loaded file format extension, it assigns the appropiate file-handling class.
- */
-int FileManager::determineFormat() {
-    if (!filepath.isEmpty()) {
+    /**
+     * @brief Checks the ID block at 0x20, which every formatted Controller Pak has (see ControllerPakImage.h).
+     */
+    bool matchesControllerPakIdBlock(QByteArrayView headerData, const qint64 fileSize) {
+        const unsigned int idBlockOffset = ControllerPakImage::ID_BLOCK_OFFSETS[0];
 
-        if (loader != nullptr) {
-            delete loader;
-            loader = nullptr;
+        if (fileSize != FormatDescriptors::CONTROLLER_PAK.maxFileSize || headerData.size() < idBlockOffset + ControllerPakImage::ID_BLOCK_SIZE) {
+            return false;
         }
 
-        QFileInfo fileInfo(filepath);
+        return ControllerPakImage::isIdBlockValid(headerData.sliced(idBlockOffset, ControllerPakImage::ID_BLOCK_SIZE));
+    }
 
-        QString fileExtension = fileInfo.suffix();
+    bool matchesSrm(QByteArrayView /*headerData*/, const qint64 fileSize) {
+        return fileSize == FormatDescriptors::SRM_FILE_SIZE;
+    }
 
-        if (fileExtension == "note") {
-            loader = new FileLoaderNote();
-            format = FORMAT_NOTE;
-        }
-        else if (fileExtension == "eep") {
-            loader = new FileLoaderCartridge();
-            format = FORMAT_CARTRIDGE;
-        }
-        else if (fileExtension == "mpk" || fileExtension == "pak") {
-            loader = new FileLoaderControllerPak();
-            format = FORMAT_CONTROLLERPAK;
-        }
-        else if (fileExtension == "n64" || fileExtension == "t64") {
-            loader = new FileLoaderDexDrive();
-            format = FORMAT_DEXDRIVE;
+    /**
+     * Signatures of every supported format, checked in order.
+     */
+    const FormatSignature FORMAT_SIGNATURES[] = {
+        // .srm files don't have a header, so only their size can be checked.
+        // They go first, since their EEPROM can start with the cartridge header.
+        {FileManager::FORMAT_SRM, 0, QByteArrayView(), matchesSrm},
+        // .note files start with the MPKNote magic (the region-specific part of the header is checked later by the loader)
+        {FileManager::FORMAT_NOTE, 0, QByteArrayView("\x01MPKNote", 8), nullptr},
+        {FileManager::FORMAT_CARTRIDGE, 0, FormatDescriptors::CARTRIDGE.getHeaderBytes(SaveData::JPN), matchesCartridge},
+        {FileManager::FORMAT_DEXDRIVE, 0, QByteArrayView("123-456-STD", 11), nullptr},
+        {FileManager::FORMAT_CONTROLLERPAK, 0, QByteArrayView(), matchesControllerPakIdBlock}
+    };
+}
+
+/**
+ * @brief Detects the format of a file from its first bytes (at least "FORMAT_SIGNATURE_READ_SIZE" of them, when the file is that big) and its size.
+ *
+ * @return The detected format, or -1 if the data doesn't match any of the supported formats.
+ */
+int FileManager::detectFormat(QByteArrayView headerData, const qint64 fileSize) {
+    for (const FormatSignature& signature: FORMAT_SIGNATURES) {
+        if (signature.offset + signature.bytes.size() > headerData.size() ||
+            headerData.sliced(signature.offset, signature.bytes.size()) != signature.bytes) {
+            continue;
         }
-        else {
-            // Unsupported file
-            return -1;
+
+        if (signature.matches == nullptr || signature.matches(headerData, fileSize)) {
+            return signature.format;
         }
+    }
 
-        return 0;
+    return -1;
+}
+
+/**
+ * @brief Detects the format of a file with a single "FORMAT_SIGNATURE_READ_SIZE"-byte read, without opening it with any of the file-handling classes.
+ *
+ * @return The detected format, or -1 if the file couldn't be read or its contents don't match any of the supported formats.
+ */
+int FileManager::detectFileFormat(const QString& filepath_) {
+    QFile inputFile(filepath_);
+
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        return -1;
     }
 
+    char headerData[FORMAT_SIGNATURE_READ_SIZE];
+    const qint64 bytesRead = inputFile.read(headerData, FORMAT_SIGNATURE_READ_SIZE);
+
+    if (bytesRead <= 0) {
+        return -1;
+    }
+
+    return detectFormat(QByteArrayView(headerData, bytesRead), inputFile.size());
+}
+
+/**
+ * @return The format associated to the file's extension, or -1 if the extension isn't supported.
+ */
+int FileManager::getFormatFromExtension(const QString& filepath_) {
+    QFileInfo fileInfo(filepath_);
+
+    QString fileExtension = fileInfo.suffix();
+
+    if (fileExtension == "note") {
+        return FORMAT_NOTE;
+    }
+    else if (fileExtension == "eep") {
+        return FORMAT_CARTRIDGE;
+    }
+    else if (fileExtension == "mpk" || fileExtension == "pak") {
+        return FORMAT_CONTROLLERPAK;
+    }
+    else if (fileExtension == "n64" || fileExtension == "t64") {
+        return FORMAT_DEXDRIVE;
+    }
+    else if (fileExtension == "srm") {
+        return FORMAT_SRM;
+    }
+
+    // Unsupported file
     return -1;
 }
 
-int FileManager::openFile(const QString& filepath_) {
-    if (!filepath_.isEmpty()) {
-        setFilePath(filepath_);
+/**
+ * @brief Finds the format of the given file.
+ *
+ * If "detectFromContent" is true, the format is detected from the file's contents (see "detectFileFormat()"),
+ * so mis-named files are still handled correctly. The file's extension is used otherwise, or if the contents
+ * couldn't be identified (i.e. the file doesn't exist yet).
+ *
+ * @return -1 if the file format isn't supported.
+ */
+int FileManager::findFileFormat(const QString& filepath_, const bool detectFromContent) {
+    const int detectedFormat = detectFromContent ? detectFileFormat(filepath_) : -1;
 
-        if (determineFormat() == -1)  {
-            return -1;
-        }
+    if (detectedFormat == -1) {
+        return getFormatFromExtension(filepath_);
+    }
 
-        file = new QFile(filepath);
+    return detectedFormat;
+}
+
+/**
+ * @brief Finds the format of a file that was already read whole (i.e. by the FileIngestor), without reading it again.
+ * Same as "findFileFormat(filepath_, true)" otherwise.
+ *
+ * @return -1 if the file format isn't supported.
+ */
+int FileManager::findFileFormat(const QString& filepath_, QByteArrayView fileData) {
+    const int detectedFormat = detectFormat(fileData, fileData.size());
 
-        if (file->open(QIODevice::ReadOnly)) {
-            // First, write to the buffer
-            QDataStream inputStream(file);
+    if (detectedFormat == -1) {
+        return getFormatFromExtension(filepath_);
+    }
 
-            QByteArray fileData = file->readAll();
-            *buffer = file->readAll();
-            buffer->resize(fileData.size());
-            *buffer = fileData;
+    return detectedFormat;
+}
 
-            // Then, parse the contents of the file
-            if (loader != nullptr) {
-                if (loader->checkFileOpenErrors() != 0) {
-                    return -1;
-                }
+/**
+ * @brief Creates the file-handling class associated to the given format, handling what "context" says
+ * (the note, the .srm part and the region, see "FileLoader::setLoadContext()").
+ *
+ * @return nullptr if the file format isn't supported.
+ */
+FileLoader* FileManager::createLoader(const int format_, const FileLoader::LoadContext& context) {
+    FileLoader* fileLoader = nullptr;
 
-                // Initialize Controller Pak specific data
-                if (format == FORMAT_CONTROLLERPAK || format == FORMAT_DEXDRIVE) {
-                    unsigned int numCV64Saves = initNoteTableData(*file);
-
-                    // Stop opening the file if the Controller Pak doesn't have any Castlevania saves
-                    // previously stored on it
-                    if (numCV64Saves == 0) {
-                        buffer->clear();
-                        buffer->resize(0);
-                        file->close();
-
-                        QMessageBox::critical(nullptr, "Error", "This file doesn't have any active, valid saves.");
-                        return -1;
-                    }
-
-                    // Open the selection window with the gathered Castlevania 64 saves
-                    ControllerPakSelectionWindow* PakSaveSelectWindow = new ControllerPakSelectionWindow();
-                    int result = PakSaveSelectWindow->exec();
-
-                    // Return early if the user clicked on the X instead of on a button
-                    if (result == QDialog::Rejected) {
-                        buffer->clear();
-                        buffer->resize(0);
-                        file->close();
-                        return -2;
-                    }
-                }
+    switch (format_) {
+        case FORMAT_NOTE:
+            fileLoader = new FileLoaderNote(FormatDescriptors::NOTE);
+            break;
 
-                // Actually parse the contents from the file
-                loader->parseRegion(*file);
-                loader->readAllSaveSlots(*file);
+        case FORMAT_CARTRIDGE:
+            fileLoader = new FileLoaderCartridge(FormatDescriptors::CARTRIDGE);
+            break;
 
-                if (fileOpened == false) {
-                    fileOpened = true;
-                }
-            }
+        case FORMAT_CONTROLLERPAK:
+            fileLoader = new FileLoaderControllerPak(FormatDescriptors::CONTROLLER_PAK);
+            break;
+
+        case FORMAT_DEXDRIVE:
+            fileLoader = new FileLoaderDexDrive(FormatDescriptors::DEXDRIVE);
+            break;
+
+        case FORMAT_SRM:
+            fileLoader = new FileLoaderSrm(FormatDescriptors::SRM);
+            break;
+
+        default:
+            return nullptr;
+    }
+
+    fileLoader->setLoadContext(context);
+
+    return fileLoader;
+}
+
+/**
+ * @brief Creates the file-handling class for the given file (see "findFileFormat()"), and stores the file format in "format_".
+ *
+ * @return nullptr if the file format isn't supported.
+ */
+FileLoader* FileManager::createLoader(const QString& filepath_, int& format_, const bool detectFromContent, const FileLoader::LoadContext& context) {
+    const int detectedFormat = findFileFormat(filepath_, detectFromContent);
+    FileLoader* fileLoader = createLoader(detectedFormat, context);
+
+    if (fileLoader != nullptr) {
+        format_ = detectedFormat;
+    }
+
+    return fileLoader;
+}
+
+/**
+ * @brief What the loader of the opened file handles (see "FileLoader::setLoadContext()"):
+ * the selected note (if any), the selected .srm part, and the region.
+ */
+FileLoader::LoadContext FileManager::getLoadContext() const {
+    FileLoader::LoadContext context;
+
+    context.format = format;
+    context.srmPart = srmCurrentlySelectedPart;
+    context.region = SaveManager::getInstance()->getRegion();
+
+    // Only files with a note table have their Castlevania 64 notes indexed (see "indexNoteTableData()")
+    if (controllerPakCurrentlySelectedSaveIndex >= 0 && controllerPakCurrentlySelectedSaveIndex < static_cast<int>(noteTableArray.size()) &&
+        noteTableArray[controllerPakCurrentlySelectedSaveIndex].index != -1) {
+        const ControllerPakNotetableData& noteTableData = noteTableArray[controllerPakCurrentlySelectedSaveIndex];
+
+        context.noteIndex = noteTableData.index;
+        context.noteStartOffset = noteTableData.rawDataStartOffset;
+        context.region = noteTableData.region;
+        context.notePages = controllerPakImage.getNote(noteTableData.index).pages;
+    }
+
+    return context;
+}
+
+/**
+ * @brief Assigns the appropiate file-handling class for the current file (see "createLoader()").
+ */
+int FileManager::determineFormat(const bool detectFromContent) {
+    if (!filepath.isEmpty()) {
+
+        if (loader != nullptr) {
+            delete loader;
+            loader = nullptr;
         }
-        else {
+
+        loader = createLoader(filepath, format, detectFromContent);
+
+        if (loader == nullptr) {
             return -1;
         }
 
-        file->close();
+        return 0;
     }
 
-    return 0;
+    return -1;
+}
+
+/**
+ * @brief Releases the currently-opened file.
+ */
+void FileManager::closeFile() {
+    if (file != nullptr) {
+        file->close();
+
+        delete file;
+        file = nullptr;
+    }
 }
 
 int FileManager::writeFile(const QString& filepath_, bool isReplacingOldFile) {
@@ -132,12 +294,48 @@ int FileManager::writeFile(const QString& filepath_, bool isReplacingOldFile) {
     }
 
     if (!filepath_.isEmpty()) {
+        // Files that hold a whole Controller Pak (or several saves, like .srm files) can't be built from the saves alone,
+        // so they can only be written back to an existing file. This is checked before releasing the opened file,
+        // so refusing a "Save As..." keeps handling the file (and the note) that was opened.
+        if (isReplacingOldFile) {
+            const int newFormat = getFormatFromExtension(filepath_);
+
+            if (newFormat == FORMAT_CONTROLLERPAK || newFormat == FORMAT_DEXDRIVE || newFormat == FORMAT_SRM) {
+                return -1;
+            }
+        }
+
+        // Writing the saves back to the file they were loaded from only requires writing the slots that changed
+        const bool isWritingBackToOpenedFile = !isReplacingOldFile && fileOpened && filepath_ == filepath;
+
+        // Release the currently-opened file before writing to it
+        closeFile();
         setFilePath(filepath_);
 
-        if (determineFormat() == -1)  {
+        // When replacing a file (i.e. "Save As..."), the new contents take the format of the chosen extension.
+        // Otherwise, the existing file keeps the format detected from its contents.
+        if (determineFormat(!isReplacingOldFile) == -1)  {
             return -1;
         }
 
+        // Keep handling the note (or .srm part) that was selected when the file was opened
+        loader->setLoadContext(getLoadContext());
+
+        // Files with a note table get the selected note patched in place, following the pages it has in the file now
+        if (loader->getFormatDescriptor().hasNoteTable()) {
+            if (loader->getLoadContext().noteIndex < 0) {
+                return -1;
+            }
+
+            const int result = patchNote(filepath, loader->getLoadContext().noteIndex, isWritingBackToOpenedFile);
+
+            if (result == 0) {
+                SaveManager::getInstance()->markSaveSlotsClean();
+            }
+
+            return result;
+        }
+
         file = new QFile(filepath);
 
         if (file->open(QIODevice::ReadWrite)) {
@@ -146,17 +344,24 @@ int FileManager::writeFile(const QString& filepath_, bool isReplacingOldFile) {
                 // ensure that we clear the file before proceeding.
                 file->resize(0);
             }
-            else {
-                // Copy the contents of the file buffer containing the previously unsaved data.
-                // Then, overwrite with the new data.
-                file->write(*buffer);
-            }
 
+            /// @note When not replacing the file, the bytes outside of the save slots are already in the file,
+            /// so we only overwrite the save slots. If the file still holds the saves that were loaded from it
+            /// (with the same region), only the slots that changed are overwritten.
             if (loader != nullptr) {
-                loader->writeAllSaveSlots(*file);
+                const bool isWritten = (isWritingBackToOpenedFile && SaveManager::getInstance()->hasCleanSaveSlots() &&
+                                        loader->hasValidFileSize(file->size())) ? loader->writeDirtySaveSlots(*file) : loader->writeAllSaveSlots(*file);
+
+                if (!isWritten) {
+                    file->close();
+                    return -1;
+                }
+
+                SaveManager::getInstance()->markSaveSlotsClean();
             }
         }
         else {
+            closeFile();
             return -1;
         }
 
@@ -169,60 +374,466 @@ int FileManager::writeFile(const QString& filepath_, bool isReplacingOldFile) {
 }
 
 /**
- * @brief Initialize the FileManager's "noteTableArray", in order to know extra information regarding each Castlevania 64 save it has in Controller Pak-formatted files.
+ * @brief Decodes the saves of a file without opening it (see "FileLoader::decodeFile()").
+ *
+ * Only the file itself is read, and nothing global is modified, so several files can be decoded at once
+ * (i.e. in the background while the GUI keeps working, or one file per thread in batch tools).
+ * The result can then be loaded as the opened file with "openDecodedFile()".
+ *
+ * @return -1 if the file can't be read, or if it doesn't have any save to decode.
+ * -3 if it doesn't hold any Castlevania 64 save (see "FileLoader::decodeFile()"). 0 on success.
  */
-unsigned int FileManager::initNoteTableData(QFile& file) {
-    unsigned int numCV64Saves = 0;
+int FileManager::decodeFile(const QString& filepath_, const FileLoader::LoadContext& context, FileLoader::DecodedFile& decodedFile) {
+    FileLoader::LoadContext fileContext = context;
+
+    if (fileContext.format == -1) {
+        fileContext.format = findFileFormat(filepath_, true);
+    }
 
-    if (loader != nullptr && (format == FORMAT_CONTROLLERPAK || format == FORMAT_DEXDRIVE)) {
-        SaveManager* saveManager = SaveManager::getInstance();
-        QDataStream inputStream(&file);
-        std::vector<FileManager::ControllerPakNotetableData>* noteTableArray = FileManager::getInstance()->getControllerPakNotetableDataArray();
+    std::unique_ptr<FileLoader> fileLoader(createLoader(fileContext.format, fileContext));
+    QFile inputFile(filepath_);
 
-        // If opening another Controller Pak file, make sure to clear the index data array first
+    if (fileLoader == nullptr || !inputFile.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // The file is mapped rather than read whole, so only the pages that get decoded are actually read
+    // (i.e. the system area and a single note of a Controller Pak). Files that can't be mapped are read instead.
+    const qint64 fileSize = inputFile.size();
+    uchar* mappedData = (fileSize > 0) ? inputFile.map(0, fileSize) : nullptr;
+
+    if (mappedData == nullptr) {
+        return fileLoader->decodeFile(inputFile.readAll(), fileContext, decodedFile);
+    }
+
+    const int result = fileLoader->decodeFile(QByteArrayView(mappedData, fileSize), fileContext, decodedFile);
+    inputFile.unmap(mappedData);
+
+    return result;
+}
+
+/**
+ * @brief Chooses the note to open from a file decoded with "decodeFile()" (see "setNoteSelector()"), before loading it with "openDecodedFile()".
+ * The note selector is only run if the file has more than one Castlevania 64 note.
+ *
+ * @note Only files with a note table have a note to choose (see "FileLoader::DecodedFile").
+ * @return The index of the chosen note (the one in "decodedFile" if there's nothing to choose from), or -1 if none was chosen.
+ */
+int FileManager::selectDecodedNote(const FileLoader::DecodedFile& decodedFile) const {
+    FileLoader::LoadContext context;
+    context.srmPart = decodedFile.srmPart;
+
+    std::unique_ptr<FileLoader> fileLoader(createLoader(decodedFile.format, context));
+    std::vector<ControllerPakNotetableData> noteTableData(CONTROLLER_PAK_NOTE_TABLE_NUM_ENTRIES);
+
+    if (fileLoader == nullptr || !fileLoader->getFormatDescriptor().hasNoteTable() ||
+        indexNoteTableData(decodedFile.controllerPakImage, *fileLoader, noteTableData) <= 1) {
+        return decodedFile.noteIndex;
+    }
+
+    return selectNote(noteTableData);
+}
+
+/**
+ * @brief Loads the saves of a file decoded with "decodeFile()" as if the file had just been opened,
+ * so they can be edited and written back with "writeFile()".
+ *
+ * @note The file isn't accessed at all, and no note is chosen here: the note in "decodedFile" is used
+ * (see "selectDecodedNote()").
+ * @return -1 if the format of "decodedFile" isn't supported. 0 on success.
+ */
+int FileManager::openDecodedFile(const QString& filepath_, const FileLoader::DecodedFile& decodedFile) {
+    SaveManager* saveManager = SaveManager::getInstance();
+
+    closeFile();
+
+    // The part of .srm files is selected first, since the layout of the file depends on it
+    FileLoader::LoadContext context;
+    context.srmPart = decodedFile.srmPart;
+
+    FileLoader* decodedFileLoader = createLoader(decodedFile.format, context);
+
+    if (decodedFileLoader == nullptr) {
+        return -1;
+    }
+
+    delete loader;
+    loader = decodedFileLoader;
+    format = decodedFile.format;
+    srmCurrentlySelectedPart = decodedFile.srmPart;
+    setFilePath(filepath_);
+
+    if (loader->getFormatDescriptor().hasNoteTable()) {
+        controllerPakImage = decodedFile.controllerPakImage;
+        indexNoteTableData();
+        controllerPakCurrentlySelectedSaveIndex = decodedFile.noteIndex;
+    }
+    else {
         clearNoteTableData();
+    }
 
-        /**
-         * Find the note table data (by searching the game ID, like "ND3EA4").
-         * If found, it means a Castlevania 64 save is in the Controller Pak, so we can proceed to initialize the note table data.
-         */
-        for (int i = 0; i < loader->getNoteTableNumEntries(); i++) {
-            const unsigned int GAMEID_SIZE = 6;
-            QByteArray gameId(GAMEID_SIZE, '\0');
+    saveManager->setRegion(decodedFile.region);
+    loader->setLoadContext(getLoadContext());
+    loader->selectSlotCodec(decodedFile.region);
 
-            inputStream.device()->seek(loader->getNoteTableOffset() + (loader->getNoteTableEntrySize() * i));   // This is where the current entry data starts
-            unsigned int bytesRead = inputStream.readRawData(gameId.data(), GAMEID_SIZE);
-            inputStream.device()->seek(loader->getNoteTableOffset() + (loader->getNoteTableEntrySize() * i));   // Go back to where we were previously to reading gameId
+    for (int i = 0; i < NUM_SAVES; i++) {
+        saveManager->setSaveSlot(decodedFile.saveSlots[i], i);
+        saveManager->setSaveSlotStatus(i, decodedFile.saveSlotStatus[i]);
+    }
 
-            if (bytesRead != GAMEID_SIZE) {
-                return 0;
-            }
+    saveManager->markSaveSlotsClean();
 
-            // If the game save stored doesn't belong to any of the Castlevania 64 versions, skip to the next save
-            if (gameId != "ND3EA4" && gameId != "ND3PA4" && gameId != "ND3JA4") {
-                continue;
-            }
+    fileOpened = true;
 
-            // Get the save index within the Controller Pak data
-            (*noteTableArray)[i].index = i;
+    return 0;
+}
 
-            // Parse the region (at offset +3)
-            unsigned char regionFromFile = loader->readData<unsigned char>(inputStream, inputStream.device()->pos() + 3);
-            (*noteTableArray)[i].region = loader->getRegionEnumFromChar(regionFromFile);
+/**
+ * @brief Writes the loaded saves into a single note of an existing Controller Pak-formatted file, in place.
+ *
+ * Only the system area and the pages of that note are accessed: the file system is read again from the file itself
+ * (so it doesn't need to be the file that was opened), and the note is written with one positioned write for each run
+ * of consecutive pages. Every other byte of the file is left untouched.
+ * If "onlyChangedSlots" is set, only the save slots that changed since they were loaded are written
+ * (see "FileLoader::writeDirtySaveSlots()"), which is what "Save" does for the note that was opened.
+ *
+ * @note For .srm files, the note is written into the Controller Pak that was opened last.
+ * @return -1 if the file can't be accessed, or if the note isn't a Castlevania 64 note of the loaded saves' region.
+ * -2 if all of the saves are disabled. 0 on success.
+ */
+int FileManager::patchNote(const QString& filepath_, const unsigned int noteIndex, const bool onlyChangedSlots) {
+    SaveManager* saveManager = SaveManager::getInstance();
 
-            // Parse the raw data start offset (at offset +3 after the region, and then multiplied by 0x100)
-            // If this is 0, we skip over this save entry (acting as if it wasn't present), and go to the next one
-            unsigned int rawDataStartOffsetByte = loader->readData<unsigned char>(inputStream, inputStream.device()->pos() + 3);
-            if (rawDataStartOffsetByte == 0) {
-                (*noteTableArray)[i].clearEntry();
-                numCV64Saves--;
-                continue;
-            }
-            (*noteTableArray)[i].rawDataStartOffset = loader->getRawDataOffsetPerEntry(rawDataStartOffsetByte);
+    if (saveManager->areAllSavesDisabled()) {
+        return -2;
+    }
+
+    // For .srm files, the note is written into the Controller Pak that was opened last
+    FileLoader::LoadContext context;
+    context.srmPart = srmCurrentlySelectedPart;
+
+    int fileFormat = FORMAT_NOTE;
+    std::unique_ptr<FileLoader> fileLoader(createLoader(filepath_, fileFormat, true, context));
+    QFile patchedFile(filepath_);
+
+    if (fileLoader == nullptr || !fileLoader->getFormatDescriptor().hasNoteTable() ||
+        noteIndex >= ControllerPakImage::NOTE_TABLE_NUM_ENTRIES || !patchedFile.open(QIODevice::ReadWrite)) {
+        return -1;
+    }
+
+    // Read the system area with a single call
+    QByteArray systemArea(ControllerPakImage::SYSTEM_AREA_SIZE, '\0');
+    ControllerPakImage pakImage;
+
+    patchedFile.seek(fileLoader->getFormatDescriptor().pakDataOffset);
+
+    if (patchedFile.read(systemArea.data(), systemArea.size()) != systemArea.size() || pakImage.parse(systemArea) != 0) {
+        return -1;
+    }
 
-            numCV64Saves++;
+    const ControllerPakImage::NoteEntry& note = pakImage.getNote(noteIndex);
+
+    if (!note.isUsed() || !ControllerPakImage::isCastlevaniaGameId(note.gameId) ||
+        fileLoader->getRegionEnumFromChar(note.gameId[3]) != saveManager->getRegion()) {
+        return -1;
+    }
+
+    // Follow the pages that the note has in the file right now
+    FileLoader::LoadContext noteContext = fileLoader->getLoadContext();
+    noteContext.noteIndex = noteIndex;
+    noteContext.noteStartOffset = fileLoader->getFormatDescriptor().pakDataOffset + (note.startPage * ControllerPakImage::PAGE_SIZE);
+    noteContext.region = saveManager->getRegion();
+    noteContext.notePages = note.pages;
+    fileLoader->setLoadContext(noteContext);
+
+    const bool isWritten = (onlyChangedSlots && saveManager->hasCleanSaveSlots()) ?
+                           fileLoader->writeDirtySaveSlots(patchedFile) : fileLoader->writeAllSaveSlots(patchedFile);
+
+    return isWritten ? 0 : -1;
+}
+
+/**
+ * @brief Packs a library of .note files into as few Controller Paks as possible, in a single pass.
+ *
+ * Each note is read once and added to the pak being built, in the next free pages (so no note gets fragmented).
+ * As soon as a note doesn't fit (either because of its pages or because the note table is full), the pak is written
+ * and a new one is started. Only one pak is kept in memory at a time.
+ * Paks are named after "outputBasePath" followed by their number, i.e. "Library_1.mpk", "Library_2.mpk", etc.
+ *
+ * @note Notes are packed in the given order. Since every Castlevania 64 note is the same size, this is already the fewest paks possible for them.
+ * @param format_ Either "FORMAT_CONTROLLERPAK" or "FORMAT_DEXDRIVE".
+ * @return -1 if "format_" isn't a Controller Pak format, or if a pak couldn't be written. Otherwise, the number of paks written
+ * (see "report" for the details).
+ */
+int FileManager::packNotes(const QStringList& notePaths, const QString& outputBasePath, const int format_, NotePackReport& report) {
+    if (format_ != FORMAT_CONTROLLERPAK && format_ != FORMAT_DEXDRIVE) {
+        return -1;
+    }
+
+    const QString extension = (format_ == FORMAT_DEXDRIVE) ? ".n64" : ".mpk";
+    const QByteArrayView noteMagic("\x01MPKNote", 8);
+    ControllerPakPacker packer;
+
+    // Writes the pak being built, if it has any notes
+    auto flushPak = [&]() -> bool {
+        if (packer.getNumNotes() == 0) {
+            return true;
+        }
+
+        const QString outputPath = outputBasePath + "_" + QString::number(report.outputFiles.size() + 1) + extension;
+
+        if (!writeControllerPak(outputPath, format_, packer.finish())) {
+            return false;
+        }
+
+        report.outputFiles.append(outputPath);
+        packer.reset();
+        return true;
+    };
+
+    for (const QString& notePath: notePaths) {
+        QFile noteFile(notePath);
+        QByteArray noteFileData;
+
+        if (noteFile.open(QIODevice::ReadOnly)) {
+            noteFileData = noteFile.readAll();
+        }
+
+        const QByteArrayView noteFileView(noteFileData);
+        const unsigned int numPages = ControllerPakPacker::getNumPages(qMax<qsizetype>(0, noteFileView.size() - ControllerPakPacker::NOTE_FILE_DATA_OFFSET));
+
+        if (!noteFileView.startsWith(noteMagic) || numPages == 0 || numPages > ControllerPakPacker::MAX_NOTE_PAGES) {
+            report.numSkippedFiles++;
+            report.skippedFiles.append(notePath);
+            continue;
+        }
+
+        if (!packer.canFit(numPages) && !flushPak()) {
+            return -1;
+        }
+
+        packer.addNote(noteFileView.sliced(ControllerPakPacker::NOTE_FILE_ENTRY_OFFSET, ControllerPakImage::NOTE_TABLE_ENTRY_SIZE),
+                       noteFileView.sliced(ControllerPakPacker::NOTE_FILE_DATA_OFFSET));
+        report.numNotes++;
+    }
+
+    if (!flushPak()) {
+        return -1;
+    }
+
+    return report.outputFiles.size();
+}
+
+/**
+ * @brief Writes a whole Controller Pak into a new file of the given format.
+ * DexDrive files get a blank header (only the "123-456-STD" banner, without any comments) before the Controller Pak data.
+ */
+bool FileManager::writeControllerPak(const QString& filepath_, const int format_, QByteArrayView pakData) {
+    QFile outputFile(filepath_);
+
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    if (format_ == FORMAT_DEXDRIVE) {
+        QByteArray dexDriveHeader(FormatDescriptors::DEXDRIVE.pakDataOffset, '\0');
+        memcpy(dexDriveHeader.data(), "123-456-STD", 11);
+
+        if (outputFile.write(dexDriveHeader) != dexDriveHeader.size()) {
+            return false;
         }
     }
 
+    return outputFile.write(pakData) == pakData.size();
+}
+
+/**
+ * @brief Fills the note table data array from the already-parsed "controllerPakImage".
+ *
+ * @return The number of Castlevania 64 notes.
+ */
+unsigned int FileManager::indexNoteTableData() {
+    return indexNoteTableData(controllerPakImage, *loader, noteTableArray);
+}
+
+/**
+ * @brief Fills "noteTableData" from the given Controller Pak file system, as found in a file handled by "fileLoader".
+ *
+ * @return The number of Castlevania 64 notes.
+ */
+unsigned int FileManager::indexNoteTableData(const ControllerPakImage& pakImage, const FileLoader& fileLoader,
+                                             std::vector<ControllerPakNotetableData>& noteTableData) {
+    const unsigned int pakDataOffset = fileLoader.getFormatDescriptor().pakDataOffset;
+    unsigned int numCV64Saves = 0;
+
+    for (ControllerPakNotetableData& entry: noteTableData) {
+        entry.clearEntry();
+    }
+
+    /**
+     * Find the notes that belong to Castlevania 64 (by their game ID, like "ND3EA4").
+     * Notes that don't point to a valid page are skipped (acting as if they weren't present).
+     */
+    for (unsigned int i = 0; i < ControllerPakImage::NOTE_TABLE_NUM_ENTRIES; i++) {
+        const ControllerPakImage::NoteEntry& note = pakImage.getNote(i);
+
+        if (!note.isUsed() || !ControllerPakImage::isCastlevaniaGameId(note.gameId)) {
+            continue;
+        }
+
+        // The region is the 4th character of the game ID
+        noteTableData[i].index = i;
+        noteTableData[i].region = fileLoader.getRegionEnumFromChar(note.gameId[3]);
+        noteTableData[i].rawDataStartOffset = pakDataOffset + (note.startPage * ControllerPakImage::PAGE_SIZE);
+
+        numCV64Saves++;
+    }
+
     return numCV64Saves;
 }
+
+/**
+ * @brief Chooses the note to open from the given note table data array (see "setNoteSelector()").
+ *
+ * @return The index of the chosen note, or -1 if none was chosen.
+ */
+int FileManager::selectNote(const std::vector<ControllerPakNotetableData>& noteTableData) const {
+    if (noteSelector) {
+        const int noteIndex = noteSelector(noteTableData);
+
+        // Only Castlevania 64 notes can be opened
+        if (noteIndex < 0 || noteIndex >= static_cast<int>(noteTableData.size()) || noteTableData[noteIndex].index == -1) {
+            return -1;
+        }
+
+        return noteIndex;
+    }
+
+    for (const ControllerPakNotetableData& entry: noteTableData) {
+        if (entry.index != -1) {
+            return entry.index;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Checks the checksums of every save slot in a file, or in every supported file inside a directory (recursively),
+ * and rewrites the ones that don't match their data.
+ *
+ * No save slot is decoded. Each file is mapped into memory, its checksums are calculated in batches straight from the raw data,
+ * and only the checksums that are wrong get written back. The currently-opened file and the loaded saves aren't modified.
+ *
+ * Inside directories, the format of each file is detected from its contents (see "detectFileFormat()"), so unlabelled dumps
+ * are checked too. Files that aren't recognized either by their contents or by their extension are ignored.
+ *
+ * Nothing in the FileManager is modified, so different paths can be checked from different threads at the same time.
+ *
+ * @param auditOnly If true, nothing is written, and the invalid slots are only reported.
+ * @return -1 if "path" doesn't exist. 0 otherwise (see "report" for the results).
+ */
+int FileManager::repairChecksums(const QString& path, const bool auditOnly, ChecksumRepairReport& report) {
+    QFileInfo pathInfo(path);
+
+    if (!pathInfo.exists()) {
+        return -1;
+    }
+
+    if (!pathInfo.isDir()) {
+        const int fileFormat = findFileFormat(pathInfo.filePath(), true);
+
+        repairFileChecksums(pathInfo.filePath(), fileFormat, auditOnly, report);
+        return 0;
+    }
+
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        const QString filepath_ = it.next();
+        const int fileFormat = findFileFormat(filepath_, true);
+
+        if (fileFormat != -1) {
+            repairFileChecksums(filepath_, fileFormat, auditOnly, report);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks (and, unless "auditOnly" is true, repairs) the checksums of every save slot in a single file of the given format.
+ * See "repairChecksums()".
+ */
+void FileManager::repairFileChecksums(const QString& filepath_, const int fileFormat, const bool auditOnly, ChecksumRepairReport& report) {
+    std::unique_ptr<FileLoader> fileLoader(createLoader(fileFormat));
+    QFile checkedFile(filepath_);
+
+    if (fileLoader == nullptr || !checkedFile.open(auditOnly ? QIODevice::ReadOnly : QIODevice::ReadWrite)) {
+        report.numSkippedFiles++;
+        return;
+    }
+
+    // Map the file if possible. Otherwise, fall back to reading it whole
+    const qint64 fileSize = checkedFile.size();
+    uchar* mappedFileData = (fileSize > 0) ? checkedFile.map(0, fileSize) : nullptr;
+    QByteArray fileBuffer;
+    QByteArrayView checkedFileData;
+
+    if (mappedFileData != nullptr) {
+        checkedFileData = QByteArrayView(mappedFileData, fileSize);
+    }
+    else {
+        fileBuffer = checkedFile.readAll();
+        checkedFileData = QByteArrayView(fileBuffer);
+    }
+
+    /**
+     * Gather the checksums that need to be rewritten first, and write them once the file isn't mapped anymore.
+     * Each entry holds the offset of the slot's checksums, along with the correct values.
+     */
+    std::vector<std::pair<unsigned int, SaveManager::SaveSlotChecksums>> repairs;
+    bool hasInvalidSlots = false;
+
+    for (const FileLoader::SaveSlotGroup& group: fileLoader->findSaveSlotGroups(checkedFileData)) {
+        SaveManager::SaveSlotStatus statuses[NUM_SAVES];
+        const unsigned int numSlots = fileLoader->verifySaveSlots(checkedFileData, group, statuses);
+        const unsigned int checksumsOffset = group.startOffset + (SlotCodecTable::get(group.region).saveDataSize * 2);
+
+        report.numSlots += numSlots;
+
+        for (unsigned int i = 0; i < numSlots; i++) {
+            if (statuses[i].mainSave == SaveManager::CHECKSUM_STATUS_INVALID) {
+                hasInvalidSlots = true;
+                report.numInvalidSlots++;
+                repairs.push_back({checksumsOffset + (fileLoader->getSaveSlotPaddedSize() * i), statuses[i].calculatedChecksums});
+            }
+        }
+    }
+
+    if (mappedFileData != nullptr) {
+        checkedFile.unmap(mappedFileData);
+    }
+
+    report.numFiles++;
+
+    if (hasInvalidSlots) {
+        report.invalidFiles.append(filepath_);
+    }
+
+    if (auditOnly) {
+        return;
+    }
+
+    for (const auto& [offset, checksums]: repairs) {
+        char checksumData[sizeof(checksums.checksum1) + sizeof(checksums.checksum2)];
+        fileLoader->writeData<unsigned int>(checksumData, 0, checksums.checksum1);
+        fileLoader->writeData<unsigned int>(checksumData, sizeof(checksums.checksum1), checksums.checksum2);
+
+        checkedFile.seek(offset);
+
+        if (checkedFile.write(checksumData, sizeof(checksumData)) == sizeof(checksumData)) {
+            report.numRepairedSlots++;
+        }
+    }
+}
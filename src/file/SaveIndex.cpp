@@ -0,0 +1,561 @@
+/**
+ * @file SaveIndex.cpp
+ * @brief SaveIndex source code file
+ *
+ * This source code file contains the code that builds, refreshes, maps and queries save indexes (see SaveIndex.h).
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/SaveIndex.h"
+#include "include/file/FileManager.h"
+#include "include/save/SaveDataSchema.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QtConcurrentMap>
+#include <cstddef>  // offsetof
+#include <cstring>  // memcmp, memcpy
+#include <memory>   // std::unique_ptr
+#include <numeric>  // std::iota
+
+struct SaveIndex::Header {
+    char magic[8];              /**< See "MAGIC" */
+    quint32 version;            /**< See "FORMAT_VERSION" */
+    quint32 byteOrderMark;      /**< "BYTE_ORDER_MARK", as written by the host that built the index */
+    quint32 schemaSignature;    /**< See "getSchemaSignature()" */
+    quint32 numFiles;
+    quint32 numRows;
+    quint32 reserved;
+    quint64 pathDataOffset;
+    quint64 pathDataSize;
+    quint64 columnsOffset;
+    quint64 fileSize;
+};
+
+static_assert(sizeof(SaveIndex::FileEntry) == 48, "The file table entries must have the same layout on every compiler");
+
+namespace {
+    constexpr char MAGIC[8] = {'P', 'P', 'P', 'I', 'N', 'D', 'E', 'X'};
+    constexpr quint32 FORMAT_VERSION = 1;
+    constexpr quint32 BYTE_ORDER_MARK = 0x01020304;
+
+    /**
+     * A save data entry decoded from a file, waiting to be written to the index.
+     */
+    struct DecodedRow {
+        quint8 saveIndex;
+        quint8 slotIndex;
+        quint8 entry;
+        quint8 region;
+        SaveData saveData;
+    };
+
+    /**
+     * A file given to "SaveIndex::refresh()", along with what was found out about it.
+     */
+    struct PendingFile {
+        QString path;                       // Absolute path, which is what the index stores
+        SaveIndex::FileEntry entry = {};
+        int status = SaveIndex::FILE_UNREADABLE;
+        qint64 previousFile = -1;           // Index of the file in the previous index, if its rows are reused. -1 otherwise
+        std::vector<DecodedRow> rows;
+    };
+
+    constexpr quint64 alignOffset(const quint64 offset) {
+        return (offset + 7) & ~static_cast<quint64>(7);
+    }
+
+    /**
+     * @brief Index of the first column of a field, counting from the first field column (every element of an array has its own column).
+     */
+    constexpr unsigned int getFirstFieldColumn(const std::size_t fieldIndex) {
+        unsigned int column = 0;
+
+        for (std::size_t i = 0; i < fieldIndex; i++) {
+            column += SaveDataSchema::FIELDS[i].count;
+        }
+
+        return column;
+    }
+
+    /**
+     * @brief Hash of the name, size, count and signedness of every SaveData field (FNV-1a),
+     * so indexes built with another version of the struct aren't used.
+     */
+    quint32 getSchemaSignature() {
+        quint32 hash = 2166136261u;
+        const auto addByte = [&hash](const quint8 byte) {
+            hash = (hash ^ byte) * 16777619u;
+        };
+
+        for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+            for (const char* c = field.name; *c != '\0'; c++) {
+                addByte(static_cast<quint8>(*c));
+            }
+
+            addByte(static_cast<quint8>(field.size));
+            addByte(static_cast<quint8>(field.count));
+            addByte(field.isSigned ? 1 : 0);
+        }
+
+        return hash;
+    }
+
+    /**
+     * @brief 64-bit FNV-1a hash of a file's contents.
+     */
+    quint64 hashFileData(QByteArrayView fileData) {
+        quint64 hash = 14695981039346656037ull;
+
+        for (const char byte: fileData) {
+            hash = (hash ^ static_cast<quint8>(byte)) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    /**
+     * @brief Decodes every save data entry of a file into its rows (see "FileLoader::decodeSaves()").
+     * Entries that were never saved to are skipped.
+     */
+    void decodeFile(PendingFile& file, QByteArrayView fileData) {
+        file.entry.format = FileManager::findFileFormat(file.path, fileData);
+        std::unique_ptr<FileLoader> fileLoader(FileManager::createLoader(file.entry.format));
+
+        if (fileLoader == nullptr || !fileLoader->hasValidFileSize(fileData.size())) {
+            file.entry.format = -1;
+            file.status = SaveIndex::FILE_UNSUPPORTED;
+            return;
+        }
+
+        const std::vector<FileLoader::DecodedSave> decodedSaves = fileLoader->decodeSaves(fileData);
+
+        for (unsigned int saveIndex = 0; saveIndex < decodedSaves.size(); saveIndex++) {
+            const FileLoader::DecodedSave& decodedSave = decodedSaves[saveIndex];
+
+            for (unsigned int i = 0; i < decodedSave.numSaveSlots; i++) {
+                const SaveData* entries[] = {&decodedSave.saveSlots[i].mainSave, &decodedSave.saveSlots[i].beginningOfStage};
+
+                for (unsigned int entry = SaveIndex::ENTRY_MAIN_SAVE; entry <= SaveIndex::ENTRY_BEGINNING_OF_STAGE; entry++) {
+                    if (BITS_HAS(entries[entry]->flags, SaveData::SAVE_FLAG_ACTIVE)) {
+                        DecodedRow row;
+                        row.saveIndex = static_cast<quint8>(saveIndex);
+                        row.slotIndex = static_cast<quint8>(i);
+                        row.entry = static_cast<quint8>(entry);
+                        row.region = static_cast<quint8>(decodedSave.region);
+                        row.saveData = *entries[entry];
+                        file.rows.push_back(row);
+                    }
+                }
+            }
+        }
+
+        file.status = SaveIndex::FILE_DECODED;
+    }
+}
+
+SaveIndex::~SaveIndex() {
+    close();
+}
+
+/**
+ * @brief Layout of every column of the index, in the order they're stored in.
+ */
+const std::vector<SaveIndex::ColumnLayout>& SaveIndex::getColumnLayouts() {
+    static const std::vector<ColumnLayout> columnLayouts = []() {
+        std::vector<ColumnLayout> layouts = {
+            {sizeof(quint32), 0},                                   // ROW_COLUMN_FILE
+            {sizeof(quint8), offsetof(DecodedRow, saveIndex)},      // ROW_COLUMN_SAVE
+            {sizeof(quint8), offsetof(DecodedRow, slotIndex)},      // ROW_COLUMN_SLOT
+            {sizeof(quint8), offsetof(DecodedRow, entry)},          // ROW_COLUMN_ENTRY
+            {sizeof(quint8), offsetof(DecodedRow, region)}          // ROW_COLUMN_REGION
+        };
+
+        for (const SaveDataSchema::Field& field: SaveDataSchema::FIELDS) {
+            for (unsigned int i = 0; i < field.count; i++) {
+                layouts.push_back({field.size, static_cast<unsigned int>(offsetof(DecodedRow, saveData)) + field.structOffset + (i * field.size)});
+            }
+        }
+
+        return layouts;
+    }();
+
+    return columnLayouts;
+}
+
+/**
+ * @brief Offset of every column of an index with the given number of rows, followed by the end of the last column (the size of the index).
+ */
+std::vector<quint64> SaveIndex::getColumnOffsets(const quint64 columnsOffset, const quint32 numRows) {
+    std::vector<quint64> offsets;
+    quint64 offset = columnsOffset;
+
+    for (const ColumnLayout& layout: getColumnLayouts()) {
+        offsets.push_back(offset);
+        offset = alignOffset(offset + (static_cast<quint64>(layout.valueSize) * numRows));
+    }
+
+    offsets.push_back(offset);
+    return offsets;
+}
+
+/**
+ * @brief Maps an index file.
+ *
+ * @return -1 if the file couldn't be opened or mapped, -2 if it isn't an index or it was built
+ * for another version of the SaveData struct (or on a host with another byte order). 0 on success.
+ */
+int SaveIndex::open(const QString& indexPath) {
+    static_assert(sizeof(Header) == 64, "The header must have the same layout on every compiler");
+
+    close();
+    indexFile.setFileName(indexPath);
+
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    const qint64 fileSize = indexFile.size();
+
+    if (fileSize < static_cast<qint64>(sizeof(Header))) {
+        close();
+        return -2;
+    }
+
+    indexData = indexFile.map(0, fileSize);
+
+    if (indexData == nullptr) {
+        close();
+        return -1;
+    }
+
+    const Header* fileHeader = reinterpret_cast<const Header*>(indexData);
+
+    if (memcmp(fileHeader->magic, MAGIC, sizeof(MAGIC)) != 0 || fileHeader->version != FORMAT_VERSION ||
+        fileHeader->byteOrderMark != BYTE_ORDER_MARK || fileHeader->schemaSignature != getSchemaSignature() ||
+        fileHeader->fileSize != static_cast<quint64>(fileSize)) {
+        close();
+        return -2;
+    }
+
+    // Every section must fit in the file
+    const quint64 fileTableEnd = sizeof(Header) + (static_cast<quint64>(fileHeader->numFiles) * sizeof(FileEntry));
+    columnOffsets = getColumnOffsets(fileHeader->columnsOffset, fileHeader->numRows);
+
+    if (fileTableEnd > fileHeader->pathDataOffset || fileHeader->pathDataOffset + fileHeader->pathDataSize > fileHeader->columnsOffset ||
+        columnOffsets.back() != static_cast<quint64>(fileSize)) {
+        close();
+        return -2;
+    }
+
+    const FileEntry* fileTable = reinterpret_cast<const FileEntry*>(indexData + sizeof(Header));
+
+    for (quint32 i = 0; i < fileHeader->numFiles; i++) {
+        if (fileTable[i].pathOffset + fileTable[i].pathSize > fileHeader->pathDataSize ||
+            static_cast<quint64>(fileTable[i].firstRow) + fileTable[i].numRows > fileHeader->numRows) {
+            close();
+            return -2;
+        }
+    }
+
+    header = fileHeader;
+    files = fileTable;
+
+    return 0;
+}
+
+/**
+ * @brief Unmaps the index file, if there's one.
+ */
+void SaveIndex::close() {
+    if (indexData != nullptr) {
+        indexFile.unmap(const_cast<uchar*>(indexData));
+    }
+
+    indexFile.close();
+    indexData = nullptr;
+    header = nullptr;
+    files = nullptr;
+    columnOffsets.clear();
+}
+
+/**
+ * @brief Builds the index of the given files, reusing the rows of the files that didn't change since the index at "indexPath"
+ * was built (if there's one). Files that aren't given anymore are dropped. The new index replaces the previous one, and gets opened.
+ *
+ * Only the files whose size or modification time changed are read (see "FileIngestor::ingest()"), and out of those,
+ * only the ones whose contents changed (see "FileEntry::hash") are decoded.
+ *
+ * @return -1 if the index couldn't be written (the previous index is kept in that case). 0 on success.
+ */
+int SaveIndex::refresh(const QString& indexPath, const QStringList& filepaths, const FileIngestor::Options& options, RefreshStats& stats) {
+    std::vector<PendingFile> pendingFiles(filepaths.size());
+    std::vector<qsizetype> indices(filepaths.size());
+    QHash<QString, qint64> previousFiles;
+
+    // Without a previous index (or with one that can't be used), every file is decoded
+    open(indexPath);
+
+    for (quint32 i = 0; i < getNumFiles(); i++) {
+        previousFiles.insert(getFilePath(i), i);
+    }
+
+    // Compare the size and modification time of every file with the previous index. That's a system call per file,
+    // so it's spread over the thread pool
+    std::iota(indices.begin(), indices.end(), 0);
+
+    QtConcurrent::blockingMap(options.threadPool, indices, [&](const qsizetype index) {
+        const QFileInfo fileInfo(filepaths[index]);
+        PendingFile& file = pendingFiles[index];
+
+        file.path = fileInfo.absoluteFilePath();
+        file.entry.size = fileInfo.size();
+        file.entry.modificationTime = fileInfo.lastModified().toMSecsSinceEpoch();
+        file.previousFile = previousFiles.value(file.path, -1);
+
+        if (file.previousFile != -1 && getFile(file.previousFile).size == file.entry.size &&
+            getFile(file.previousFile).modificationTime == file.entry.modificationTime) {
+            file.status = FILE_REUSED;
+        }
+    });
+
+    // Read the rest, and decode the ones whose contents changed
+    QStringList changedFiles;
+    std::vector<qsizetype> changedFileIndices;
+
+    for (qsizetype i = 0; i < filepaths.size(); i++) {
+        if (pendingFiles[i].status != FILE_REUSED) {
+            changedFiles.append(filepaths[i]);
+            changedFileIndices.push_back(i);
+        }
+    }
+
+    FileIngestor::ingest(changedFiles, [&](const qsizetype index, QByteArrayView fileData) {
+        PendingFile& file = pendingFiles[changedFileIndices[index]];
+
+        if (fileData.isNull()) {
+            file.status = FILE_UNREADABLE;
+            return;
+        }
+
+        file.entry.size = fileData.size();
+        file.entry.hash = hashFileData(fileData);
+
+        // Only the modification time changed (i.e. the file was copied or touched)
+        if (file.previousFile != -1 && getFile(file.previousFile).size == file.entry.size && getFile(file.previousFile).hash == file.entry.hash) {
+            file.status = FILE_REUSED;
+            return;
+        }
+
+        file.previousFile = -1;
+        decodeFile(file, fileData);
+    }, options);
+
+    // Lay out the new index. Unreadable files are left out, and so are files given more than once
+    std::vector<FileEntry> newFiles;
+    std::vector<qsizetype> newFilePendingIndices;
+    QSet<QString> newFilePaths;
+    QByteArray pathData;
+    quint32 numRows = 0;
+
+    stats = RefreshStats();
+
+    for (qsizetype i = 0; i < filepaths.size(); i++) {
+        PendingFile& file = pendingFiles[i];
+
+        // Files that are still unsupported are reported again, even if they're not decoded again
+        if (file.status == FILE_REUSED && getFile(file.previousFile).format == -1) {
+            file.status = FILE_UNSUPPORTED;
+        }
+
+        stats.fileStatuses.push_back(file.status);
+
+        if (file.status != FILE_UNREADABLE && newFilePaths.contains(file.path)) {
+            continue;
+        }
+
+        switch (file.status) {
+            case FILE_REUSED:
+                stats.numReusedFiles++;
+                break;
+
+            case FILE_DECODED:
+                stats.numDecodedFiles++;
+                break;
+
+            case FILE_UNSUPPORTED:
+                stats.numUnsupportedFiles++;
+                break;
+
+            default:
+                stats.numUnreadableFiles++;
+                continue;
+        }
+
+        newFilePaths.insert(file.path);
+
+        FileEntry entry = file.entry;
+        const QByteArray path = file.path.toUtf8();
+
+        if (file.previousFile != -1) {
+            entry = getFile(file.previousFile);
+            entry.modificationTime = file.entry.modificationTime;
+        }
+        else {
+            entry.numRows = static_cast<quint32>(file.rows.size());
+        }
+
+        entry.pathOffset = pathData.size();
+        entry.pathSize = static_cast<quint32>(path.size());
+        entry.firstRow = numRows;
+        pathData.append(path);
+
+        numRows += entry.numRows;
+        newFiles.push_back(entry);
+        newFilePendingIndices.push_back(i);
+    }
+
+    Header newHeader = {};
+    memcpy(newHeader.magic, MAGIC, sizeof(MAGIC));
+    newHeader.version = FORMAT_VERSION;
+    newHeader.byteOrderMark = BYTE_ORDER_MARK;
+    newHeader.schemaSignature = getSchemaSignature();
+    newHeader.numFiles = static_cast<quint32>(newFiles.size());
+    newHeader.numRows = numRows;
+    newHeader.pathDataOffset = alignOffset(sizeof(Header) + (newFiles.size() * sizeof(FileEntry)));
+    newHeader.pathDataSize = pathData.size();
+    newHeader.columnsOffset = alignOffset(newHeader.pathDataOffset + newHeader.pathDataSize);
+
+    const std::vector<quint64> newColumnOffsets = getColumnOffsets(newHeader.columnsOffset, numRows);
+    newHeader.fileSize = newColumnOffsets.back();
+
+    // Write the new index next to the previous one, which is only replaced once the whole index is written
+    QSaveFile outputFile(indexPath);
+    quint64 outputSize = 0;
+    const auto write = [&outputFile, &outputSize](const char* data, const quint64 size, const quint64 alignedEnd) {
+        outputFile.write(data, size);
+        outputFile.write(QByteArray(alignedEnd - (outputSize + size), '\0'));
+        outputSize = alignedEnd;
+    };
+
+    if (!outputFile.open(QIODevice::WriteOnly)) {
+        return -1;
+    }
+
+    write(reinterpret_cast<const char*>(&newHeader), sizeof(newHeader), sizeof(newHeader));
+    write(reinterpret_cast<const char*>(newFiles.data()), newFiles.size() * sizeof(FileEntry), newHeader.pathDataOffset);
+    write(pathData.constData(), pathData.size(), newHeader.columnsOffset);
+
+    // Build each column whole before writing it. The rows of reused files are copied from the previous index in a single block
+    const std::vector<ColumnLayout>& columnLayouts = getColumnLayouts();
+    QByteArray columnData;
+
+    for (unsigned int column = 0; column < columnLayouts.size(); column++) {
+        const unsigned int valueSize = columnLayouts[column].valueSize;
+        columnData.resize(static_cast<qsizetype>(numRows) * valueSize);
+
+        for (quint32 newFile = 0; newFile < newFiles.size(); newFile++) {
+            const PendingFile& file = pendingFiles[newFilePendingIndices[newFile]];
+            char* fileColumnData = columnData.data() + (static_cast<qsizetype>(newFiles[newFile].firstRow) * valueSize);
+
+            if (column == ROW_COLUMN_FILE) {
+                for (quint32 i = 0; i < newFiles[newFile].numRows; i++) {
+                    memcpy(fileColumnData + (i * sizeof(newFile)), &newFile, sizeof(newFile));
+                }
+            }
+            else if (file.previousFile != -1) {
+                const FileEntry& previousEntry = getFile(file.previousFile);
+                memcpy(fileColumnData, getColumn(column) + (static_cast<qsizetype>(previousEntry.firstRow) * valueSize),
+                       static_cast<qsizetype>(previousEntry.numRows) * valueSize);
+            }
+            else {
+                for (std::size_t i = 0; i < file.rows.size(); i++) {
+                    memcpy(fileColumnData + (i * valueSize), reinterpret_cast<const char*>(&file.rows[i]) + columnLayouts[column].rowOffset, valueSize);
+                }
+            }
+        }
+
+        write(columnData.constData(), columnData.size(), newColumnOffsets[column + 1]);
+    }
+
+    // The previous index can't be mapped anymore once it's replaced
+    close();
+
+    if (!outputFile.commit()) {
+        open(indexPath);
+        return -1;
+    }
+
+    return (open(indexPath) == 0) ? 0 : -1;
+}
+
+quint32 SaveIndex::getNumFiles() const {
+    return isOpen() ? header->numFiles : 0;
+}
+
+quint32 SaveIndex::getNumRows() const {
+    return isOpen() ? header->numRows : 0;
+}
+
+const SaveIndex::FileEntry& SaveIndex::getFile(const quint32 fileIndex) const {
+    return files[fileIndex];
+}
+
+QString SaveIndex::getFilePath(const quint32 fileIndex) const {
+    const FileEntry& file = files[fileIndex];
+    return QString::fromUtf8(reinterpret_cast<const char*>(indexData + header->pathDataOffset + file.pathOffset), file.pathSize);
+}
+
+const char* SaveIndex::getColumn(const unsigned int column) const {
+    return reinterpret_cast<const char*>(indexData + columnOffsets[column]);
+}
+
+quint32 SaveIndex::getRowFile(const quint32 row) const {
+    quint32 fileIndex;
+    memcpy(&fileIndex, getColumn(ROW_COLUMN_FILE) + (row * sizeof(fileIndex)), sizeof(fileIndex));
+
+    return fileIndex;
+}
+
+unsigned int SaveIndex::getRowSave(const quint32 row) const {
+    return static_cast<quint8>(getColumn(ROW_COLUMN_SAVE)[row]);
+}
+
+unsigned int SaveIndex::getRowSlot(const quint32 row) const {
+    return static_cast<quint8>(getColumn(ROW_COLUMN_SLOT)[row]);
+}
+
+/**
+ * @return See "eEntry".
+ */
+int SaveIndex::getRowEntry(const quint32 row) const {
+    return static_cast<quint8>(getColumn(ROW_COLUMN_ENTRY)[row]);
+}
+
+short SaveIndex::getRowRegion(const quint32 row) const {
+    return static_cast<quint8>(getColumn(ROW_COLUMN_REGION)[row]);
+}
+
+/**
+ * @brief Values of element "elementIndex" of the field "fieldIndex" (see "SaveDataSchema::FIELDS") for every row.
+ * See "SaveQuery::ColumnGetter".
+ */
+const void* SaveIndex::getFieldColumn(const unsigned int fieldIndex, const unsigned int elementIndex) const {
+    return getColumn(NUM_ROW_COLUMNS + getFirstFieldColumn(fieldIndex) + elementIndex);
+}
+
+/**
+ * @brief Finds the rows that match the query, going only through the columns it uses. Empty if the index isn't open.
+ */
+SaveQuery::RowSet SaveIndex::find(const SaveQuery& query) const {
+    if (!isOpen()) {
+        return SaveQuery::RowSet();
+    }
+
+    return query.matchColumns([this](const unsigned int fieldIndex, const unsigned int elementIndex) {
+        return getFieldColumn(fieldIndex, elementIndex);
+    }, getNumRows());
+}
@@ -19,12 +19,8 @@
  * This program uses the Singleton pattern to handle different kind of tasks
  * from any part of the program.
  *
- * Since these are static, these will live for the entire lifetime of the application.
+ * The instances are defined in libppp-core, and they live for the entire lifetime of the application.
  */
-SaveManager* SaveManager::instance = nullptr;
-FileManager* FileManager::instance = nullptr;
-DatabaseManager* DatabaseManager::instance = nullptr;
-
 void createSingletons() {
     SaveManager::createInstance();
     FileManager::createInstance();
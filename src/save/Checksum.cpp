@@ -0,0 +1,147 @@
+/**
+ * @file Checksum.cpp
+ * @brief Checksum source code file
+ *
+ * This source code file contains the save checksum kernels, and the code that picks the fastest one
+ * the CPU supports the first time they're used.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/Checksum.h"
+#include <cstring>  // memcpy
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKSUM_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+    typedef Checksum::Result (*ChecksumKernel)(const char*, std::size_t);
+
+    /**
+     * @brief Portable kernel, starting at byte "start" (which must be a multiple of 4) with the given partial result.
+     */
+    Checksum::Result calculateScalar(const char* data, const std::size_t size, std::size_t start, Checksum::Result result) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        std::size_t i = start;
+
+        for (; i + 3 < size; i += 4) {
+            quint32 word;
+            memcpy(&word, data + i, sizeof(word));
+
+            result.wordXor ^= word;
+            result.byteSum += bytes[i] + bytes[i + 1] + bytes[i + 2] + bytes[i + 3];
+        }
+
+        for (; i < size; i++) {
+            result.byteSum += bytes[i];
+        }
+
+        return result;
+    }
+
+    Checksum::Result calculateScalar(const char* data, const std::size_t size) {
+        return calculateScalar(data, size, 0, Checksum::Result());
+    }
+
+#ifdef CHECKSUM_X86_KERNELS
+    /**
+     * "psadbw" against zero adds up 8 bytes into each 64-bit lane, so the lanes can't overflow for any realistic size.
+     * The byte sum is truncated to 32 bits at the end, which gives the same result as the wrapping scalar sum.
+     */
+    __attribute__((target("sse2")))
+    Checksum::Result calculateSSE2(const char* data, const std::size_t size) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = _mm_setzero_si128();
+        __m128i xorValue = _mm_setzero_si128();
+        std::size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(block, zero));
+            xorValue = _mm_xor_si128(xorValue, block);
+        }
+
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        xorValue = _mm_xor_si128(xorValue, _mm_unpackhi_epi64(xorValue, xorValue));
+        xorValue = _mm_xor_si128(xorValue, _mm_srli_epi64(xorValue, 32));
+
+        Checksum::Result result;
+        result.byteSum = static_cast<quint32>(_mm_cvtsi128_si32(sum));
+        result.wordXor = static_cast<quint32>(_mm_cvtsi128_si32(xorValue));
+
+        return calculateScalar(data, size, i, result);
+    }
+
+    __attribute__((target("avx2")))
+    Checksum::Result calculateAVX2(const char* data, const std::size_t size) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i sum = _mm256_setzero_si256();
+        __m256i xorValue = _mm256_setzero_si256();
+        std::size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(block, zero));
+            xorValue = _mm256_xor_si256(xorValue, block);
+        }
+
+        __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        __m128i xor128 = _mm_xor_si128(_mm256_castsi256_si128(xorValue), _mm256_extracti128_si256(xorValue, 1));
+
+        if (i + 16 <= size) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            sum128 = _mm_add_epi64(sum128, _mm_sad_epu8(block, _mm256_castsi256_si128(zero)));
+            xor128 = _mm_xor_si128(xor128, block);
+            i += 16;
+        }
+
+        sum128 = _mm_add_epi64(sum128, _mm_unpackhi_epi64(sum128, sum128));
+        xor128 = _mm_xor_si128(xor128, _mm_unpackhi_epi64(xor128, xor128));
+        xor128 = _mm_xor_si128(xor128, _mm_srli_epi64(xor128, 32));
+
+        Checksum::Result result;
+        result.byteSum = static_cast<quint32>(_mm_cvtsi128_si32(sum128));
+        result.wordXor = static_cast<quint32>(_mm_cvtsi128_si32(xor128));
+
+        return calculateScalar(data, size, i, result);
+    }
+#endif
+
+    /**
+     * Kernel chosen for the running CPU.
+     */
+    struct Kernels {
+        ChecksumKernel calculate = calculateScalar;
+        const char* name = "scalar";
+
+        Kernels() {
+#ifdef CHECKSUM_X86_KERNELS
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2")) {
+                calculate = calculateAVX2;
+                name = "avx2";
+            }
+            else if (__builtin_cpu_supports("sse2")) {
+                calculate = calculateSSE2;
+                name = "sse2";
+            }
+#endif
+        }
+    };
+
+    const Kernels& getKernels() {
+        static const Kernels kernels;
+        return kernels;
+    }
+}
+
+Checksum::Result Checksum::calculate(const char* data, const std::size_t size) {
+    return getKernels().calculate(data, size);
+}
+
+const char* Checksum::getKernelName() {
+    return getKernels().name;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file RegionConversion.cpp
+ * @brief RegionConversion source code file
+ *
+ * This source code file contains the code that converts saves between the different versions of the game.
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/RegionConversion.h"
+
+/**
+ * @brief Converts a save of "fromRegion" into a save of "toRegion", in place.
+ *
+ * Items are moved to their new IDs (see "ITEMS_MASKS"), and the PAL-only fields are cleared for the other regions.
+ * The new layout is applied when the save gets encoded with "toRegion" (see SaveDataSchema.h).
+ */
+void RegionConversion::convertSaveData(SaveData& saveData, const short fromRegion, const short toRegion) {
+    if (fromRegion == toRegion) {
+        return;
+    }
+
+    char* items = reinterpret_cast<char*>(saveData.items);
+    ByteSwap::shuffle(items, items, SIZE_ITEMS_ARRAY, ITEMS_MASKS[fromRegion][toRegion].data());
+
+    if (toRegion != SaveData::PAL) {
+        saveData.language = SaveData::ENGLISH;
+        saveData.padding5A_PAL = 0;
+    }
+}
+
+/**
+ * @brief Converts both saves of every slot. Meant for converting many saves at once (i.e. see "FileConverter::Job::outputRegion").
+ *
+ * @note The checksums aren't updated here, since they depend on the encoded data. They're recalculated when the slots get encoded.
+ */
+void RegionConversion::convertSaveSlots(SaveSlot* saveSlots, const std::size_t numSlots, const short fromRegion, const short toRegion) {
+    if (fromRegion == toRegion) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < numSlots; i++) {
+        convertSaveData(saveSlots[i].mainSave, fromRegion, toRegion);
+        convertSaveData(saveSlots[i].beginningOfStage, fromRegion, toRegion);
+    }
+}
@@ -8,6 +8,10 @@
  */
 
 #include "include/save/SaveManager.h"
+#include "include/save/Checksum.h"
+#include <cstring>  // memcmp
+
+SaveManager* SaveManager::instance = nullptr;   /**< See "getInstance()" */
 
 short SaveManager::getRegion() const {
     return region;
@@ -168,16 +172,7 @@ void SaveManager::unassignEventFlags(const int flagSet, const unsigned int flags
  * @note source: https://decomp.me/scratch/6UIVU
  */
 unsigned int SaveManager::calcFirstChecksum(const QByteArray& dataFromFile) {
-    unsigned int checksum = 0;
-
-    unsigned int numElements = dataFromFile.size();
-    const unsigned char* data = reinterpret_cast<const unsigned char*>(dataFromFile.constData());
-
-    for (int i = 0; i < numElements; i++) {
-        checksum += data[i];
-    }
-
-    return checksum;
+    return Checksum::calculate(dataFromFile.constData(), dataFromFile.size()).byteSum;
 }
 
 /**
@@ -186,16 +181,65 @@ unsigned int SaveManager::calcFirstChecksum(const QByteArray& dataFromFile) {
  * @note source: https://decomp.me/scratch/oi0s4
  */
 unsigned int SaveManager::calcSecondChecksum(const QByteArray& dataFromFile) {
-    unsigned int checksum = 0;
+    return Checksum::calculate(dataFromFile.constData(), dataFromFile.size()).wordXor;
+}
+
+/**
+ * @brief Calculates both checksums for "numSlots" save slots stored one after another in a buffer, in a single call.
+ *
+ * "rawData" points to the main save of the first slot, as stored in the file (big endian),
+ * and each following slot starts "stride" bytes after the previous one.
+ * The results are the same "calcFirstChecksum()" and "calcSecondChecksum()" give for the byte-swapped main saves,
+ * but the data doesn't need to be copied nor byte-swapped first:
+ * the byte sum doesn't depend on the byte order, and swapping every word before XORing them
+ * is the same as swapping the XOR of the original words.
+ */
+void SaveManager::calcChecksums(const char* rawData, const unsigned int saveDataSize, const unsigned int stride,
+                                const unsigned int numSlots, SaveSlotChecksums* checksums) {
+    for (unsigned int i = 0; i < numSlots; i++) {
+        const Checksum::Result result = Checksum::calculate(rawData + (static_cast<std::size_t>(stride) * i), saveDataSize);
 
-    unsigned int numElements = dataFromFile.size() / 4;
-    const unsigned int* data = reinterpret_cast<const unsigned int*>(dataFromFile.constData());
+        checksums[i].checksum1 = result.byteSum;
+        checksums[i].checksum2 = qFromBigEndian(result.wordXor);
+    }
+}
+
+/**
+ * @brief Checks if a save slot changed since the file was opened or written (see "markSaveSlotsClean()").
+ *
+ * Slots whose checksums didn't match their data (see "hasInvalidSaveSlots()") are dirty too, so their checksums get recalculated.
+ *
+ * @note Every slot is dirty if the saves didn't come from a file, or if the region was changed since then.
+ */
+bool SaveManager::isSaveSlotDirty(const int index) const {
+    if (cleanSavesRegion != region) {
+        return true;
+    }
 
-    for (int i = 0; i < numElements; i++) {
-        checksum ^= data[i];
+    if (saveSlotStatus[index].mainSave == CHECKSUM_STATUS_INVALID || saveSlotStatus[index].beginningOfStage == CHECKSUM_STATUS_INVALID) {
+        return true;
     }
 
-    return checksum;
+    return memcmp(&saves[index], &cleanSaves[index], sizeof(SaveSlot)) != 0;
+}
+
+/**
+ * @brief Checks if the saves came from a file with the current region, so only their dirty slots need to be written back to it.
+ * If the region was changed, the layout of every slot changed too.
+ */
+bool SaveManager::hasCleanSaveSlots() const {
+    return cleanSavesRegion != -1 && cleanSavesRegion == region;
+}
+
+/**
+ * @brief Marks every save slot as clean, once the saves have been written to a file (or loaded from one).
+ */
+void SaveManager::markSaveSlotsClean() {
+    for (int i = 0; i < NUM_SAVES; i++) {
+        cleanSaves[i] = saves[i];
+    }
+
+    cleanSavesRegion = region;
 }
 
 /**
@@ -204,7 +248,7 @@ unsigned int SaveManager::calcSecondChecksum(const QByteArray& dataFromFile) {
  */
 bool SaveManager::areAllSavesDisabled() {
     for (int i = 0; i < NUM_SAVES; i++) {
-        if (BITS_HAS(saves[i].mainSave.flags, SaveData::SAVE_FLAG_ACTIVE)) {
+        if (BITS_HAS(getSaveSlot(i).mainSave.flags, SaveData::SAVE_FLAG_ACTIVE)) {
             return false;
         }
     }
@@ -212,12 +256,29 @@ bool SaveManager::areAllSavesDisabled() {
     return true;
 }
 
+/**
+ * @brief Returns true if any slot loaded from a file has checksums that don't match its data.
+ */
+bool SaveManager::hasInvalidSaveSlots() const {
+    for (int i = 0; i < NUM_SAVES; i++) {
+        if (saveSlotStatus[i].mainSave == CHECKSUM_STATUS_INVALID || saveSlotStatus[i].beginningOfStage == CHECKSUM_STATUS_INVALID) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * @brief Assign default (i.e. new game) values to all save game fields.
  */
 void SaveManager::assignDefaultValues() {
+    // These saves don't come from a file, so every slot is dirty
+    cleanSavesRegion = -1;
+
     for (int i = 0; i < NUM_SAVES; i++) {
         saves[i].assignDefaultValues();
+        saveSlotStatus[i] = SaveSlotStatus();
     }
 }
 
@@ -225,7 +286,11 @@ void SaveManager::assignDefaultValues() {
  * @brief Clears all save game fields.
  */
 void SaveManager::clear() {
+    // These saves don't come from a file, so every slot is dirty
+    cleanSavesRegion = -1;
+
     for (int i = 0; i < NUM_SAVES; i++) {
         saves[i].clear();
+        saveSlotStatus[i] = SaveSlotStatus();
     }
 }
@@ -0,0 +1,617 @@
+/**
+ * @file SaveQuery.cpp
+ * @brief SaveQuery source code file
+ *
+ * This source code file contains the parser and the evaluation of save queries (see SaveQuery.h).
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/SaveQuery.h"
+#include "include/save/SaveDataSchema.h"
+#include <QByteArray>
+#include <cctype>   // std::isalnum, std::isdigit, std::isspace
+#include <cstring>  // strlen
+
+namespace {
+    /**
+     * Name of an enum value that can be compared against a field.
+     */
+    struct ValueSymbol {
+        const char* name;
+        qint64 value;
+    };
+
+    /**
+     * Name of a bit of the "flags" or "player_status" fields, which can be used on its own as a condition.
+     */
+    struct FlagSymbol {
+        const char* name;
+        const char* prefix;     // Optional part of the name
+        const char* fieldName;
+        qint64 mask;
+    };
+
+    constexpr ValueSymbol VALUE_SYMBOLS[] = {
+        // SaveData::MapID
+        {"MORI",              SaveData::MORI},
+        {"TOU",               SaveData::TOU},
+        {"TOUOKUJI",          SaveData::TOUOKUJI},
+        {"NAKANIWA",          SaveData::NAKANIWA},
+        {"BEKKAN_1F",         SaveData::BEKKAN_1F},
+        {"BEKKAN_2F",         SaveData::BEKKAN_2F},
+        {"MEIRO_TEIEN",       SaveData::MEIRO_TEIEN},
+        {"CHIKA_KODO",        SaveData::CHIKA_KODO},
+        {"CHIKA_SUIRO",       SaveData::CHIKA_SUIRO},
+        {"HONMARU_B1F",       SaveData::HONMARU_B1F},
+        {"HONMARU_1F",        SaveData::HONMARU_1F},
+        {"HONMARU_2F",        SaveData::HONMARU_2F},
+        {"HONMARU_3F_MINAMI", SaveData::HONMARU_3F_MINAMI},
+        {"HONMARU_4F_MINAMI", SaveData::HONMARU_4F_MINAMI},
+        {"HONMARU_3F_KITA",   SaveData::HONMARU_3F_KITA},
+        {"HONMARU_5F",        SaveData::HONMARU_5F},
+        {"SHOKEI_TOU",        SaveData::SHOKEI_TOU},
+        {"MAHOU_TOU",         SaveData::MAHOU_TOU},
+        {"KAGAKU_TOU",        SaveData::KAGAKU_TOU},
+        {"KETTOU_TOU",        SaveData::KETTOU_TOU},
+        {"TURO_TOKEITOU",     SaveData::TURO_TOKEITOU},
+        {"TENSHU",            SaveData::TENSHU},
+        {"ENDING_DUMMY",      SaveData::ENDING_DUMMY},
+        {"TOKEITOU_NAI",      SaveData::TOKEITOU_NAI},
+        {"DRACULA",           SaveData::DRACULA},
+        {"ROSE",              SaveData::ROSE},
+        {"BEKKAN_BOSS",       SaveData::BEKKAN_BOSS},
+        {"TOU_TURO",          SaveData::TOU_TURO},
+        {"ENDING",            SaveData::ENDING},
+        {"TEST_GRID",         SaveData::TEST_GRID},
+        {"MAP_NONE",          SaveData::MAP_NONE},
+
+        // SaveData::PlayerCharacterID
+        {"REINHARDT",         SaveData::REINHARDT},
+        {"CARRIE",            SaveData::CARRIE},
+
+        // SaveData::SubweaponID
+        {"SUBWEAPON_NONE",         SaveData::SUBWEAPON_NONE},
+        {"SUBWEAPON_KNIFE",        SaveData::SUBWEAPON_KNIFE},
+        {"SUBWEAPON_HOLY_WATER",   SaveData::SUBWEAPON_HOLY_WATER},
+        {"SUBWEAPON_CROSS",        SaveData::SUBWEAPON_CROSS},
+        {"SUBWEAPON_AXE",          SaveData::SUBWEAPON_AXE},
+        {"SUBWEAPON_WOODEN_STAKE", SaveData::SUBWEAPON_WOODEN_STAKE},
+        {"SUBWEAPON_ROSE",         SaveData::SUBWEAPON_ROSE},
+
+        // SaveData::eLanguage
+        {"ENGLISH",           SaveData::ENGLISH},
+        {"JAPANESE",          SaveData::JAPANESE},
+        {"GERMAN",            SaveData::GERMAN},
+        {"FRENCH",            SaveData::FRENCH}
+    };
+
+    constexpr FlagSymbol FLAG_SYMBOLS[] = {
+        // SaveData::SaveFlag
+        {"ACTIVE",                     "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_ACTIVE},
+        {"EASY",                       "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_EASY},
+        {"NORMAL",                     "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_NORMAL},
+        {"HARD",                       "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_HARD},
+        {"HARD_MODE_UNLOCKED",         "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_HARD_MODE_UNLOCKED},
+        {"HAVE_REINHARDT_ALT_COSTUME", "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_HAVE_REINHARDT_ALT_COSTUME},
+        {"HAVE_CARRIE_ALT_COSTUME",    "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_HAVE_CARRIE_ALT_COSTUME},
+        {"REINDHART_GOOD_ENDING",      "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_REINDHART_GOOD_ENDING},
+        {"CARRIE_GOOD_ENDING",         "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_CARRIE_GOOD_ENDING},
+        {"REINDHART_BAD_ENDING",       "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_REINDHART_BAD_ENDING},
+        {"CARRIE_BAD_ENDING",          "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_CARRIE_BAD_ENDING},
+        {"COSTUME_IS_BEING_USED",      "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_COSTUME_IS_BEING_USED},
+        {"CAN_EXPLODE_ON_JUMPING",     "SAVE_FLAG_", "flags", SaveData::SAVE_FLAG_CAN_EXPLODE_ON_JUMPING},
+
+        // SaveData::PlayerStatus
+        {"STO",                        "PLAYER_FLAG_", "player_status", SaveData::PLAYER_FLAG_STO},
+        {"VAMP",                       "PLAYER_FLAG_", "player_status", SaveData::PLAYER_FLAG_VAMP},
+        {"POISON",                     "PLAYER_FLAG_", "player_status", SaveData::PLAYER_FLAG_POISON}
+    };
+
+    bool isNamed(const QByteArray& word, const char* name) {
+        return word.compare(name, Qt::CaseInsensitive) == 0;
+    }
+
+    const ValueSymbol* findValueSymbol(const QByteArray& word) {
+        for (const ValueSymbol& symbol: VALUE_SYMBOLS) {
+            if (isNamed(word, symbol.name)) {
+                return &symbol;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const FlagSymbol* findFlagSymbol(const QByteArray& word) {
+        for (const FlagSymbol& symbol: FLAG_SYMBOLS) {
+            const qsizetype prefixSize = strlen(symbol.prefix);
+
+            if (isNamed(word, symbol.name) ||
+                (word.size() > prefixSize && isNamed(word.left(prefixSize), symbol.prefix) && isNamed(word.mid(prefixSize), symbol.name))) {
+                return &symbol;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @return The index of the field in "SaveDataSchema::FIELDS", or "NUM_FIELDS" if there's no such field.
+     */
+    unsigned int findField(const QByteArray& word) {
+        for (unsigned int i = 0; i < SaveDataSchema::NUM_FIELDS; i++) {
+            if (isNamed(word, SaveDataSchema::FIELDS[i].name)) {
+                return i;
+            }
+        }
+
+        return SaveDataSchema::NUM_FIELDS;
+    }
+
+    /**
+     * @brief Sets the bits of the rows whose value in "column" satisfies "predicate", 64 rows at a time.
+     */
+    template<typename T, typename Predicate>
+    void scanColumn(const T* column, const quint32 numRows, SaveQuery::RowSet& rows, Predicate predicate) {
+        for (quint32 word = 0; word < rows.size(); word++) {
+            const quint32 firstRow = word * 64;
+            const quint32 numWordRows = qMin<quint32>(64, numRows - firstRow);
+            quint64 bits = 0;
+
+            for (quint32 i = 0; i < numWordRows; i++) {
+                bits |= static_cast<quint64>(predicate(static_cast<qint64>(column[firstRow + i]))) << i;
+            }
+
+            rows[word] = bits;
+        }
+    }
+}
+
+/**
+ * Recursive descent parser of query expressions. Each "parse*()" function appends its nodes to the query,
+ * and returns the index of the node it parsed, or -1 on error (after setting "error").
+ *
+ * expression := and ("or" and)*
+ * and        := not ("and" not)*
+ * not        := "not" not | "(" expression ")" | condition
+ * condition  := flag name | field ["[" number "]"] ["&" value] [comparison value]
+ */
+class SaveQuery::Parser {
+    public:
+        Parser(const QByteArray& text_, std::vector<Node>& nodes_) : text(text_), nodes(nodes_) {}
+
+        int parse() {
+            const int root = parseOr();
+
+            if (root != -1 && peek() != '\0') {
+                return fail("Unexpected \"" + QString::fromLatin1(text.mid(position)) + "\"");
+            }
+
+            return root;
+        }
+
+        QString error;
+
+    private:
+        char peek() {
+            while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+                position++;
+            }
+
+            return (position < text.size()) ? text[position] : '\0';
+        }
+
+        /**
+         * @brief Consumes "token" if it's next. Word tokens (i.e. "and") only match whole words.
+         */
+        bool accept(const char* token) {
+            const qsizetype size = strlen(token);
+            peek();
+
+            if (position + size > text.size() || qstrnicmp(text.constData() + position, token, size) != 0) {
+                return false;
+            }
+
+            if (std::isalpha(static_cast<unsigned char>(token[0])) && position + size < text.size() && isWordCharacter(text[position + size])) {
+                return false;
+            }
+
+            position += size;
+            return true;
+        }
+
+        /**
+         * @brief Whether the next two characters are "first" and "second".
+         */
+        bool isNext(const char first, const char second) {
+            return peek() == first && position + 1 < text.size() && text[position + 1] == second;
+        }
+
+        static bool isWordCharacter(const char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        QByteArray parseWord() {
+            const qsizetype start = position;
+
+            while (position < text.size() && isWordCharacter(text[position])) {
+                position++;
+            }
+
+            return text.mid(start, position - start);
+        }
+
+        int fail(const QString& message) {
+            if (error.isEmpty()) {
+                error = message + " (at character " + QString::number(position + 1) + ")";
+            }
+
+            return -1;
+        }
+
+        int addNode(const Node& node) {
+            nodes.push_back(node);
+            return static_cast<int>(nodes.size()) - 1;
+        }
+
+        int addOperation(const int type, const int left, const int right = -1) {
+            Node node;
+            node.type = type;
+            node.left = left;
+            node.right = right;
+
+            return addNode(node);
+        }
+
+        int parseOr() {
+            int left = parseAnd();
+
+            while (left != -1 && (accept("||") || accept("or"))) {
+                const int right = parseAnd();
+                left = (right == -1) ? -1 : addOperation(NODE_OR, left, right);
+            }
+
+            return left;
+        }
+
+        int parseAnd() {
+            int left = parseNot();
+
+            while (left != -1 && (accept("&&") || accept("and"))) {
+                const int right = parseNot();
+                left = (right == -1) ? -1 : addOperation(NODE_AND, left, right);
+            }
+
+            return left;
+        }
+
+        int parseNot() {
+            if ((!isNext('!', '=') && accept("!")) || accept("not")) {
+                const int operand = parseNot();
+                return (operand == -1) ? -1 : addOperation(NODE_NOT, operand);
+            }
+
+            if (accept("(")) {
+                const int expression = parseOr();
+
+                if (expression != -1 && !accept(")")) {
+                    return fail("Missing \")\"");
+                }
+
+                return expression;
+            }
+
+            return parseCondition();
+        }
+
+        int parseCondition() {
+            if (!isWordCharacter(peek())) {
+                return fail((peek() == '\0') ? "Missing condition" : "Unexpected \"" + QString::fromLatin1(text.mid(position, 1)) + "\"");
+            }
+
+            const QByteArray name = parseWord();
+            Node node;
+            node.fieldIndex = findField(name);
+
+            if (node.fieldIndex == SaveDataSchema::NUM_FIELDS) {
+                const FlagSymbol* flag = findFlagSymbol(name);
+
+                if (flag == nullptr) {
+                    return fail("Unknown field or flag \"" + QString::fromLatin1(name) + "\"");
+                }
+
+                node.fieldIndex = findField(flag->fieldName);
+                node.mask = flag->mask;
+                return addNode(node);
+            }
+
+            const SaveDataSchema::Field& field = SaveDataSchema::FIELDS[node.fieldIndex];
+
+            if (accept("[")) {
+                qint64 index = 0;
+
+                if (!parseValue(index)) {
+                    return -1;
+                }
+
+                if (index < 0 || index >= field.count) {
+                    return fail("\"" + QString::fromLatin1(name) + "\" only has " + QString::number(field.count) + " elements");
+                }
+
+                if (!accept("]")) {
+                    return fail("Missing \"]\"");
+                }
+
+                node.elementIndex = static_cast<unsigned int>(index);
+            }
+            else if (field.count > 1) {
+                return fail("\"" + QString::fromLatin1(name) + "\" is an array, so an element must be given (i.e. \"" + QString::fromLatin1(name) + "[0]\")");
+            }
+
+            if (!isNext('&', '&') && accept("&") && !parseValue(node.mask)) {
+                return -1;
+            }
+
+            node.comparison = parseComparison();
+
+            if (node.comparison != COMPARISON_NOT_ZERO && !parseValue(node.value)) {
+                return -1;
+            }
+
+            return addNode(node);
+        }
+
+        int parseComparison() {
+            // Longer operators first, so "<=" isn't read as "<"
+            if (accept("==") || accept("=")) {
+                return COMPARISON_EQUAL;
+            }
+
+            if (accept("!=")) {
+                return COMPARISON_NOT_EQUAL;
+            }
+
+            if (accept("<=")) {
+                return COMPARISON_LESS_EQUAL;
+            }
+
+            if (accept(">=")) {
+                return COMPARISON_GREATER_EQUAL;
+            }
+
+            if (accept("<")) {
+                return COMPARISON_LESS;
+            }
+
+            if (accept(">")) {
+                return COMPARISON_GREATER;
+            }
+
+            return COMPARISON_NOT_ZERO;
+        }
+
+        /**
+         * @brief Parses a number (decimal, or hexadecimal with the "0x" prefix) or the name of an enum value.
+         */
+        bool parseValue(qint64& value) {
+            const bool isNegative = accept("-");
+
+            if (!isWordCharacter(peek())) {
+                fail("Missing value");
+                return false;
+            }
+
+            const QByteArray word = parseWord();
+
+            if (std::isdigit(static_cast<unsigned char>(word[0]))) {
+                bool isNumber = false;
+                value = word.toLongLong(&isNumber, 0);
+
+                if (!isNumber) {
+                    fail("Invalid number \"" + QString::fromLatin1(word) + "\"");
+                    return false;
+                }
+            }
+            else {
+                const ValueSymbol* symbol = findValueSymbol(word);
+
+                if (symbol == nullptr) {
+                    fail("Unknown value \"" + QString::fromLatin1(word) + "\"");
+                    return false;
+                }
+
+                value = symbol->value;
+            }
+
+            if (isNegative) {
+                value = -value;
+            }
+
+            return true;
+        }
+
+        const QByteArray& text;
+        std::vector<Node>& nodes;
+        qsizetype position = 0;
+};
+
+/**
+ * @brief Parses the given expression (see SaveQuery.h), replacing the current query.
+ *
+ * @return -1 if the expression isn't valid (see "getLastError()"). 0 on success.
+ */
+int SaveQuery::parse(const QString& expression) {
+    const QByteArray text = expression.toLatin1();
+    Parser parser(text, nodes);
+
+    nodes.clear();
+    lastError.clear();
+
+    if (parser.parse() == -1) {
+        nodes.clear();
+        lastError = parser.error;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Whether the given save matches the query. An empty query matches every save.
+ */
+bool SaveQuery::matches(const SaveData& saveData) const {
+    return nodes.empty() || evaluate(static_cast<int>(nodes.size()) - 1, saveData);
+}
+
+/**
+ * @brief Finds the rows of a column store (i.e. the SaveIndex) that match the query, scanning only the columns the query uses.
+ * An empty query matches every row.
+ */
+SaveQuery::RowSet SaveQuery::matchColumns(const ColumnGetter& getColumn, const quint32 numRows) const {
+    if (!nodes.empty()) {
+        return evaluateColumns(static_cast<int>(nodes.size()) - 1, getColumn, numRows);
+    }
+
+    RowSet rows((numRows + 63) / 64, ~static_cast<quint64>(0));
+
+    if ((numRows % 64) != 0) {
+        rows.back() = (static_cast<quint64>(1) << (numRows % 64)) - 1;
+    }
+
+    return rows;
+}
+
+SaveQuery::RowSet SaveQuery::evaluateColumns(const int nodeIndex, const ColumnGetter& getColumn, const quint32 numRows) const {
+    const Node& node = nodes[nodeIndex];
+    RowSet rows;
+
+    if (node.type == NODE_COMPARISON) {
+        const SaveDataSchema::Field& field = SaveDataSchema::FIELDS[node.fieldIndex];
+        const void* column = getColumn(node.fieldIndex, node.elementIndex);
+
+        // Scans the column with the type of the field
+        const auto scan = [&](const auto predicate) {
+            switch (field.size) {
+                case 1:
+                    field.isSigned ? scanColumn(static_cast<const qint8*>(column), numRows, rows, predicate) :
+                                     scanColumn(static_cast<const quint8*>(column), numRows, rows, predicate);
+                    break;
+
+                case 2:
+                    field.isSigned ? scanColumn(static_cast<const qint16*>(column), numRows, rows, predicate) :
+                                     scanColumn(static_cast<const quint16*>(column), numRows, rows, predicate);
+                    break;
+
+                default:
+                    field.isSigned ? scanColumn(static_cast<const qint32*>(column), numRows, rows, predicate) :
+                                     scanColumn(static_cast<const quint32*>(column), numRows, rows, predicate);
+                    break;
+            }
+        };
+
+        const qint64 mask = node.mask;
+        const qint64 value = node.value;
+        rows.resize((numRows + 63) / 64);
+
+        // One loop per comparison, so the comparison isn't chosen again for every row
+        switch (node.comparison) {
+            default:
+            case COMPARISON_NOT_ZERO:
+                scan([mask](const qint64 v) { return (v & mask) != 0; });
+                break;
+
+            case COMPARISON_EQUAL:
+                scan([mask, value](const qint64 v) { return (v & mask) == value; });
+                break;
+
+            case COMPARISON_NOT_EQUAL:
+                scan([mask, value](const qint64 v) { return (v & mask) != value; });
+                break;
+
+            case COMPARISON_LESS:
+                scan([mask, value](const qint64 v) { return (v & mask) < value; });
+                break;
+
+            case COMPARISON_LESS_EQUAL:
+                scan([mask, value](const qint64 v) { return (v & mask) <= value; });
+                break;
+
+            case COMPARISON_GREATER:
+                scan([mask, value](const qint64 v) { return (v & mask) > value; });
+                break;
+
+            case COMPARISON_GREATER_EQUAL:
+                scan([mask, value](const qint64 v) { return (v & mask) >= value; });
+                break;
+        }
+
+        return rows;
+    }
+
+    rows = evaluateColumns(node.left, getColumn, numRows);
+
+    if (node.type == NODE_NOT) {
+        for (quint64& word: rows) {
+            word = ~word;
+        }
+
+        // Rows past the end don't exist, so they can't match
+        if ((numRows % 64) != 0) {
+            rows.back() &= (static_cast<quint64>(1) << (numRows % 64)) - 1;
+        }
+
+        return rows;
+    }
+
+    const RowSet rightRows = evaluateColumns(node.right, getColumn, numRows);
+
+    for (std::size_t i = 0; i < rows.size(); i++) {
+        rows[i] = (node.type == NODE_AND) ? (rows[i] & rightRows[i]) : (rows[i] | rightRows[i]);
+    }
+
+    return rows;
+}
+
+bool SaveQuery::evaluate(const int nodeIndex, const SaveData& saveData) const {
+    const Node& node = nodes[nodeIndex];
+
+    switch (node.type) {
+        case NODE_AND:
+            return evaluate(node.left, saveData) && evaluate(node.right, saveData);
+
+        case NODE_OR:
+            return evaluate(node.left, saveData) || evaluate(node.right, saveData);
+
+        case NODE_NOT:
+            return !evaluate(node.left, saveData);
+
+        default:
+            break;
+    }
+
+    const qint64 fieldValue = SaveDataSchema::getFieldValue(saveData, SaveDataSchema::FIELDS[node.fieldIndex], node.elementIndex) & node.mask;
+
+    switch (node.comparison) {
+        default:
+        case COMPARISON_NOT_ZERO:
+            return fieldValue != 0;
+
+        case COMPARISON_EQUAL:
+            return fieldValue == node.value;
+
+        case COMPARISON_NOT_EQUAL:
+            return fieldValue != node.value;
+
+        case COMPARISON_LESS:
+            return fieldValue < node.value;
+
+        case COMPARISON_LESS_EQUAL:
+            return fieldValue <= node.value;
+
+        case COMPARISON_GREATER:
+            return fieldValue > node.value;
+
+        case COMPARISON_GREATER_EQUAL:
+            return fieldValue >= node.value;
+    }
+}
@@ -214,7 +214,7 @@ void DatabaseMainWindow::onConnectButtonPress() {
     }
     else {
         // Disconnect from the database on error
-        QMessageBox::critical(this, "", "Error while connecting to the database.");
+        QMessageBox::critical(this, "", "Error while connecting to the database.\n" + DatabaseManager::getInstance()->getLastError());
         DatabaseManager::getInstance()->getDatabase()->disconnectFromDatabase();
     }
 }
@@ -253,7 +253,20 @@ void DatabaseMainWindow::onUploadSaveButtonPress() {
             entries.push_back(SaveManager::getInstance()->getSaveSlot(i));
         }
 
-        DatabaseManager::getInstance()->createEntry(documentId, entries, rev);
+        // If the document ID already exists, prompt the replacement window. If yes is selected, proceed with the replacement
+        const int result = DatabaseManager::getInstance()->createEntry(documentId, entries, rev, [this](const QString&) {
+            return QMessageBox::question(this, "Confirm overwrite",
+                                         "This document ID already exists. Do you want to overwrite it?",
+                                         QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+        });
+
+        if (result == 0) {
+            QMessageBox::information(this, "Success", "The operation was successful!");
+        }
+        else if (result == -1) {
+            QMessageBox::critical(this, "Error", DatabaseManager::getInstance()->getLastError());
+        }
+
         createSaveList();
     }
 }
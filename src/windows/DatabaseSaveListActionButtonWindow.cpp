@@ -72,7 +72,12 @@ void DatabaseSaveListActionWindow::onDeleteButton() {
                                                               QMessageBox::Yes | QMessageBox::No);
 
     if (reply == QMessageBox::Yes) {
-        DatabaseManager::getInstance()->deleteEntry(documentId, rev);
+        if (DatabaseManager::getInstance()->deleteEntry(documentId, rev)) {
+            QMessageBox::information(this, "Success", "The operation was successful!");
+        }
+        else {
+            QMessageBox::critical(this, "Error", DatabaseManager::getInstance()->getLastError());
+        }
 
         // Tell the parent (the database main window), that we've successfully deleted a file,
         // so it can reload the database save list
@@ -12,17 +12,16 @@
 #include "include/file/FileManager.h"
 #include <QPushButton>
 
-ControllerPakSelectionWindow::ControllerPakSelectionWindow(QWidget *parent)
+/**
+ * @param noteTableData The note table data array of the file being opened (see "FileManager::setNoteSelector()").
+ */
+ControllerPakSelectionWindow::ControllerPakSelectionWindow(const std::vector<FileManager::ControllerPakNotetableData>& noteTableData, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::ControllerPakSelectionWindow)
 {
     ui->setupUi(this);
 
-    // Make sure to only set this window up if we're working with Controller Pak or DexDrive saves
-    if (((FileManager::getInstance()->getFileFormat() == FileManager::FORMAT_CONTROLLERPAK) || (FileManager::getInstance()->getFileFormat() == FileManager::FORMAT_DEXDRIVE))
-        && (FileManager::getInstance()->getLoader() != nullptr)) {
-        setupButtonBox();
-    }
+    setupButtonBox(noteTableData);
 }
 
 ControllerPakSelectionWindow::~ControllerPakSelectionWindow()
@@ -47,17 +46,15 @@ QString ControllerPakSelectionWindow::getRegionName(const short region) const {
 /**
  * @brief Setup the list containing each button corresponding to each save file.
  */
-void ControllerPakSelectionWindow::setupButtonBox() {
-    // Get the Controller Pak Castlevania 64 save array
-    std::vector<FileManager::ControllerPakNotetableData>* saveArray = FileManager::getInstance()->getControllerPakNotetableDataArray();
-
-    for (unsigned int i = 0; i < saveArray->size(); i++) {
-        int index = (*saveArray)[i].index;
+void ControllerPakSelectionWindow::setupButtonBox(const std::vector<FileManager::ControllerPakNotetableData>& noteTableData) {
+    // Only the Castlevania 64 saves have an index
+    for (unsigned int i = 0; i < noteTableData.size(); i++) {
+        int index = noteTableData[i].index;
         if (index == -1) {
             continue;
         }
 
-        short region = (*saveArray)[i].region;
+        short region = noteTableData[i].region;
 
         QString buttonText = "Save " + QString::number(index + 1) + "\n" +
                              getRegionName(region);
@@ -76,9 +73,9 @@ void ControllerPakSelectionWindow::setupButtonBox() {
  * @brief Runs when clicking one of the save list buttons.
  */
 void ControllerPakSelectionWindow::onButtonClicked(int saveIndex) {
-    // Set the save index needed for knowing what save file to load
-    // (see FileLoaderControllerPak::getRawDataOffsetStart())
-    FileManager::getInstance()->setControllerPakCurrentlySelectedSaveIndex(saveIndex);
+    // Keep the save index needed for knowing what save file to load.
+    // The FileManager picks it up once the window is closed (see "FileManager::setNoteSelector()")
+    selectedSaveIndex = saveIndex;
 
     // Make sure we return QDialog::Accepted upon exiting the window in order to tell FileManager that we can continue loading the file
     // (see closeEvent() for the opposite case, where X is pressed to exit the window instead)
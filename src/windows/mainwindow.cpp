@@ -10,7 +10,9 @@
 
 #include "include/windows/main/MainWindow.h"
 #include "include/windows/Database/DatabaseMainWindow.h"
+#include "include/windows/ControllerPakSelection/ControllerPakSelectionwindow.h"
 #include "include/save/SaveManager.h"
+#include "include/save/SaveDataSchema.h"
 #include "include/file/FileManager.h"
 
 #include <QIntValidator>    // With "QIntValidator", we can validate the contents of an integer (see "handleNumberOnlyInput()")
@@ -20,6 +22,10 @@
 #include <QDir>             // QDir
 #include <QFileDialog>      // QFileDialog
 #include <QSpinBox>         // QSpinBox
+#include <QPushButton>      // QPushButton
+#include <QFutureWatcher>   // QFutureWatcher
+#include <QtConcurrentRun>  // QtConcurrent::run()
+#include <string_view>      // std::string_view
 
 // Static instance for this window. We use this to access this window's functions in some parts of the code
 MainWindow* MainWindow::instance = nullptr;
@@ -45,6 +51,12 @@ MainWindow::MainWindow(QWidget *parent)
     setupSlotMenu();
     setupEditMenu();
 
+    // Let the user choose which save to open from Controller Pak-formatted files
+    FileManager::getInstance()->setNoteSelector([this](const std::vector<FileManager::ControllerPakNotetableData>& noteTableData) {
+        ControllerPakSelectionWindow selectionWindow(noteTableData, this);
+        return (selectionWindow.exec() == QDialog::Accepted) ? selectionWindow.getSelectedSaveIndex() : -1;
+    });
+
     // Set default values to the savegame at boot
     SaveManager::getInstance()->clear();
     SaveManager::getInstance()->setRegion(SaveData::USA);
@@ -619,40 +631,62 @@ void MainWindow::populateMainWindow(SaveData* saveData) {
         return;
     }
 
-    // Combo boxes
-    selectComboBoxOption(*ui->cbCharacter, saveData->character);
-    selectComboBoxOption(*ui->cbButtonConfig, saveData->button_config);
-    selectComboBoxOption(*ui->cbSoundMode, saveData->sound_mode);
-    selectComboBoxOption(*ui->cbSubweapon, saveData->subweapon);
-    selectComboBoxOption(*ui->cbMap, saveData->map);
+    const short region = SaveManager::getInstance()->getRegion();
+
+    // Combo boxes and line edits that directly show a single SaveData field.
+    // Fields that aren't present in the current region's saves (see SaveDataSchema.h) are skipped.
+    const std::pair<QComboBox*, std::string_view> fieldComboBoxes[] = {
+        {ui->cbCharacter, "character"},
+        {ui->cbButtonConfig, "button_config"},
+        {ui->cbSoundMode, "sound_mode"},
+        {ui->cbSubweapon, "subweapon"},
+        {ui->cbMap, "map"},
+        {ui->cbLanguage, "language"}
+    };
+
+    const std::pair<QLineEdit*, std::string_view> fieldLineEdits[] = {
+        {ui->leLife, "life"},
+        {ui->leGold, "gold"},
+        {ui->leSpawn, "spawn"},
+        {ui->leWhiteJewel, "save_crystal_number"},
+        {ui->leTimesSaved, "time_saved_counter"},
+        {ui->leDeathCount, "death_counter"},
+        {ui->leGoldRenon, "gold_spent_on_Renon"},
+        {ui->leHourVamp, "current_hour_VAMP"},
+        {ui->leHealthDepletionRate, "health_depletion_rate_while_poisoned"},
+        {ui->leWeek, "week"},
+        {ui->leDay, "day"},
+        {ui->leHour, "hour"},
+        {ui->leMinutes, "minute"},
+        {ui->leSeconds, "seconds"},
+        {ui->leMilliseconds, "milliseconds"},
+        {ui->leFrameCount, "gameplay_framecount"}
+    };
+
+    for (const auto& [comboBox, fieldName]: fieldComboBoxes) {
+        const SaveDataSchema::Field& field = SaveDataSchema::getField(fieldName);
+
+        if (field.isInRegion(region)) {
+            selectComboBoxOption(*comboBox, static_cast<int>(SaveDataSchema::getFieldValue(*saveData, field)));
+        }
+    }
+
+    for (const auto& [lineEdit, fieldName]: fieldLineEdits) {
+        const SaveDataSchema::Field& field = SaveDataSchema::getField(fieldName);
 
+        if (field.isInRegion(region)) {
+            lineEdit->setText(QString::number(SaveDataSchema::getFieldValue(*saveData, field)));
+        }
+    }
+
+    // Combo boxes
     selectComboBoxOption(*ui->cbDifficulty, saveData->getFlag(SaveData::SAVE_FLAG_EASY | SaveData::SAVE_FLAG_NORMAL | SaveData::SAVE_FLAG_HARD));
     selectComboBoxOption(*ui->cbReinhardtEnding, saveData->getFlag(SaveData::SAVE_FLAG_REINDHART_GOOD_ENDING | SaveData::SAVE_FLAG_REINDHART_BAD_ENDING));
     selectComboBoxOption(*ui->cbCarrieEnding, saveData->getFlag(SaveData::SAVE_FLAG_CARRIE_GOOD_ENDING | SaveData::SAVE_FLAG_CARRIE_BAD_ENDING));
-    selectComboBoxOption(*ui->cbRegion, SaveManager::getInstance()->getRegion());
-
-    if (SaveManager::getInstance()->getRegion() == SaveData::PAL) {
-        selectComboBoxOption(*ui->cbLanguage, saveData->language);
-    }
+    selectComboBoxOption(*ui->cbRegion, region);
 
     // Numerical Line edits
-    ui->leLife->setText(QString::number(saveData->life));
-    ui->leGold->setText(QString::number(saveData->gold));
     ui->leRedJewels->setText(QString::number(saveData->getItem(SaveData::ITEM_ID_RED_JEWEL)));
-    ui->leSpawn->setText(QString::number(saveData->spawn));
-    ui->leWhiteJewel->setText(QString::number(saveData->save_crystal_number));
-    ui->leTimesSaved->setText(QString::number(saveData->time_saved_counter));
-    ui->leDeathCount->setText(QString::number(saveData->death_counter));
-    ui->leGoldRenon->setText(QString::number(saveData->gold_spent_on_Renon));
-    ui->leHourVamp->setText(QString::number(saveData->current_hour_VAMP));
-    ui->leHealthDepletionRate->setText(QString::number(saveData->health_depletion_rate_while_poisoned));
-    ui->leWeek->setText(QString::number(saveData->week));
-    ui->leDay->setText(QString::number(saveData->day));
-    ui->leHour->setText(QString::number(saveData->hour));
-    ui->leMinutes->setText(QString::number(saveData->minute));
-    ui->leSeconds->setText(QString::number(saveData->seconds));
-    ui->leMilliseconds->setText(QString::number(saveData->milliseconds));
-    ui->leFrameCount->setText(QString::number(saveData->gameplay_framecount));
     convertFrameToTime(saveData->gameplay_framecount, ui->labelPlaytime);
 
     ui->leItemsSpecial1->setText(QString::number(saveData->getItem(SaveData::ITEM_ID_SPECIAL1)));
@@ -743,14 +777,79 @@ void MainWindow::setupCheckBox(QCheckBox* checkBox, unsigned int value, std::fun
     });
 }
 
+/**
+ * @brief Opens a file. It's decoded in the background, so the window keeps responding while the file is read.
+ */
 void MainWindow::openFile(const QString& filename) {
-    int result = FileManager::getInstance()->openFile(filename);
+    decodeFileInBackground(filename, FileLoader::LoadContext());
+}
+
+/**
+ * @brief Decodes a file on the global thread pool (see "FileManager::decodeFile()"), and loads it once it's done (see "onFileDecoded()").
+ * The window is disabled in the meantime, so no other file can be opened or saved.
+ */
+void MainWindow::decodeFileInBackground(const QString& filename, const FileLoader::LoadContext& context) {
+    QFutureWatcher<DecodedFileResult>* watcher = new QFutureWatcher<DecodedFileResult>(this);
+
+    connect(watcher, &QFutureWatcher<DecodedFileResult>::finished, this, [this, watcher, filename, context]() {
+        setEnabled(true);
+        onFileDecoded(filename, context, watcher->result());
+        watcher->deleteLater();
+    });
+
+    setEnabled(false);
+    watcher->setFuture(QtConcurrent::run([filename, context]() {
+        DecodedFileResult result;
+        result.status = FileManager::decodeFile(filename, context, result.decodedFile);
 
-    if (result == -1) {
+        return result;
+    }));
+}
+
+/**
+ * @brief Loads a file that was decoded in the background (see "decodeFileInBackground()") as the opened file.
+ *
+ * For files with a note table, the user gets to choose among its Castlevania 64 notes first.
+ * If a note other than the decoded one is chosen, that note is decoded instead.
+ */
+void MainWindow::onFileDecoded(const QString& filename, const FileLoader::LoadContext& context, const DecodedFileResult& result) {
+    if (result.status == -3) {
+        QMessageBox::critical(this, "Error", "This file doesn't have any active, valid saves.");
+        return;
+    }
+
+    if (result.status != 0) {
         QMessageBox::critical(this, "Error", "Couldn't open file.");
         return;
     }
 
+    if (context.noteIndex == -1 && result.decodedFile.noteIndex != -1) {
+        const int noteIndex = FileManager::getInstance()->selectDecodedNote(result.decodedFile);
+
+        // Stop opening the file if no note was chosen (i.e. the user closed the selection window)
+        if (noteIndex == -1) {
+            return;
+        }
+
+        if (noteIndex != result.decodedFile.noteIndex) {
+            FileLoader::LoadContext noteContext = context;
+            noteContext.format = result.decodedFile.format;
+            noteContext.srmPart = result.decodedFile.srmPart;
+            noteContext.noteIndex = noteIndex;
+
+            decodeFileInBackground(filename, noteContext);
+            return;
+        }
+    }
+
+    if (FileManager::getInstance()->openDecodedFile(filename, result.decodedFile) != 0) {
+        QMessageBox::critical(this, "Error", "Couldn't open file.");
+        return;
+    }
+
+    // Let the user know if any slot is corrupted. Its checksums will be recalculated when saving.
+    warnAboutInvalidChecksums();
+
     // Populate with the currently-selected save slot.
     populateMainWindow(&SaveManager::getInstance()->getCurrentSave());
 
@@ -770,11 +869,12 @@ void MainWindow::fileOpenMenu() {
     // Open file menu in the last opened directory by default
     QString filename = QFileDialog::getOpenFileName(
         this, "Open File", lastOpenedDir,
-        "All accepted filetypes (*.mpk *.pak *.note *.eep *.n64 *.t64);;"
+        "All accepted filetypes (*.mpk *.pak *.note *.eep *.n64 *.t64 *.srm);;"
         "Individual note (*.note);;"
         "Controller Pak data (*.mpk *.pak);;"
         "Cartridge (Japanese version only) (*.eep);;"
         "DexDrive saves (*.n64 *.t64);;"
+        "Mupen64Plus saves (*.srm);;"
         "All Files (*)"
     );
 
@@ -889,6 +989,9 @@ void MainWindow::setupFileMenu() {
 
     // Setup the "Database" button
     connect(ui->actionDatabase, &QAction::triggered, this, &MainWindow::databaseMenu);
+
+    // Setup the "Repair Checksums..." button
+    connect(ui->actionRepairChecksums, &QAction::triggered, this, &MainWindow::repairChecksumsMenu);
 }
 
 void MainWindow::setupSlotMenu() {
@@ -1238,6 +1341,75 @@ void MainWindow::databaseMenu() {
     databaseAccessWindow->close();
 }
 
+/**
+ * @brief Checks (and optionally repairs) the checksums of every save file inside a directory, without opening them in the editor.
+ */
+void MainWindow::repairChecksumsMenu() {
+    QSettings settings("PPP", "Castlevania 64 Save Editor");
+    QString lastOpenedDir = settings.value("lastOpenedDir", QDir::homePath()).toString();
+
+    QString dirPath = QFileDialog::getExistingDirectory(this, "Select a directory with save files", lastOpenedDir);
+
+    if (dirPath.isEmpty()) {
+        return;
+    }
+
+    QMessageBox modeBox(QMessageBox::Question, "Repair Checksums",
+                        "Do you want to rewrite the checksums that don't match their save data, or only check them?\n"
+                        "All supported save files inside the directory (and its subdirectories) will be processed.",
+                        QMessageBox::Cancel, this);
+    QPushButton* repairButton = modeBox.addButton("Repair", QMessageBox::AcceptRole);
+    QPushButton* auditButton = modeBox.addButton("Only check", QMessageBox::ActionRole);
+    modeBox.exec();
+
+    if (modeBox.clickedButton() != repairButton && modeBox.clickedButton() != auditButton) {
+        return;
+    }
+
+    const bool auditOnly = (modeBox.clickedButton() == auditButton);
+    FileManager::ChecksumRepairReport report;
+
+    if (FileManager::getInstance()->repairChecksums(dirPath, auditOnly, report) == -1) {
+        QMessageBox::critical(this, "Error", "The selected directory doesn't exist.");
+        return;
+    }
+
+    QString summary = QString("Files checked: %1\nFiles skipped: %2\nSave slots checked: %3\nSave slots with invalid checksums: %4")
+                          .arg(report.numFiles).arg(report.numSkippedFiles).arg(report.numSlots).arg(report.numInvalidSlots);
+
+    if (!auditOnly) {
+        summary += QString("\nSave slots repaired: %1").arg(report.numRepairedSlots);
+    }
+
+    if (!report.invalidFiles.isEmpty()) {
+        summary += "\n\nFiles with invalid checksums:\n" + report.invalidFiles.join("\n");
+    }
+
+    QMessageBox::information(this, "Repair Checksums", summary);
+}
+
+/**
+ * @brief Shows a warning listing the slots of the opened file whose checksums don't match their data.
+ */
+void MainWindow::warnAboutInvalidChecksums() {
+    SaveManager* saveManager = SaveManager::getInstance();
+
+    if (!saveManager->hasInvalidSaveSlots()) {
+        return;
+    }
+
+    QStringList invalidSlots;
+
+    for (int i = 0; i < NUM_SAVES; i++) {
+        if (saveManager->getSaveSlotStatus(i).mainSave == SaveManager::CHECKSUM_STATUS_INVALID) {
+            invalidSlots.append(QString::number(i + 1));
+        }
+    }
+
+    QMessageBox::warning(this, "Warning", "The checksums of the following save slots don't match their data: " + invalidSlots.join(", ") + ".\n"
+                                          "These saves may be corrupted. Their checksums will be recalculated when saving the file.");
+}
+
 /// Given a framecount (in 30fps), converts it from frames to hours, minutes and seconds
 void MainWindow::convertFrameToTime(const unsigned int frameCount, QLabel* output) {
     int totalSeconds = frameCount / 30;
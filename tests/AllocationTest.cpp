@@ -0,0 +1,170 @@
+/**
+ * @file AllocationTest.cpp
+ * @brief Checks that decoding and encoding save slots never allocates memory
+ *
+ * Every global "operator new" is replaced with one that counts the allocations made while counting is enabled.
+ * The save slots of every region are then decoded, encoded and checksummed many times through the caller-owned
+ * buffer API of the file loaders (see "FileLoader::decodeSaveSlot()"), and the test fails if any allocation was made.
+ * The time taken for each save slot is shown as well.
+ *
+ * It's built by ppp-test-alloc.pro, and run along with the other tests with "make check".
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/file/FileLoader.h"
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    constexpr unsigned int NUM_ITERATIONS = 200000;    /**< Times each region's save slots are decoded and encoded */
+
+    std::atomic<bool> isCounting{false};
+    std::atomic<unsigned long long> numAllocations{0};
+    volatile unsigned int checksumSink = 0;    /**< Keeps the work from being optimized away */
+
+    void* allocate(const std::size_t size) {
+        if (isCounting.load(std::memory_order_relaxed)) {
+            numAllocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void* ptr = std::malloc((size != 0) ? size : 1);
+
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return ptr;
+    }
+
+    void* allocateNoThrow(const std::size_t size) noexcept {
+        try {
+            return allocate(size);
+        }
+        catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Decodes, encodes and checksums a whole save (every slot, as stored in a note) "NUM_ITERATIONS" times,
+     * through both the static entry points and the ones of a loader with the region's codec selected.
+     *
+     * @return The number of allocations made.
+     */
+    unsigned long long runRegion(const short region, double& nsPerSaveSlot) {
+        FileLoaderNote loader(FormatDescriptors::NOTE);
+        const unsigned int stride = loader.getSaveSlotPaddedSize();
+        char saveSlotsData[FormatDescriptors::NOTE.saveSlotPaddedSize * NUM_SAVES] = {};
+        SaveSlot saveSlots[NUM_SAVES];
+        unsigned int checksumSum = 0;
+
+        // Start from valid save slots
+        for (unsigned int i = 0; i < NUM_SAVES; i++) {
+            saveSlots[i].assignDefaultValues();
+            saveSlots[i].mainSave.gold = i * 1000;
+            FileLoader::encodeSaveSlot(saveSlotsData + (stride * i), saveSlots[i], region);
+        }
+
+        FileLoader::writeSaveSlotChecksums(saveSlotsData, stride, NUM_SAVES, region);
+        loader.selectSlotCodec(region);
+
+        QElapsedTimer timer;
+        numAllocations = 0;
+        isCounting = true;
+        timer.start();
+
+        for (unsigned int iteration = 0; iteration < NUM_ITERATIONS; iteration++) {
+            for (unsigned int i = 0; i < NUM_SAVES; i++) {
+                char* slotData = saveSlotsData + (stride * i);
+
+                if ((iteration % 2) == 0) {
+                    FileLoader::decodeSaveSlot(QByteArrayView(slotData, stride), saveSlots[i], region);
+                    saveSlots[i].mainSave.gameplay_framecount++;
+                    FileLoader::encodeSaveSlot(slotData, saveSlots[i], region);
+                }
+                else {
+                    loader.readSaveSlot(QByteArrayView(slotData, stride), saveSlots[i]);
+                    saveSlots[i].mainSave.gameplay_framecount++;
+                    loader.encodeSaveSlot(slotData, saveSlots[i]);
+                }
+            }
+
+            FileLoader::writeSaveSlotChecksums(saveSlotsData, stride, NUM_SAVES, region);
+            checksumSum += saveSlots[iteration % NUM_SAVES].checksum1;
+        }
+
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        isCounting = false;
+
+        nsPerSaveSlot = static_cast<double>(elapsedNs) / (static_cast<double>(NUM_ITERATIONS) * NUM_SAVES);
+        checksumSink = checksumSum;
+
+        return numAllocations;
+    }
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocateNoThrow(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+int main() {
+    const struct {
+        short region;
+        const char* name;
+    } regions[] = {
+        {SaveData::USA, "USA"},
+        {SaveData::JPN, "JPN"},
+        {SaveData::PAL, "PAL"}
+    };
+
+    int result = EXIT_SUCCESS;
+
+    for (const auto& region: regions) {
+        double nsPerSaveSlot = 0;
+        const unsigned long long allocations = runRegion(region.region, nsPerSaveSlot);
+
+        printf("%s: %llu allocations, %.1f ns per save slot (decode + encode + checksums)\n", region.name, allocations, nsPerSaveSlot);
+
+        if (allocations != 0) {
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if (result != EXIT_SUCCESS) {
+        printf("FAIL: decoding and encoding save slots must not allocate memory\n");
+    }
+
+    return result;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file SlotCodecTest.cpp
+ * @brief Checks the save slot codec of every region against the original field-by-field reader and writer
+ *
+ * "ReferenceCodec" is the way save slots were read and written before the region codecs (see SlotCodec.h) were
+ * added: every field is read from (or written to) a QDataStream one at a time, in big endian, with the two extra
+ * PAL fields only present in PAL files. For every region, random save slots are decoded and encoded with both,
+ * and the test fails if the decoded save slots or the encoded bytes are different, or if encoding a decoded save
+ * slot doesn't give back the original bytes.
+ *
+ * Both are then timed over the same save slots, to show how much faster the region codecs are.
+ *
+ * It's built by ppp-test-slotcodec.pro, and run along with the other tests with "make check".
+ *
+ * @author Moisés Antonio Pestano Castro
+ */
+
+#include "include/save/SlotCodec.h"
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace ReferenceCodec {
+    /**
+     * Reads a value of type T at the current position of the input stream.
+     */
+    template<typename T>
+    T readData(QDataStream& inputStream) {
+        T value;
+        inputStream.readRawData(reinterpret_cast<char*>(&value), sizeof(T));
+
+        return qFromBigEndian(value);
+    }
+
+    /**
+     * Writes a value of type T at the current position of the output stream.
+     */
+    template<typename T>
+    void writeData(QDataStream& outputStream, T value) {
+        T bigEndianValue = qToBigEndian(value);
+        outputStream.writeRawData(reinterpret_cast<char*>(&bigEndianValue), sizeof(T));
+    }
+
+    void readSaveData(QDataStream& inputStream, const short region, SaveData& saveData) {
+        for (unsigned int i = 0; i < NUM_EVENT_FLAGS; i++) {
+            saveData.event_flags[i] = readData<unsigned int>(inputStream);
+        }
+        saveData.flags = readData<unsigned int>(inputStream);
+
+        saveData.week = readData<short>(inputStream);
+        saveData.day = readData<short>(inputStream);
+        saveData.hour = readData<short>(inputStream);
+        saveData.minute = readData<short>(inputStream);
+        saveData.seconds = readData<short>(inputStream);
+        saveData.milliseconds = readData<unsigned short>(inputStream);
+        saveData.gameplay_framecount = readData<unsigned int>(inputStream);
+
+        saveData.button_config = readData<short>(inputStream);
+        saveData.sound_mode = readData<short>(inputStream);
+
+        // PAL-exclusive data
+        if (region == SaveData::PAL) {
+            saveData.language = readData<short>(inputStream);
+            saveData.padding5A_PAL = readData<short>(inputStream);
+        }
+
+        saveData.character = readData<short>(inputStream);
+        saveData.life = readData<short>(inputStream);
+        saveData.field_0x5C = readData<short>(inputStream);
+        saveData.subweapon = readData<short>(inputStream);
+        saveData.gold = readData<unsigned int>(inputStream);
+
+        for (unsigned int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
+            saveData.items[j] = readData<unsigned char>(inputStream);
+        }
+
+        saveData.player_status = readData<unsigned int>(inputStream);
+        saveData.health_depletion_rate_while_poisoned = readData<short>(inputStream);
+
+        saveData.current_hour_VAMP = readData<unsigned short>(inputStream);
+        saveData.map = readData<short>(inputStream);
+        saveData.spawn = readData<short>(inputStream);
+        saveData.save_crystal_number = readData<unsigned short>(inputStream);
+
+        saveData.field51_0xb2 = readData<unsigned char>(inputStream);
+        saveData.field52_0xb3 = readData<unsigned char>(inputStream);
+
+        saveData.time_saved_counter = readData<unsigned int>(inputStream);
+        saveData.death_counter = readData<unsigned int>(inputStream);
+
+        saveData.field55_0xbc = readData<int>(inputStream);
+        saveData.field59_0xc0 = readData<int>(inputStream);
+        saveData.field63_0xc4 = readData<int>(inputStream);
+        saveData.field67_0xc8 = readData<short>(inputStream);
+        saveData.field69_0xca = readData<short>(inputStream);
+        saveData.field71_0xcc = readData<int>(inputStream);
+        saveData.field75_0xd0 = readData<int>(inputStream);
+        saveData.field77_0xd2 = readData<short>(inputStream);
+        saveData.field79_0xd4 = readData<short>(inputStream);
+        saveData.field83_0xd8 = readData<int>(inputStream);
+        saveData.gold_spent_on_Renon = readData<unsigned int>(inputStream);
+    }
+
+    void writeSaveData(QDataStream& outputStream, const short region, const SaveData& saveData) {
+        for (unsigned int i = 0; i < NUM_EVENT_FLAGS; i++) {
+            writeData<unsigned int>(outputStream, saveData.event_flags[i]);
+        }
+
+        writeData<unsigned int>(outputStream, saveData.flags);
+        writeData<short>(outputStream, saveData.week);
+        writeData<short>(outputStream, saveData.day);
+        writeData<short>(outputStream, saveData.hour);
+        writeData<short>(outputStream, saveData.minute);
+        writeData<short>(outputStream, saveData.seconds);
+        writeData<unsigned short>(outputStream, saveData.milliseconds);
+        writeData<unsigned int>(outputStream, saveData.gameplay_framecount);
+        writeData<short>(outputStream, saveData.button_config);
+        writeData<short>(outputStream, saveData.sound_mode);
+
+        // PAL-exclusive data
+        if (region == SaveData::PAL) {
+            writeData<short>(outputStream, saveData.language);
+            writeData<short>(outputStream, saveData.padding5A_PAL);
+        }
+
+        writeData<short>(outputStream, saveData.character);
+        writeData<short>(outputStream, saveData.life);
+        writeData<short>(outputStream, saveData.field_0x5C);
+        writeData<short>(outputStream, saveData.subweapon);
+        writeData<unsigned int>(outputStream, saveData.gold);
+
+        for (unsigned int j = 0; j < SIZE_ITEMS_ARRAY; j++) {
+            writeData<unsigned char>(outputStream, saveData.items[j]);
+        }
+
+        writeData<unsigned int>(outputStream, saveData.player_status);
+        writeData<short>(outputStream, saveData.health_depletion_rate_while_poisoned);
+        writeData<unsigned short>(outputStream, saveData.current_hour_VAMP);
+        writeData<short>(outputStream, saveData.map);
+        writeData<short>(outputStream, saveData.spawn);
+        writeData<unsigned short>(outputStream, saveData.save_crystal_number);
+        writeData<unsigned char>(outputStream, saveData.field51_0xb2);
+        writeData<unsigned char>(outputStream, saveData.field52_0xb3);
+        writeData<unsigned int>(outputStream, saveData.time_saved_counter);
+        writeData<unsigned int>(outputStream, saveData.death_counter);
+        writeData<int>(outputStream, saveData.field55_0xbc);
+        writeData<int>(outputStream, saveData.field59_0xc0);
+        writeData<int>(outputStream, saveData.field63_0xc4);
+        writeData<short>(outputStream, saveData.field67_0xc8);
+        writeData<short>(outputStream, saveData.field69_0xca);
+        writeData<int>(outputStream, saveData.field71_0xcc);
+        writeData<int>(outputStream, saveData.field75_0xd0);
+        writeData<short>(outputStream, saveData.field77_0xd2);
+        writeData<short>(outputStream, saveData.field79_0xd4);
+        writeData<int>(outputStream, saveData.field83_0xd8);
+        writeData<unsigned int>(outputStream, saveData.gold_spent_on_Renon);
+    }
+
+    /**
+     * @return The number of bytes read.
+     */
+    qint64 readSaveSlot(QByteArray& rawData, const short region, SaveSlot& slot) {
+        QBuffer buffer(&rawData);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream inputStream(&buffer);
+
+        readSaveData(inputStream, region, slot.mainSave);
+        readSaveData(inputStream, region, slot.beginningOfStage);
+        slot.checksum1 = readData<unsigned int>(inputStream);
+        slot.checksum2 = readData<unsigned int>(inputStream);
+
+        return buffer.pos();
+    }
+
+    /**
+     * @return The number of bytes written.
+     */
+    qint64 writeSaveSlot(QByteArray& rawData, const short region, const SaveSlot& slot) {
+        QBuffer buffer(&rawData);
+        buffer.open(QIODevice::WriteOnly);
+        QDataStream outputStream(&buffer);
+
+        writeSaveData(outputStream, region, slot.mainSave);
+        writeSaveData(outputStream, region, slot.beginningOfStage);
+        writeData<unsigned int>(outputStream, slot.checksum1);
+        writeData<unsigned int>(outputStream, slot.checksum2);
+
+        return buffer.pos();
+    }
+}
+
+namespace {
+    constexpr unsigned int NUM_RANDOM_SLOTS = 1000;     /**< Random save slots checked for each region */
+    constexpr unsigned int NUM_BENCH_ITERATIONS = 50;   /**< Times every random save slot is decoded and encoded when timing */
+
+    volatile unsigned int checksumSink = 0;    /**< Keeps the timed work from being optimized away */
+
+    /**
+     * @brief Compares both codecs of the given region over "NUM_RANDOM_SLOTS" random save slots.
+     *
+     * @return The number of save slots where they didn't match.
+     */
+    unsigned int checkRegion(const short region, const char* regionName, const std::vector<QByteArray>& slotsData) {
+        const SlotCodecTable& codec = SlotCodecTable::get(region);
+        unsigned int numErrors = 0;
+
+        for (unsigned int i = 0; i < slotsData.size(); i++) {
+            QByteArray referenceData = slotsData[i];
+            SaveSlot referenceSlot;
+            SaveSlot codecSlot;
+
+            // Zero the padding as well, so both save slots can be compared byte by byte
+            memset(static_cast<void*>(&referenceSlot), 0, sizeof(referenceSlot));
+            memset(static_cast<void*>(&codecSlot), 0, sizeof(codecSlot));
+
+            const qint64 bytesRead = ReferenceCodec::readSaveSlot(referenceData, region, referenceSlot);
+            codec.decodeSaveSlot(slotsData[i].constData(), codecSlot);
+
+            if (bytesRead != codec.saveSlotSize) {
+                printf("%s: the reference codec read %lld bytes, but a save slot is %u bytes long\n", regionName, bytesRead, codec.saveSlotSize);
+                return numErrors + 1;
+            }
+
+            if (memcmp(&referenceSlot, &codecSlot, sizeof(SaveSlot)) != 0) {
+                printf("%s: save slot %u was decoded differently\n", regionName, i);
+                numErrors++;
+                continue;
+            }
+
+            QByteArray encodedReference(codec.saveSlotSize, 0);
+            QByteArray encodedCodec(codec.saveSlotSize, 0);
+            ReferenceCodec::writeSaveSlot(encodedReference, region, referenceSlot);
+            codec.encodeSaveSlot(codecSlot, encodedCodec.data());
+
+            if (encodedReference != encodedCodec) {
+                printf("%s: save slot %u was encoded differently\n", regionName, i);
+                numErrors++;
+            }
+            else if (encodedCodec != slotsData[i]) {
+                printf("%s: save slot %u didn't encode back to its original bytes\n", regionName, i);
+                numErrors++;
+            }
+        }
+
+        return numErrors;
+    }
+
+    /**
+     * @brief Times decoding and encoding the given save slots "NUM_BENCH_ITERATIONS" times with both codecs.
+     */
+    void benchRegion(const short region, const char* regionName, std::vector<QByteArray>& slotsData) {
+        const SlotCodecTable& codec = SlotCodecTable::get(region);
+        const double numSlots = static_cast<double>(NUM_BENCH_ITERATIONS) * slotsData.size();
+        QByteArray encodedData(codec.saveSlotSize, 0);
+        SaveSlot slot;
+        unsigned int checksumSum = 0;
+        QElapsedTimer timer;
+
+        timer.start();
+
+        for (unsigned int iteration = 0; iteration < NUM_BENCH_ITERATIONS; iteration++) {
+            for (QByteArray& slotData: slotsData) {
+                ReferenceCodec::readSaveSlot(slotData, region, slot);
+                ReferenceCodec::writeSaveSlot(encodedData, region, slot);
+                checksumSum += slot.checksum1;
+            }
+        }
+
+        const double referenceNs = timer.nsecsElapsed() / numSlots;
+        timer.restart();
+
+        for (unsigned int iteration = 0; iteration < NUM_BENCH_ITERATIONS; iteration++) {
+            for (const QByteArray& slotData: slotsData) {
+                codec.decodeSaveSlot(slotData.constData(), slot);
+                codec.encodeSaveSlot(slot, encodedData.data());
+                checksumSum += slot.checksum1;
+            }
+        }
+
+        const double codecNs = timer.nsecsElapsed() / numSlots;
+        checksumSink = checksumSum;
+
+        printf("%s: reference %.1f ns, codec %.1f ns per save slot (decode + encode), %.1fx faster\n",
+               regionName, referenceNs, codecNs, (codecNs > 0) ? (referenceNs / codecNs) : 0.0);
+    }
+}
+
+int main() {
+    const struct {
+        short region;
+        const char* name;
+    } regions[] = {
+        {SaveData::USA, "USA"},
+        {SaveData::JPN, "JPN"},
+        {SaveData::PAL, "PAL"}
+    };
+
+    // Fixed seed, so any failure can be reproduced
+    std::mt19937 randomGenerator(0x43563634);
+    unsigned int numErrors = 0;
+
+    for (const auto& region: regions) {
+        std::vector<QByteArray> slotsData(NUM_RANDOM_SLOTS, QByteArray(SlotCodecTable::get(region.region).saveSlotSize, 0));
+
+        for (QByteArray& slotData: slotsData) {
+            for (qsizetype i = 0; i < slotData.size(); i++) {
+                slotData[i] = static_cast<char>(randomGenerator() & 0xFF);
+            }
+        }
+
+        const unsigned int regionErrors = checkRegion(region.region, region.name, slotsData);
+        printf("%s: %u of %u save slots matched the reference codec\n", region.name, NUM_RANDOM_SLOTS - regionErrors, NUM_RANDOM_SLOTS);
+        numErrors += regionErrors;
+
+        benchRegion(region.region, region.name, slotsData);
+    }
+
+    if (numErrors != 0) {
+        printf("FAIL: the save slot codecs don't match the reference codec\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}